@@ -13,16 +13,26 @@ classdef polyhedron < cppinterface
     %
     % polyhedron(p) creates a new which is a copy of an existing polyhedron
     % (or derived class) providede in 'p'.
+    % The copy is cheap, the geometry is shared by the two polyhedra and
+    % only duplicated when one of them is modified.
     %
     %
     % polyhedron Methods:
     %   makeextrusion
+    %   make_extrusion_region
+    %   make_sweep
+    %   make_convex_hull
     %   make_surface_of_revolution
     %   makebox
     %   makecylinder
     %   makesphere
     %   makecone
     %   maketorus
+    %   make_surface_of_revolution_tol
+    %   makecylinder_tol
+    %   makesphere_tol
+    %   makecone_tol
+    %   maketorus_tol
     %   render
     %   union
     %   difference
@@ -38,7 +48,36 @@ classdef polyhedron < cppinterface
     %   get_vertices
     %   get_vertex
     %   get_face_vertices
+    %   get_patch_data
+    %   get_edges
+    %   get_face_adjacency
+    %   is_manifold
     %   triangulate
+    %   simplify
+    %   offset
+    %   shell
+    %   num_components
+    %   split_components
+    %   voxelize
+    %   hausdorff
+    %   approx_equal
+    %   quality_report
+    %   serialize
+    %   deserialize
+    %   binwrite
+    %   binread
+    %
+    % polyhedron Static Methods:
+    %   progress_interval
+    %   stats
+    %   reset_stats
+    %   set_backend
+    %   export_bodies
+    %   interference
+    %   boolean_batch
+    %   set_workers
+    %   trace
+    %   trace_dump
     %
 
     methods
@@ -102,6 +141,94 @@ classdef polyhedron < cppinterface
             
         end
         
+        function [faces, vertices, normals] = get_patch_data (this)
+            % returns the geometry in the form used by patch
+            %
+            % Syntax
+            %
+            % [faces, vertices] = polyhedron/get_patch_data ()
+            % [faces, vertices, normals] = polyhedron/get_patch_data ()
+            %
+            % Output
+            %
+            %  faces - (n x m) matrix of 1-based vertex indices, padded with NaN
+            %
+            %  vertices - (p x 3) matrix of the vertex coordinates
+            %
+            %  normals - (p x 3) matrix of the unit vertex normals
+            %
+            
+            if nargout > 2
+                [faces, vertices, normals] = this.cppcall ('get_patch_data');
+            else
+                [faces, vertices] = this.cppcall ('get_patch_data');
+            end
+            
+        end
+        
+        function [edges, nfaces] = get_edges (this)
+            % returns every edge of the polyhedron
+            %
+            % Syntax
+            %
+            % edges = polyhedron/get_edges ()
+            % [edges, nfaces] = polyhedron/get_edges ()
+            %
+            % Output
+            %
+            %  edges - (n x 2) matrix of 1-based vertex indices, sorted
+            %
+            %  nfaces - (n x 1) vector of the number of faces using each edge
+            %
+            
+            if nargout > 1
+                [edges, nfaces] = this.cppcall ('get_edges');
+            else
+                edges = this.cppcall ('get_edges');
+            end
+            
+        end
+        
+        function neighbours = get_face_adjacency (this)
+            % returns the faces adjacent to each face
+            %
+            % Syntax
+            %
+            % neighbours = polyhedron/get_face_adjacency ()
+            %
+            % Output
+            %
+            %  neighbours - matrix the size of the faces from get_patch_data, the
+            %    face across the edge from vertex k to k+1 of face i, or 0
+            %
+            
+            neighbours = this.cppcall ('get_face_adjacency');
+            
+        end
+        
+        function [tf, closed] = is_manifold (this)
+            % test whether the surface of the polyhedron is manifold
+            %
+            % Syntax
+            %
+            % tf = polyhedron/is_manifold ()
+            % [tf, closed] = polyhedron/is_manifold ()
+            %
+            % Output
+            %
+            %  tf - true if the surface is manifold and consistently oriented
+            %
+            %  closed - true if it is also free of boundary edges
+            %
+            
+            if nargout > 1
+                [tf, closed] = this.cppcall ('is_manifold');
+            else
+                tf = this.cppcall ('is_manifold');
+            end
+            
+        end
+        
         function verts = get_vertices (this)
             % returns all the vertices from the polyhedron
             
@@ -135,6 +262,88 @@ classdef polyhedron < cppinterface
               
         end
         
+        function make_extrusion_region (this, distance, loops)
+            % create a solid by extruding a region bounded by many loops
+            %
+            % Syntax
+            %
+            % polyhedron/make_extrusion_region (distance, loops)
+            %
+            % Input
+            %
+            %  distance - extrusion distance along z
+            %
+            %  loops - cell array of (n x 2) matrices of loop coordinates, or one
+            %    matrix with the loops separated by rows of NaN. Loops inside an odd
+            %    number of others are holes.
+            %
+            
+            this.cppcall ('extrude_loops', csg.polyhedron.split_loops (loops), distance);
+            
+        end
+        
+        function make_sweep (this, profile, path, normal)
+            % create a solid by sweeping a profile along a 3D path
+            %
+            % Syntax
+            %
+            % polyhedron/make_sweep (profile, path)
+            % polyhedron/make_sweep (profile, path, normal)
+            %
+            % Input
+            %
+            %  profile - loops in the u-v plane, as for make_extrusion_region
+            %
+            %  path - (n x 3) matrix of path points, closed if the last is the first
+            %
+            %  normal - optional, direction of the profile u axis at the start
+            %
+            
+            if nargin < 4
+                this.cppcall ('sweep', csg.polyhedron.split_loops (profile), path);
+            else
+                this.cppcall ('sweep', csg.polyhedron.split_loops (profile), path, normal);
+            end
+            
+        end
+        
+        function make_convex_hull (this, varargin)
+            % create the convex hull of sets of points and polyhedra
+            %
+            % Syntax
+            %
+            % polyhedron/make_convex_hull (p1, p2, ...)
+            %
+            % Input
+            %
+            %  p1, p2, ... - (n x 3) matrices of points, polyhedra, or cell arrays of
+            %    polyhedra
+            %
+            
+            args = {};
+            
+            for ind = 1:numel (varargin)
+                
+                arg = varargin{ind};
+                
+                if ~iscell (arg)
+                    arg = {arg};
+                end
+                
+                for cind = 1:numel (arg)
+                    if isnumeric (arg{cind})
+                        args{end+1} = double (arg{cind});
+                    else
+                        args{end+1} = arg{cind}.objectHandle;
+                    end
+                end
+                
+            end
+            
+            this.cppcall ('convex_hull', args{:});
+            
+        end
+        
         % shapes
         function extrude_rotate (this, distance, segments, dTheta, nodes, links)
             % create solid from extruded polygon
@@ -246,6 +455,68 @@ classdef polyhedron < cppinterface
             this.cppcall ('makesphere', adius_major, radius_minor, is_centered, major_segments, minor_segments);
               
         end
+        
+        % shapes with segments chosen from a tolerance
+        %
+        % The following methods create the same shapes as their
+        % counterparts above, but rather than taking the number of
+        % segments, they take the maximum permitted distance, tol, between
+        % the true curved surface and the flat faces approximating it.
+        % The number of segments for each curved direction is then chosen
+        % from the radius, so small features get few faces and large ones
+        % get as many as needed for the same accuracy.
+        
+        function make_surface_of_revolution_tol (this, nodes, links, tol, angle)
+            
+            if nargin < 5
+                angle = 2 * pi;
+            end
+            
+            angle = rad2deg (angle);
+            
+            this.cppcall ('surface_of_revolution_tol', nodes, links, angle, tol);
+            
+        end
+        
+        function makesphere_tol (this, radius, tol, is_centered)
+        
+            if nargin < 4
+                is_centered = 1;
+            end
+            
+            this.cppcall ('makesphere_tol', radius, is_centered, tol);
+              
+        end
+
+        function makecylinder_tol (this, radius, height, tol, is_centered)
+        
+            if nargin < 5
+                is_centered = 1;
+            end
+            
+            this.cppcall ('makecylinder_tol', radius, height, is_centered, tol);
+              
+        end
+
+        function makecone_tol (this, radius, height, tol, is_centered)
+        
+            if nargin < 5
+                is_centered = 1;
+            end
+            
+            this.cppcall ('makecone_tol', radius, height, is_centered, tol);
+              
+        end
+
+        function maketorus_tol (this, radius_major, radius_minor, tol, is_centered)
+        
+            if nargin < 5
+                is_centered = 1;
+            end
+            
+            this.cppcall ('maketorus_tol', radius_major, radius_minor, is_centered, tol);
+              
+        end
 
         
         % modifications
@@ -299,21 +570,42 @@ classdef polyhedron < cppinterface
         end
         
         % Boolean operations
-        function union (this, other)
+        function union (this, other, backend)
+            % union with another polyhedron, optionally choosing how the
+            % CSG kernel is used, 'fast', 'robust' or 'auto', see
+            % set_backend. The default is the global backend.
         
-            this.cppcall ('csgunion', other.objectHandle);
+            if nargin < 3
+                this.cppcall ('csgunion', other.objectHandle);
+            else
+                this.cppcall ('csgunion', other.objectHandle, backend);
+            end
             
         end
         
-        function difference (this, other)
+        function difference (this, other, backend)
+            % difference with another polyhedron, optionally choosing how the
+            % CSG kernel is used, 'fast', 'robust' or 'auto', see
+            % set_backend. The default is the global backend.
         
-            this.cppcall ('csgdifference', other.objectHandle);
+            if nargin < 3
+                this.cppcall ('csgdifference', other.objectHandle);
+            else
+                this.cppcall ('csgdifference', other.objectHandle, backend);
+            end
             
         end
         
-        function symmetric_difference (this, other)
+        function symmetric_difference (this, other, backend)
+            % symmetric difference with another polyhedron, optionally choosing how the
+            % CSG kernel is used, 'fast', 'robust' or 'auto', see
+            % set_backend. The default is the global backend.
         
-            this.cppcall ('csgsymmdifference', other.objectHandle);
+            if nargin < 3
+                this.cppcall ('csgsymmdifference', other.objectHandle);
+            else
+                this.cppcall ('csgsymmdifference', other.objectHandle, backend);
+            end
             
         end
         
@@ -345,107 +637,390 @@ classdef polyhedron < cppinterface
             end 
         end
         
-        % Operators
-        function r = plus (a, b)
-        
-            % create a deep copy of the first input
-            r = csg.polyhedron (a);
-            % union it with the second
-            r.union (b);
-        
+        function simplify (this, target_faces, max_error)
+            % reduce the number of faces in the polyhedron by edge collapses
+            %
+            % Syntax
+            %
+            % polyhedron/simplify (target_faces)
+            % polyhedron/simplify (target_faces, max_error)
+            %
+            % Input
+            %
+            %  target_faces - the desired number of faces
+            %
+            %  max_error - optional, stop before a collapse with a larger quadric
+            %    error (a distance). Default is Inf.
+            %
+            
+            if nargin < 3
+                max_error = inf;
+            end
+            
+            this.cppcall ('simplify', target_faces, max_error);
+            
         end
         
-        function r = minus (a, b)
+        function offset (this, distance)
+            % move the surface of the polyhedron along its normals
+            %
+            % Syntax
+            %
+            % polyhedron/offset (distance)
+            %
+            % Input
+            %
+            %  distance - the distance to move each face, outwards if positive
+            %
             
-            % create a deep copy of the first input
-            r = csg.polyhedron (a);
-            % difference it with the second
-            r.difference (b);
+            this.cppcall ('offset', distance);
             
         end
         
-        % Drawing
-        function render (this, pretty)
-            % plot the polyhedron
+        function shell (this, thickness)
+            % hollow out the polyhedron, leaving walls of a given thickness
             %
             % Syntax
             %
-            % polyhedron/render ()
-            % polyhedron/render (pretty)
+            % polyhedron/shell (thickness)
             %
             % Input
             %
-            %  pretty - optional flag, if true, edges will not be drawn and
-            %    lighting added. Default is false
+            %  thickness - wall thickness, inside the surface if positive
             %
-        
-            if nargin < 2
-                pretty = false;
-            end
             
-            hfig = figure;
-            hax = axes;
+            this.cppcall ('shell', thickness);
             
-            n = this.num_faces ();
+        end
+        
+        function n = num_components (this)
+            % number of disconnected bodies making up the polyhedron
+            %
+            % Syntax
+            %
+            % n = polyhedron/num_components ()
+            %
             
-            for face_id = 0:n-1
+            n = this.cppcall ('num_components');
             
-                facecoords = [];
-                
-                verts = this.get_face_vertices (face_id);
-                
-                for indii = 1:numel(verts)
-                
-                    facecoords = [ facecoords; this.get_vertex(verts(indii)) ];
-                
-                end
-                
-                if pretty
-                    % draw the patch 
-                    p = patch ( facecoords(:,1), ...
-                                facecoords(:,2), ...
-                                facecoords(:,3), 'r');
-
-                    set (p, 'EdgeColor','none');
-                    
-                else
-                    % draw the patch 
-                    patch ( facecoords(:,1), ...
-                            facecoords(:,2), ...
-                            facecoords(:,3), ...
-                            'r' );
-                end
+        end
+        
+        function parts = split_components (this)
+            % split the polyhedron into its disconnected bodies
+            %
+            % Syntax
+            %
+            % parts = polyhedron/split_components ()
+            %
+            % Output
+            %
+            %  parts - cell array of new polyhedra, one per body
+            %
             
-            end
+            % the mexfunction returns handles to new objects, the
+            % polyhedra take over their geometry, which is not copied
+            handles = this.cppcall ('split_components');
             
-            view(3);
-            axis equal;
-            if pretty, light; end
-            xlabel ('x');
-            ylabel ('y');
-            zlabel ('z');
+            parts = csg.polyhedron.from_handles (handles);
             
-        
         end
         
-        
-        function stlwrite (this, filename)
-            % triangulate and write out polyhedron to stl file
-            % 
+        function vox = voxelize (this, origin, spacing, dims, supersample, block_size)
+            % rasterise the polyhedron onto a regular grid of voxels
+            %
             % Syntax
             %
-            % polyhedron/stlwrite (filename)
+            % vox = polyhedron/voxelize (origin, spacing, dims)
+            % vox = polyhedron/voxelize (origin, spacing, dims, supersample)
+            % vox = polyhedron/voxelize (origin, spacing, dims, supersample, block_size)
+            %
+            % Input
+            %
+            %  origin - (1 x 3) lowest corner of the grid
+            %
+            %  spacing - voxel size, scalar or (1 x 3)
+            %
+            %  dims - (1 x 3) number of voxels along x, y and z
+            %
+            %  supersample - optional, 0 for inside tests at the voxel centres, the
+            %    default, otherwise volume fractions from supersample^2 rays per voxel
+            %
+            %  block_size - optional, if positive return sparse blocks. Default is 0.
+            %
+            % Output
+            %
+            %  vox - logical or single array of size dims, or with a block size a
+            %    structure with fields dims, block_size, full, partial and values
             %
             
-            [fv.vertices, fv.faces] = this.triangulate ();
-            fv.faces = fv.faces + 1;
-
-            csg.stlwrite(filename,fv);
-        
+            if nargin < 5
+                supersample = 0;
+            end
+            
+            if nargin < 6
+                block_size = 0;
+            end
+            
+            vox = this.cppcall ('voxelize', origin, spacing, dims, supersample, block_size);
+            
         end
         
-        function objwrite (this, filename)
-            % write the polyhedron to an obj file
+        % Comparison
+        function [dmax, dmean, drms] = hausdorff (this, other, samples)
+            % distance between the surfaces of two polyhedra
+            %
+            % Syntax
+            %
+            % dmax = polyhedron/hausdorff (other)
+            % dmax = polyhedron/hausdorff (other, samples)
+            % [dmax, dmean, drms] = polyhedron/hausdorff (...)
+            %
+            % Input
+            %
+            %  other - csg.polyhedron object to compare with
+            %
+            %  samples - optional, points sampled per surface. Default is 10000.
+            %
+            % Output
+            %
+            %  dmax, dmean, drms - the sampled Hausdorff, mean and rms distances
+            %
+            
+            if nargin < 3
+                args = {};
+            else
+                args = {samples};
+            end
+            
+            [dmax, dmean, drms] = this.cppcall ('hausdorff', other.objectHandle, args{:});
+            
+        end
+        
+        function tf = approx_equal (this, other, tol, samples)
+            % whether two polyhedra have the same shape to within a tolerance
+            %
+            % Syntax
+            %
+            % tf = polyhedron/approx_equal (other, tol)
+            % tf = polyhedron/approx_equal (other, tol, samples)
+            %
+            % Input
+            %
+            %  other - csg.polyhedron object to compare with
+            %
+            %  tol - the largest distance allowed between the surfaces
+            %
+            %  samples - optional, as for hausdorff
+            %
+            % Output
+            %
+            %  tf - true if the sampled Hausdorff distance is at most tol
+            %
+            
+            if nargin < 4
+                args = {};
+            else
+                args = {samples};
+            end
+            
+            tf = this.cppcall ('approx_equal', other.objectHandle, tol, args{:});
+            
+        end
+        
+        function report = quality_report (this, nbins, sliver_angle)
+            % measures of the surface's fitness for tetrahedral meshing
+            %
+            % Syntax
+            %
+            % report = polyhedron/quality_report ()
+            % report = polyhedron/quality_report (nbins, sliver_angle)
+            %
+            % Input
+            %
+            %  nbins - optional, edge length histogram bins. Default is 10.
+            %
+            %  sliver_angle - optional, smallest angle of a sliver in degrees.
+            %    Default is 10.
+            %
+            % Output
+            %
+            %  report - structure of triangle angle, aspect ratio, sliver, edge
+            %    length and manifold defect counts
+            %
+            
+            args = {};
+            
+            if nargin > 1
+                args = {nbins};
+            end
+            
+            if nargin > 2
+                args = {nbins, sliver_angle};
+            end
+            
+            report = this.cppcall ('quality_report', args{:});
+            
+        end
+        
+        % Persistence
+        function blob = serialize (this, compress)
+            % encode the polyhedron geometry as a uint8 array
+            %
+            % Syntax
+            %
+            % blob = polyhedron/serialize ()
+            % blob = polyhedron/serialize (compress)
+            %
+            % Input
+            %
+            %  compress - optional, compress if supported. Default is false.
+            %
+            % Output
+            %
+            %  blob - uint8 row vector, see deserialize
+            %
+            
+            if nargin < 2
+                compress = false;
+            end
+            
+            blob = this.cppcall ('serialize', compress);
+            
+        end
+        
+        function deserialize (this, blob)
+            % replace the polyhedron geometry with that encoded by serialize
+            %
+            % Syntax
+            %
+            % polyhedron/deserialize (blob)
+            %
+            
+            this.cppcall ('deserialize', uint8 (blob));
+            
+        end
+        
+        function binwrite (this, filename, compress)
+            % write the polyhedron to a file in the binary format produced
+            % by serialize
+            %
+            % Syntax
+            %
+            % polyhedron/binwrite (filename)
+            % polyhedron/binwrite (filename, compress)
+            %
+            
+            if nargin < 3
+                compress = false;
+            end
+            
+            this.cppcall ('save_binary', filename, compress);
+            
+        end
+        
+        function binread (this, filename)
+            % replace the polyhedron geometry with the contents of a file
+            % written by binwrite
+            %
+            % Syntax
+            %
+            % polyhedron/binread (filename)
+            %
+            
+            this.cppcall ('load_binary', filename);
+            
+        end
+        
+        function s = saveobj (this)
+            % store the geometry rather than the handle to the C++ object
+            % when saved to a mat file
+            
+            s.mesh = this.serialize ();
+            
+        end
+        
+        % Operators
+        function r = plus (a, b)
+        
+            % create a copy of the first input, the geometry is shared 
+            % with a until one of them is modified
+            r = csg.polyhedron (a);
+            % union it with the second
+            r.union (b);
+        
+        end
+        
+        function r = minus (a, b)
+            
+            % create a copy of the first input, the geometry is shared 
+            % with a until one of them is modified
+            r = csg.polyhedron (a);
+            % difference it with the second
+            r.difference (b);
+            
+        end
+        
+        % Drawing
+        function render (this, pretty)
+            % plot the polyhedron
+            %
+            % Syntax
+            %
+            % polyhedron/render ()
+            % polyhedron/render (pretty)
+            %
+            % Input
+            %
+            %  pretty - optional flag, if true, edges will not be drawn and
+            %    lighting added. Default is false
+            %
+        
+            if nargin < 2
+                pretty = false;
+            end
+            
+            hfig = figure;
+            hax = axes;
+            
+            % draw all the faces as a single patch
+            [faces, vertices] = this.get_patch_data ();
+            
+            p = patch ( 'Faces', faces, ...
+                        'Vertices', vertices, ...
+                        'FaceColor', 'r' );
+            
+            if pretty
+                set (p, 'EdgeColor','none');
+            end
+            
+            view(3);
+            axis equal;
+            if pretty, light; end
+            xlabel ('x');
+            ylabel ('y');
+            zlabel ('z');
+            
+        
+        end
+        
+        
+        function stlwrite (this, filename)
+            % triangulate and write out polyhedron to stl file
+            % 
+            % Syntax
+            %
+            % polyhedron/stlwrite (filename)
+            %
+            
+            [fv.vertices, fv.faces] = this.triangulate ();
+            fv.faces = fv.faces + 1;
+
+            csg.stlwrite(filename,fv);
+        
+        end
+        
+        function objwrite (this, filename)
+            % write the polyhedron to an obj file
 
             fid = fopen(filename,'w');
             
@@ -625,6 +1200,367 @@ classdef polyhedron < cppinterface
         end
     
     end
+    
+    methods (Static)
+        
+        function this = loadobj (s)
+            % recreate the polyhedron from the geometry stored by saveobj
+            
+            this = csg.polyhedron ();
+            
+            if isstruct (s) && isfield (s, 'mesh')
+                this.deserialize (s.mesh);
+            end
+            
+        end
+        
+        function progress_interval (seconds)
+            % set how often long operations report their progress
+            %
+            % Syntax
+            %
+            % csg.polyhedron.progress_interval (seconds)
+            %
+            % Input
+            %
+            %  seconds - time between reports, 0 or inf for none. Default is 2.
+            %
+            
+            p = csg.polyhedron ();
+            p.cppcall ('progress_interval', seconds);
+            
+        end
+        
+        function s = stats ()
+            % timing and memory statistics of all operations so far
+            %
+            % Syntax
+            %
+            % s = csg.polyhedron.stats ()
+            %
+            % Output
+            %
+            %  s - structure array, one element per operation, with the fields
+            %    name, calls, total_time, max_time, mean_time, bytes_allocated,
+            %    faces_in and faces_out
+            %
+            
+            p = csg.polyhedron ();
+            s = p.cppcall ('stats');
+            
+        end
+        
+        function reset_stats ()
+            % clear the timing and memory statistics
+            %
+            % Syntax
+            %
+            % csg.polyhedron.reset_stats ()
+            %
+            
+            p = csg.polyhedron ();
+            p.cppcall ('reset_stats');
+            
+        end
+        
+        function [previous, previous_tolerance] = set_backend (backend, tolerance)
+            % choose how boolean operations use the CSG kernel
+            %
+            % Syntax
+            %
+            % previous = csg.polyhedron.set_backend (backend)
+            % [previous, previous_tolerance] = csg.polyhedron.set_backend (backend, tolerance)
+            % [current, current_tolerance] = csg.polyhedron.set_backend ()
+            %
+            % Input
+            %
+            %  backend - 'fast', 'robust' (snapped and merged input), 'auto' (fast,
+            %    then robust on failure, the default) or 'isolated' (auto in a worker
+            %    process, see set_workers), [] to keep the current one
+            %
+            %  tolerance - optional, snap grid of 'robust' relative to the operands'
+            %    size, 0 for none. Default is 1e-8.
+            %
+            % Output
+            %
+            %  previous, previous_tolerance - the settings before the call
+            %
+            
+            p = csg.polyhedron ();
+            
+            if nargin < 1
+                [previous, previous_tolerance] = p.cppcall ('set_backend');
+            else
+                if isempty (backend)
+                    backend = p.cppcall ('set_backend');
+                end
+                
+                if nargin < 2
+                    [previous, previous_tolerance] = p.cppcall ('set_backend', backend);
+                else
+                    [previous, previous_tolerance] = p.cppcall ('set_backend', backend, tolerance);
+                end
+            end
+            
+        end
+        
+        function export_bodies (filename, bodies, transforms, names, format)
+            % write several polyhedra to one file without combining them
+            %
+            % Syntax
+            %
+            % csg.polyhedron.export_bodies (filename, bodies)
+            % csg.polyhedron.export_bodies (filename, bodies, transforms, names, format)
+            %
+            % Input
+            %
+            %  filename - the file to write
+            %
+            %  bodies - cell array of csg.polyhedron objects
+            %
+            %  transforms - optional (4 x 4 x n) matrices applied as written
+            %
+            %  names - optional cell array of body names
+            %
+            %  format - optional, 'stl', 'stl_ascii', 'obj' or 'ply'. Default is
+            %    from the extension of filename.
+            %
+            
+            if nargin < 3
+                transforms = [];
+            end
+            
+            if nargin < 4
+                names = {};
+            end
+            
+            if nargin < 5
+                format = '';
+            end
+            
+            handles = cell (size (bodies));
+            
+            for ind = 1:numel (bodies)
+                handles{ind} = bodies{ind}.objectHandle;
+            end
+            
+            p = csg.polyhedron ();
+            p.cppcall ('export_bodies', filename, handles, double (transforms), names, format);
+            
+        end
+        
+        function [pairs, volumes, contained] = interference (parts, resolution)
+            % find which parts of an assembly clash, without booleans
+            %
+            % Syntax
+            %
+            % pairs = csg.polyhedron.interference (parts)
+            % [pairs, volumes, contained] = csg.polyhedron.interference (parts, resolution)
+            %
+            % Input
+            %
+            %  parts - cell array of csg.polyhedron objects
+            %
+            %  resolution - optional, voxels across each overlap. Default is 64.
+            %
+            % Output
+            %
+            %  pairs - (n x 2) indices of the parts which cross, sit flush or nest
+            %
+            %  volumes - (n x 1) estimated overlap volumes
+            %
+            %  contained - (n x 1) true where one part is inside the other
+            %
+            
+            args = {};
+            
+            if nargin > 1
+                args = {resolution};
+            end
+            
+            handles = cell (size (parts));
+            
+            for ind = 1:numel (parts)
+                handles{ind} = parts{ind}.objectHandle;
+            end
+            
+            p = csg.polyhedron ();
+            
+            % the volumes are only found when they are asked for
+            if nargout > 1
+                [pairs, volumes, contained] = p.cppcall ('interference', handles, args{:});
+            else
+                pairs = p.cppcall ('interference', handles, args{:});
+            end
+            
+        end
+        
+        function results = boolean_batch (op, A, B, backend)
+            % run many boolean operations in parallel in worker processes
+            %
+            % Syntax
+            %
+            % results = csg.polyhedron.boolean_batch (op, A, B)
+            % results = csg.polyhedron.boolean_batch (op, A, B, backend)
+            %
+            % Input
+            %
+            %  op - 'union', 'difference' or 'symmetric_difference'
+            %
+            %  A, B - cell arrays of the operands, the same size
+            %
+            %  backend - optional, 'fast', 'robust' or 'auto', see set_backend
+            %
+            % Output
+            %
+            %  results - cell array of new polyhedra, op applied to A{i} and B{i}
+            %
+            
+            handlesA = cell (size (A));
+            handlesB = cell (size (B));
+            
+            for ind = 1:numel (A)
+                handlesA{ind} = A{ind}.objectHandle;
+            end
+            
+            for ind = 1:numel (B)
+                handlesB{ind} = B{ind}.objectHandle;
+            end
+            
+            p = csg.polyhedron ();
+            
+            if nargin < 4
+                handles = p.cppcall ('boolean_batch', op, handlesA, handlesB);
+            else
+                handles = p.cppcall ('boolean_batch', op, handlesA, handlesB, backend);
+            end
+            
+            % the mexfunction returns handles to new objects, the
+            % geometry is shared with new polyhedron objects
+            results = csg.polyhedron.from_handles (handles);
+            
+        end
+        
+        function previous = set_workers (count, worker_path, timeout)
+            % configure the pool of worker processes
+            %
+            % Syntax
+            %
+            % previous = csg.polyhedron.set_workers (count)
+            % previous = csg.polyhedron.set_workers (count, worker_path, timeout)
+            % current = csg.polyhedron.set_workers ()
+            %
+            % Input
+            %
+            %  count - number of workers. Default is the number of threads.
+            %
+            %  worker_path - optional, the mpolycsg_worker executable, [] to keep
+            %
+            %  timeout - optional, seconds per operation, 0 for none. Default is
+            %    3600.
+            %
+            % Output
+            %
+            %  previous - the number of workers before the call
+            %
+            
+            p = csg.polyhedron ();
+            
+            if nargin < 1
+                previous = p.cppcall ('set_workers');
+            elseif nargin < 2
+                previous = p.cppcall ('set_workers', count);
+            elseif nargin < 3
+                previous = p.cppcall ('set_workers', count, worker_path);
+            else
+                previous = p.cppcall ('set_workers', count, worker_path, timeout);
+            end
+            
+        end
+        
+        function trace (onoff)
+            % start or stop recording trace events, see trace_dump
+            %
+            % Syntax
+            %
+            % csg.polyhedron.trace (onoff)
+            %
+            % Input
+            %
+            %  onoff - true to start recording, discarding any earlier events, false
+            %    to stop
+            %
+            
+            p = csg.polyhedron ();
+            p.cppcall ('trace', double (onoff));
+            
+        end
+        
+        function trace_dump (filename)
+            % write the recorded trace events to a Chrome trace JSON file
+            %
+            % Syntax
+            %
+            % csg.polyhedron.trace_dump (filename)
+            %
+            
+            p = csg.polyhedron ();
+            p.cppcall ('trace_dump', filename);
+            
+        end
+        
+    end
+    
+    methods (Static, Access = private)
+        
+        function objects = from_handles (handles)
+            % new polyhedra sharing the geometry of the objects with the
+            % given handles, which are deleted, all of them on an error
+            
+            objects = cell (size (handles));
+            ind = 1;
+            
+            try
+                for ind = 1:numel (handles)
+                    objects{ind} = csg.polyhedron ();
+                    objects{ind}.cppcall ('copy', handles{ind});
+                    mexpolyhedron ('delete', handles{ind});
+                end
+            catch err
+                for rest = ind:numel (handles)
+                    try
+                        mexpolyhedron ('delete', handles{rest});
+                    catch
+                        % already deleted
+                    end
+                end
+                rethrow (err);
+            end
+            
+        end
+        
+        function loops = split_loops (loops)
+            % split a matrix of loops separated by rows of NaN into a cell
+            % array of loops, cell arrays are returned unchanged
+            
+            if iscell (loops)
+                return;
+            end
+            
+            breaks = [0; find(any (isnan (loops), 2)); size(loops, 1) + 1];
+            
+            nodes = loops;
+            loops = {};
+            for ind = 1:numel(breaks)-1
+                loop = nodes(breaks(ind)+1:breaks(ind+1)-1,:);
+                if ~isempty (loop)
+                    loops{end+1} = loop;
+                end
+            end
+            
+        end
+        
+    end
 
 end
 
@@ -0,0 +1,1006 @@
+/*
+   bench_polyhedron.cpp
+   
+   Benchmarks of the polyhedron_interface hot paths. The mexfunction is 
+   driven exactly as Matlab/Octave would drive it, through the stub mex API,
+   so the timings include the argument marshalling as well as the work done
+   by the CSG kernel.
+   
+   Run with --benchmark_format=json (or --benchmark_out=<file>
+   --benchmark_out_format=json) to get results which can be compared across
+   commits with the compare.py tool distributed with Google Benchmark.
+
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "mex.h"
+
+namespace {
+
+// owns a polyhedron_interface instance created through the mexfunction
+class mex_polyhedron
+{
+public:
+    
+    mex_polyhedron ()
+    {
+        mxArray *cmd = mxCreateString ("new");
+        const mxArray *prhs[1] = { cmd };
+        
+        mexFunction (1, &handle_m, 1, prhs);
+        
+        mxDestroyArray (cmd);
+    }
+    
+    ~mex_polyhedron ()
+    {
+        call ("delete", std::vector<mxArray*> ());
+        mxDestroyArray (handle_m);
+    }
+    
+    // call a method, taking ownership of the arguments, any outputs are
+    // returned and must be destroyed by the caller
+    std::vector<mxArray*> call (const char *method, std::vector<mxArray*> args, int nlhs=0)
+    {
+        std::vector<const mxArray*> prhs;
+        mxArray *cmd = mxCreateString (method);
+        
+        prhs.push_back (cmd);
+        prhs.push_back (handle_m);
+        prhs.insert (prhs.end (), args.begin (), args.end ());
+        
+        std::vector<mxArray*> plhs (nlhs, (mxArray*)NULL);
+        
+        mexFunction (nlhs, nlhs > 0 ? &plhs[0] : NULL, (int)prhs.size (), &prhs[0]);
+        
+        mxDestroyArray (cmd);
+        
+        for (size_t i = 0; i < args.size (); i++)
+        {
+            mxDestroyArray (args[i]);
+        }
+        
+        return plhs;
+    }
+    
+    void call (const char *method, double a) 
+    { 
+        call (method, scalars (1, a)); 
+    }
+    
+    void call (const char *method, double a, double b, double c) 
+    { 
+        call (method, scalars (3, a, b, c)); 
+    }
+    
+    void call (const char *method, double a, double b, double c, double d) 
+    { 
+        call (method, scalars (4, a, b, c, d)); 
+    }
+    
+    // call a method taking another polyhedron as its argument
+    void call (const char *method, const mex_polyhedron &other)
+    {
+        call (method, std::vector<mxArray*> (1, other.handle_arg ()));
+    }
+    
+    // a new copy of the handle, to pass to methods of another polyhedron
+    mxArray *handle_arg () const
+    {
+        mxArray *h = mxCreateNumericMatrix (1, 1, mxUINT64_CLASS, mxREAL);
+        *((unsigned long long *)mxGetData (h)) = *((unsigned long long *)mxGetData (handle_m));
+        
+        return h;
+    }
+    
+    double scalar_result (const char *method)
+    {
+        std::vector<mxArray*> out = call (method, std::vector<mxArray*> (), 1);
+        double value = mxGetScalar (out[0]);
+        mxDestroyArray (out[0]);
+        return value;
+    }
+    
+    int num_faces () { return (int)scalar_result ("num_faces"); }
+    
+    int num_vertices () { return (int)scalar_result ("num_vertices"); }
+    
+private:
+    
+    static std::vector<mxArray*> scalars (int n, double a, double b=0, double c=0, double d=0)
+    {
+        double values[4] = { a, b, c, d };
+        std::vector<mxArray*> args;
+        
+        for (int i = 0; i < n; i++)
+        {
+            args.push_back (mxCreateDoubleScalar (values[i]));
+        }
+        
+        return args;
+    }
+    
+    mxArray *handle_m;
+    
+};
+
+// a regular polygon with n vertices, as the coords and lines arrays 
+// expected by the extrusion methods
+void make_polygon (int n, double r, mxArray *&coords, mxArray *&lines)
+{
+    coords = mxCreateDoubleMatrix (n, 2, mxREAL);
+    lines = mxCreateDoubleMatrix (n, 1, mxREAL);
+    
+    double *c = mxGetPr (coords);
+    double *l = mxGetPr (lines);
+    
+    for (int i = 0; i < n; i++)
+    {
+        double theta = 2.0 * M_PI * i / n;
+        c[i] = r * std::cos (theta);
+        c[n+i] = r * std::sin (theta);
+        l[i] = i;
+    }
+}
+
+void make_extrusion (mex_polyhedron &p, int nverts, double distance)
+{
+    mxArray *coords, *lines;
+    make_polygon (nverts, 1.0, coords, lines);
+    
+    std::vector<mxArray*> args;
+    args.push_back (coords);
+    args.push_back (lines);
+    args.push_back (mxCreateDoubleScalar (distance));
+    
+    p.call ("extrusion", args);
+}
+
+void set_face_counters (benchmark::State &state, mex_polyhedron &p)
+{
+    state.counters["faces"] = p.num_faces ();
+    state.counters["vertices"] = p.num_vertices ();
+}
+
+//////////////////////////   primitive creation   //////////////////////////
+
+void BM_makebox (benchmark::State &state)
+{
+    mex_polyhedron p;
+    
+    for (auto _ : state)
+    {
+        p.call ("makebox", 1, 1, 1, 1);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_makebox);
+
+void BM_makesphere (benchmark::State &state)
+{
+    mex_polyhedron p;
+    double segments = state.range (0);
+    
+    for (auto _ : state)
+    {
+        p.call ("makesphere", 1, 1, segments, segments);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_makesphere)->RangeMultiplier(2)->Range(8, 256);
+
+void BM_makecylinder (benchmark::State &state)
+{
+    mex_polyhedron p;
+    double segments = state.range (0);
+    
+    for (auto _ : state)
+    {
+        p.call ("makecylinder", 1, 2, 1, segments);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_makecylinder)->RangeMultiplier(4)->Range(8, 2048);
+
+void BM_maketorus (benchmark::State &state)
+{
+    mex_polyhedron p;
+    double segments = state.range (0);
+    
+    std::vector<mxArray*> args;
+    
+    for (auto _ : state)
+    {
+        args.clear ();
+        args.push_back (mxCreateDoubleScalar (1.0));
+        args.push_back (mxCreateDoubleScalar (0.25));
+        args.push_back (mxCreateDoubleScalar (1));
+        args.push_back (mxCreateDoubleScalar (segments));
+        args.push_back (mxCreateDoubleScalar (segments));
+        p.call ("maketorus", args);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_maketorus)->RangeMultiplier(2)->Range(8, 256);
+
+void BM_extrusion (benchmark::State &state)
+{
+    mex_polyhedron p;
+    
+    for (auto _ : state)
+    {
+        make_extrusion (p, state.range (0), 1.0);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_extrusion)->RangeMultiplier(4)->Range(8, 2048);
+
+// a square plate with a grid of n x n round holes, extruded in one call
+void BM_extrusion_region (benchmark::State &state)
+{
+    int n = state.range (0);
+    double pitch = 10.0 / n;
+    
+    mex_polyhedron p;
+    
+    for (auto _ : state)
+    {
+        mxArray *loops = mxCreateCellMatrix (1, n*n + 1);
+        mxArray *coords, *lines;
+        
+        coords = mxCreateDoubleMatrix (4, 2, mxREAL);
+        double *c = mxGetPr (coords);
+        c[0] = 0; c[1] = 10; c[2] = 10; c[3] = 0;
+        c[4] = 0; c[5] = 0;  c[6] = 10; c[7] = 10;
+        mxSetCell (loops, 0, coords);
+        
+        for (int i = 0; i < n*n; i++)
+        {
+            make_polygon (32, 0.3 * pitch, coords, lines);
+            mxDestroyArray (lines);
+            
+            c = mxGetPr (coords);
+            for (int k = 0; k < 32; k++)
+            {
+                c[k] += pitch * (0.5 + i % n);
+                c[32+k] += pitch * (0.5 + i / n);
+            }
+            
+            mxSetCell (loops, i + 1, coords);
+        }
+        
+        std::vector<mxArray*> args;
+        args.push_back (loops);
+        args.push_back (mxCreateDoubleScalar (1.0));
+        
+        p.call ("extrude_loops", args);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_extrusion_region)->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMillisecond);
+
+// a tube of 32 segment circles swept along a helix of n points
+void BM_sweep (benchmark::State &state)
+{
+    int n = state.range (0);
+    
+    mex_polyhedron p;
+    
+    for (auto _ : state)
+    {
+        mxArray *loops = mxCreateCellMatrix (1, 2);
+        mxArray *coords, *lines;
+        
+        make_polygon (32, 0.2, coords, lines);
+        mxDestroyArray (lines);
+        mxSetCell (loops, 0, coords);
+        
+        make_polygon (32, 0.1, coords, lines);
+        mxDestroyArray (lines);
+        mxSetCell (loops, 1, coords);
+        
+        mxArray *path = mxCreateDoubleMatrix (n, 3, mxREAL);
+        double *x = mxGetPr (path);
+        
+        for (int i = 0; i < n; i++)
+        {
+            double t = 6.0 * M_PI * i / (n - 1);
+            
+            x[i] = std::cos (t);
+            x[n+i] = std::sin (t);
+            x[2*n+i] = 0.1 * t;
+        }
+        
+        std::vector<mxArray*> args;
+        args.push_back (loops);
+        args.push_back (path);
+        
+        p.call ("sweep", args);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_sweep)->RangeMultiplier(4)->Range(16, 4096)->Unit(benchmark::kMillisecond);
+
+// the hull of n random points in a cube, or on a sphere where all of them
+// are on the hull
+void hull_benchmark (benchmark::State &state, bool on_sphere)
+{
+    int n = state.range (0);
+    
+    std::vector<double> xyz (3 * n);
+    unsigned int seed = 1;
+    
+    for (int i = 0; i < n; i++)
+    {
+        double r = 0.0;
+        
+        for (int k = 0; k < 3; k++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            xyz[3*i+k] = (seed >> 8) / double (1 << 24) - 0.5;
+            r += xyz[3*i+k] * xyz[3*i+k];
+        }
+        
+        for (int k = 0; k < 3 && on_sphere; k++)
+        {
+            xyz[3*i+k] /= std::sqrt (r);
+        }
+    }
+    
+    mex_polyhedron p;
+    
+    for (auto _ : state)
+    {
+        mxArray *points = mxCreateDoubleMatrix (n, 3, mxREAL);
+        double *x = mxGetPr (points);
+        
+        for (int i = 0; i < n; i++)
+        {
+            x[i] = xyz[3*i];
+            x[n+i] = xyz[3*i+1];
+            x[2*n+i] = xyz[3*i+2];
+        }
+        
+        p.call ("convex_hull", std::vector<mxArray*> (1, points));
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK_CAPTURE(hull_benchmark, cube, false)->RangeMultiplier(8)->Range(64, 262144)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(hull_benchmark, sphere, true)->RangeMultiplier(8)->Range(64, 262144)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   boolean operations   //////////////////////////
+
+// two overlapping spheres, each with the given number of segments in both 
+// directions, combined with the given operation
+void boolean_benchmark (benchmark::State &state, const char *op)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron a;
+    mex_polyhedron b;
+    
+    a.call ("makesphere", 1, 1, segments, segments);
+    b.call ("makesphere", 1, 1, segments, segments);
+    b.call ("translate", 0.5, 0.3, 0.2);
+    
+    int nresult = 0;
+    
+    for (auto _ : state)
+    {
+        mex_polyhedron r;
+        
+        r.call ("copy", a);
+        r.call (op, b);
+        
+        nresult = r.num_faces ();
+    }
+    
+    state.counters["faces_in"] = 2 * a.num_faces ();
+    state.counters["faces_out"] = nresult;
+}
+
+void BM_csgunion (benchmark::State &state) { boolean_benchmark (state, "csgunion"); }
+BENCHMARK(BM_csgunion)->RangeMultiplier(2)->Range(8, 128)->Unit(benchmark::kMillisecond);
+
+void BM_csgdifference (benchmark::State &state) { boolean_benchmark (state, "csgdifference"); }
+BENCHMARK(BM_csgdifference)->RangeMultiplier(2)->Range(8, 128)->Unit(benchmark::kMillisecond);
+
+void BM_csgsymmdifference (benchmark::State &state) { boolean_benchmark (state, "csgsymmdifference"); }
+BENCHMARK(BM_csgsymmdifference)->RangeMultiplier(2)->Range(8, 128)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   transformations   //////////////////////////
+
+void transform_benchmark (benchmark::State &state, const char *op, int nargs)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, segments, segments);
+    
+    // identity rotation/transformation matrices keep the geometry fixed
+    // between iterations
+    double identity[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+    double rot3[9] = { 1, 0, 0,  0, 1, 0,  0, 0, 1 };
+    
+    for (auto _ : state)
+    {
+        std::vector<mxArray*> args;
+        
+        for (int i = 0; i < nargs; i++)
+        {
+            double value = (nargs == 16) ? identity[i] : (nargs == 9) ? rot3[i] : 0.5;
+            args.push_back (mxCreateDoubleScalar (value));
+        }
+        
+        p.call (op, args);
+    }
+    
+    set_face_counters (state, p);
+}
+
+void BM_translate (benchmark::State &state) { transform_benchmark (state, "translate", 3); }
+BENCHMARK(BM_translate)->RangeMultiplier(4)->Range(8, 512);
+
+void BM_rotate (benchmark::State &state) { transform_benchmark (state, "rotate", 3); }
+BENCHMARK(BM_rotate)->RangeMultiplier(4)->Range(8, 512);
+
+void BM_rotmat (benchmark::State &state) { transform_benchmark (state, "rotmat", 9); }
+BENCHMARK(BM_rotmat)->RangeMultiplier(4)->Range(8, 512);
+
+void BM_transform (benchmark::State &state) { transform_benchmark (state, "transform", 16); }
+BENCHMARK(BM_transform)->RangeMultiplier(4)->Range(8, 512);
+
+//////////////////////////   triangulation   //////////////////////////
+
+void BM_triangulate_sphere (benchmark::State &state)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron base;
+    base.call ("makesphere", 1, 1, segments, segments);
+    
+    for (auto _ : state)
+    {
+        mex_polyhedron p;
+        p.call ("copy", base);
+        p.call ("triangulate", std::vector<mxArray*> ());
+    }
+    
+    set_face_counters (state, base);
+}
+BENCHMARK(BM_triangulate_sphere)->RangeMultiplier(4)->Range(8, 512);
+
+// extrusions have two large cap faces
+void BM_triangulate_extrusion (benchmark::State &state)
+{
+    mex_polyhedron base;
+    make_extrusion (base, state.range (0), 1.0);
+    
+    for (auto _ : state)
+    {
+        mex_polyhedron p;
+        p.call ("copy", base);
+        p.call ("triangulate", std::vector<mxArray*> ());
+    }
+    
+    set_face_counters (state, base);
+}
+BENCHMARK(BM_triangulate_extrusion)->RangeMultiplier(4)->Range(8, 2048);
+
+// scaling with the number of threads, on a sphere of quadrilaterals
+void BM_triangulate_threads (benchmark::State &state)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron base;
+    base.call ("makesphere", 1, 1, segments, segments);
+    
+    for (auto _ : state)
+    {
+        mex_polyhedron p;
+        p.call ("copy", base);
+        p.call ("triangulate", (double)state.range (1));
+    }
+    
+    set_face_counters (state, base);
+}
+BENCHMARK(BM_triangulate_threads)->ArgsProduct({{512}, {1, 2, 4, 8}})->Unit(benchmark::kMillisecond);
+
+//////////////////////////   mesh extraction   //////////////////////////
+
+// extraction as done by polyhedron.get_vertices and the face loops in the
+// m-code, one call per vertex and per face
+void BM_extract_per_element (benchmark::State &state)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, segments, segments);
+    
+    for (auto _ : state)
+    {
+        int nverts = p.num_vertices ();
+        
+        for (int i = 0; i < nverts; i++)
+        {
+            std::vector<mxArray*> out = p.call ("get_vertex", std::vector<mxArray*> (1, mxCreateDoubleScalar (i)), 1);
+            mxDestroyArray (out[0]);
+        }
+        
+        int nfaces = p.num_faces ();
+        
+        for (int i = 0; i < nfaces; i++)
+        {
+            std::vector<mxArray*> out = p.call ("get_face_vertices", std::vector<mxArray*> (1, mxCreateDoubleScalar (i)), 1);
+            mxDestroyArray (out[0]);
+        }
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_extract_per_element)->RangeMultiplier(4)->Range(8, 512);
+
+// extraction of everything in one call, as done by polyhedron.render
+void BM_get_patch_data (benchmark::State &state)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, segments, segments);
+    
+    for (auto _ : state)
+    {
+        std::vector<mxArray*> out = p.call ("get_patch_data", std::vector<mxArray*> (), 3);
+        
+        for (size_t i = 0; i < out.size (); i++)
+        {
+            mxDestroyArray (out[i]);
+        }
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_get_patch_data)->RangeMultiplier(4)->Range(8, 512);
+
+void BM_serialize (benchmark::State &state)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, segments, segments);
+    
+    double bytes = 0;
+    
+    for (auto _ : state)
+    {
+        std::vector<mxArray*> out = p.call ("serialize", std::vector<mxArray*> (), 1);
+        bytes = mxGetNumberOfElements (out[0]);
+        mxDestroyArray (out[0]);
+    }
+    
+    set_face_counters (state, p);
+    state.counters["bytes"] = bytes;
+}
+BENCHMARK(BM_serialize)->RangeMultiplier(4)->Range(8, 512);
+
+//////////////////////////   components   //////////////////////////
+
+// an n x n grid of separate square prisms, split into one polyhedron each
+void BM_split_components (benchmark::State &state)
+{
+    int n = state.range (0);
+    
+    mxArray *loops = mxCreateCellMatrix (1, n*n);
+    
+    for (int i = 0; i < n*n; i++)
+    {
+        mxArray *coords = mxCreateDoubleMatrix (4, 2, mxREAL);
+        double *c = mxGetPr (coords);
+        double x = 2.0 * (i % n);
+        double y = 2.0 * (i / n);
+        
+        c[0] = x; c[1] = x + 1; c[2] = x + 1; c[3] = x;
+        c[4] = y; c[5] = y;     c[6] = y + 1; c[7] = y + 1;
+        
+        mxSetCell (loops, i, coords);
+    }
+    
+    std::vector<mxArray*> args;
+    args.push_back (loops);
+    args.push_back (mxCreateDoubleScalar (1.0));
+    
+    mex_polyhedron p;
+    p.call ("extrude_loops", args);
+    
+    for (auto _ : state)
+    {
+        std::vector<mxArray*> out = p.call ("split_components", std::vector<mxArray*> (), 1);
+        
+        // delete the new polyhedra
+        mxArray *cmd = mxCreateString ("delete");
+        
+        for (size_t i = 0; i < mxGetNumberOfElements (out[0]); i++)
+        {
+            const mxArray *prhs[2] = { cmd, mxGetCell (out[0], i) };
+            mexFunction (0, NULL, 2, prhs);
+        }
+        
+        mxDestroyArray (cmd);
+        mxDestroyArray (out[0]);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_split_components)->RangeMultiplier(4)->Range(4, 256)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   adjacency   //////////////////////////
+
+// all three adjacency queries, the first builds the adjacency and the 
+// others reuse it. The translation drops the cached adjacency so it is 
+// rebuilt on every iteration
+void BM_adjacency (benchmark::State &state)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, segments, segments);
+    
+    const char *methods[] = { "get_edges", "get_face_adjacency", "is_manifold" };
+    
+    for (auto _ : state)
+    {
+        p.call ("translate", 0, 0, 0);
+        
+        for (int i = 0; i < 3; i++)
+        {
+            std::vector<mxArray*> out = p.call (methods[i], std::vector<mxArray*> (), 1);
+            mxDestroyArray (out[0]);
+        }
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK(BM_adjacency)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   voxelization   //////////////////////////
+
+// a sphere rasterised onto an n^3 grid around it, as occupancy, volume
+// fractions and sparse blocks
+void voxelize_benchmark (benchmark::State &state, double supersample, double block_size)
+{
+    double n = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, 64, 64);
+    
+    for (auto _ : state)
+    {
+        std::vector<mxArray*> args;
+        args.push_back (mxCreateDoubleMatrix (1, 3, mxREAL));
+        args.push_back (mxCreateDoubleScalar (2.2 / n));
+        args.push_back (mxCreateDoubleMatrix (1, 3, mxREAL));
+        args.push_back (mxCreateDoubleScalar (supersample));
+        args.push_back (mxCreateDoubleScalar (block_size));
+        
+        for (int d = 0; d < 3; d++)
+        {
+            mxGetPr (args[0])[d] = -1.1;
+            mxGetPr (args[2])[d] = n;
+        }
+        
+        std::vector<mxArray*> out = p.call ("voxelize", args, 1);
+        mxDestroyArray (out[0]);
+    }
+    
+    state.counters["voxels"] = n * n * n;
+    set_face_counters (state, p);
+}
+BENCHMARK_CAPTURE(voxelize_benchmark, occupancy, 0, 0)->RangeMultiplier(2)->Range(32, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(voxelize_benchmark, fractions, 4, 0)->RangeMultiplier(2)->Range(32, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(voxelize_benchmark, sparse, 0, 16)->RangeMultiplier(2)->Range(32, 256)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   simplification   //////////////////////////
+
+void BM_simplify (benchmark::State &state)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron base;
+    base.call ("makesphere", 1, 1, segments, segments);
+    
+    // keep progress reports out of the results
+    base.call ("progress_interval", 0.0);
+    
+    for (auto _ : state)
+    {
+        mex_polyhedron p;
+        p.call ("copy", base);
+        p.call ("simplify", 500);
+    }
+    
+    set_face_counters (state, base);
+}
+BENCHMARK(BM_simplify)->RangeMultiplier(4)->Range(32, 512)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   offsets   //////////////////////////
+
+// offsetting and hollowing a sphere, starting from a fresh copy each time
+void offset_benchmark (benchmark::State &state, const char *method)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron base;
+    base.call ("makesphere", 1, 1, segments, segments);
+    
+    mex_polyhedron p;
+    
+    for (auto _ : state)
+    {
+        p.call ("copy", base);
+        p.call (method, 0.1);
+    }
+    
+    set_face_counters (state, base);
+}
+BENCHMARK_CAPTURE(offset_benchmark, offset, "offset")->RangeMultiplier(4)->Range(32, 512)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(offset_benchmark, shell, "shell")->RangeMultiplier(4)->Range(32, 512)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   comparison   //////////////////////////
+
+// the distance between a coarse and a fine sphere, with samples points on 
+// each surface
+void BM_hausdorff (benchmark::State &state)
+{
+    double samples = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, 32, 32);
+    
+    mex_polyhedron q;
+    q.call ("makesphere", 1, 1, 256, 256);
+    
+    for (auto _ : state)
+    {
+        std::vector<mxArray*> args;
+        args.push_back (q.handle_arg ());
+        args.push_back (mxCreateDoubleScalar (samples));
+        
+        std::vector<mxArray*> out = p.call ("hausdorff", args, 1);
+        mxDestroyArray (out[0]);
+    }
+    
+    state.counters["samples"] = 2 * samples;
+    set_face_counters (state, q);
+}
+BENCHMARK(BM_hausdorff)->RangeMultiplier(8)->Range(1000, 512000)->Unit(benchmark::kMillisecond);
+
+// the same spheres compared with a tolerance larger than the difference,
+// so every sample is checked, and a smaller one, stopping early
+void approx_equal_benchmark (benchmark::State &state, double tol)
+{
+    double samples = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, 32, 32);
+    
+    mex_polyhedron q;
+    q.call ("makesphere", 1, 1, 256, 256);
+    
+    for (auto _ : state)
+    {
+        std::vector<mxArray*> args;
+        args.push_back (q.handle_arg ());
+        args.push_back (mxCreateDoubleScalar (tol));
+        args.push_back (mxCreateDoubleScalar (samples));
+        
+        std::vector<mxArray*> out = p.call ("approx_equal", args, 1);
+        mxDestroyArray (out[0]);
+    }
+    
+    set_face_counters (state, q);
+}
+BENCHMARK_CAPTURE(approx_equal_benchmark, equal, 0.1)->RangeMultiplier(8)->Range(1000, 512000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(approx_equal_benchmark, different, 1e-4)->RangeMultiplier(8)->Range(1000, 512000)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   quality   //////////////////////////
+
+// the quality report of a sphere of quadrilaterals, which are triangulated
+// on every call, and of the same sphere already triangulated, which reuses
+// its cached adjacency
+void quality_report_benchmark (benchmark::State &state, bool triangulated)
+{
+    double segments = state.range (0);
+    
+    mex_polyhedron p;
+    p.call ("makesphere", 1, 1, segments, segments);
+    
+    if (triangulated)
+    {
+        p.call ("triangulate", std::vector<mxArray*> ());
+    }
+    
+    for (auto _ : state)
+    {
+        std::vector<mxArray*> out = p.call ("quality_report", std::vector<mxArray*> (), 1);
+        mxDestroyArray (out[0]);
+    }
+    
+    set_face_counters (state, p);
+}
+BENCHMARK_CAPTURE(quality_report_benchmark, quads, false)->RangeMultiplier(4)->Range(32, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(quality_report_benchmark, triangles, true)->RangeMultiplier(4)->Range(32, 1024)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   export   //////////////////////////
+
+// an assembly of n spheres of 32 x 32 segments written to one file, each
+// moved into place as it is written
+void export_benchmark (benchmark::State &state, const char *format)
+{
+    int n = state.range (0);
+    
+    std::vector<mex_polyhedron> spheres (n);
+    
+    for (int i = 0; i < n; i++)
+    {
+        spheres[i].call ("makesphere", 1, 1, 32, 32);
+    }
+    
+    std::string filename = std::string ("bench_export.") + format;
+    
+    for (auto _ : state)
+    {
+        mxArray *handles = mxCreateCellMatrix (1, n);
+        mxArray *transforms = mxCreateDoubleMatrix (4, 4 * n, mxREAL);
+        double *t = mxGetPr (transforms);
+        
+        for (int i = 0; i < n; i++)
+        {
+            mxSetCell (handles, i, spheres[i].handle_arg ());
+            
+            for (int d = 0; d < 4; d++)
+            {
+                t[16*i + 5*d] = 1.0;
+            }
+            
+            t[16*i + 12] = 3.0 * i;
+        }
+        
+        std::vector<mxArray*> args;
+        args.push_back (mxCreateString (filename.c_str ()));
+        args.push_back (handles);
+        args.push_back (transforms);
+        
+        spheres[0].call ("export_bodies", args);
+    }
+    
+    std::remove (filename.c_str ());
+    
+    state.counters["faces"] = n * spheres[0].num_faces ();
+}
+BENCHMARK_CAPTURE(export_benchmark, stl, "stl")->RangeMultiplier(4)->Range(4, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(export_benchmark, obj, "obj")->RangeMultiplier(4)->Range(4, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(export_benchmark, ply, "ply")->RangeMultiplier(4)->Range(4, 256)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   interference   //////////////////////////
+
+// a k x k x k lattice of spheres of 16 x 16 segments, each overlapping its
+// six neighbours, checked for interference, with or without the volumes
+void interference_benchmark (benchmark::State &state, bool volumes)
+{
+    int k = state.range (0);
+    int n = k * k * k;
+    
+    std::vector<mex_polyhedron> spheres (n);
+    
+    for (int i = 0; i < n; i++)
+    {
+        spheres[i].call ("makesphere", 0.6, 1, 16, 16);
+        spheres[i].call ("translate", i % k, (i / k) % k, i / (k * k));
+    }
+    
+    for (auto _ : state)
+    {
+        mxArray *handles = mxCreateCellMatrix (1, n);
+        
+        for (int i = 0; i < n; i++)
+        {
+            mxSetCell (handles, i, spheres[i].handle_arg ());
+        }
+        
+        std::vector<mxArray*> out = spheres[0].call ("interference", std::vector<mxArray*> (1, handles), volumes ? 2 : 1);
+        
+        for (size_t i = 0; i < out.size (); i++)
+        {
+            mxDestroyArray (out[i]);
+        }
+    }
+    
+    state.counters["parts"] = n;
+    state.counters["faces"] = n * spheres[0].num_faces ();
+}
+BENCHMARK_CAPTURE(interference_benchmark, pairs, false)->DenseRange(2, 8, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(interference_benchmark, volumes, true)->DenseRange(2, 8, 2)->Unit(benchmark::kMillisecond);
+
+//////////////////////////   worker processes   //////////////////////////
+
+// n differences of a box and a sphere of 32 x 32 segments, in worker 
+// processes with boolean_batch, or one after another in this process
+void boolean_batch_benchmark (benchmark::State &state, bool isolated)
+{
+    int n = state.range (0);
+    
+    // unless the worker to use is given in the environment
+    setenv ("MPOLYCSG_WORKER", MPOLYCSG_WORKER_PATH, 0);
+    
+    mex_polyhedron box;
+    box.call ("makebox", 2, 2, 2, 1);
+    
+    mex_polyhedron sphere;
+    sphere.call ("makesphere", 1, 1, 32, 32);
+    
+    for (auto _ : state)
+    {
+        if (isolated)
+        {
+            mxArray *a = mxCreateCellMatrix (1, n);
+            mxArray *b = mxCreateCellMatrix (1, n);
+            
+            for (int i = 0; i < n; i++)
+            {
+                mxSetCell (a, i, box.handle_arg ());
+                mxSetCell (b, i, sphere.handle_arg ());
+            }
+            
+            std::vector<mxArray*> args;
+            args.push_back (mxCreateString ("difference"));
+            args.push_back (a);
+            args.push_back (b);
+            
+            std::vector<mxArray*> out = box.call ("boolean_batch", args, 1);
+            
+            // delete the new polyhedra
+            mxArray *cmd = mxCreateString ("delete");
+            
+            for (size_t i = 0; i < mxGetNumberOfElements (out[0]); i++)
+            {
+                const mxArray *prhs[2] = { cmd, mxGetCell (out[0], i) };
+                mexFunction (0, NULL, 2, prhs);
+            }
+            
+            mxDestroyArray (cmd);
+            mxDestroyArray (out[0]);
+        }
+        else
+        {
+            for (int i = 0; i < n; i++)
+            {
+                mex_polyhedron p;
+                p.call ("copy", box);
+                p.call ("csgdifference", sphere);
+            }
+        }
+    }
+    
+    state.counters["operations"] = n;
+}
+BENCHMARK_CAPTURE(boolean_batch_benchmark, local, false)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(boolean_batch_benchmark, workers, true)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMillisecond);
+
+} // anonymous namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,122 @@
+/*
+   mex.h
+   
+   Minimal stand-in for the Matlab/Octave mex API, sufficient to build and
+   drive the mexpolyhedron mexfunction from plain C++ programs such as the
+   benchmarks, without Matlab or Octave. Errors raised through 
+   mexErrMsgTxt/mexErrMsgIdAndTxt are thrown as mex_stub_error.
+
+*/
+
+#ifndef __MEX_STUB_MEX_H__
+#define __MEX_STUB_MEX_H__
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+typedef size_t mwSize;
+typedef size_t mwIndex;
+
+typedef enum
+{
+    mxUNKNOWN_CLASS,
+    mxCELL_CLASS,
+    mxSTRUCT_CLASS,
+    mxLOGICAL_CLASS,
+    mxCHAR_CLASS,
+    mxVOID_CLASS,
+    mxDOUBLE_CLASS,
+    mxSINGLE_CLASS,
+    mxINT8_CLASS,
+    mxUINT8_CLASS,
+    mxINT16_CLASS,
+    mxUINT16_CLASS,
+    mxINT32_CLASS,
+    mxUINT32_CLASS,
+    mxINT64_CLASS,
+    mxUINT64_CLASS
+} mxClassID;
+
+typedef enum { mxREAL, mxCOMPLEX } mxComplexity;
+
+typedef bool mxLogical;
+
+typedef unsigned short mxChar;
+
+struct mxArray;
+
+class mex_stub_error : public std::runtime_error
+{
+public:
+    mex_stub_error (const std::string &id, const std::string &msg) 
+        : std::runtime_error (msg), id_m (id) {}
+    
+    ~mex_stub_error () throw () {}
+    
+    const std::string& id () const { return id_m; }
+    
+private:
+    std::string id_m;
+};
+
+// array creation and destruction
+mxArray *mxCreateNumericMatrix (mwSize m, mwSize n, mxClassID classid, mxComplexity flag);
+mxArray *mxCreateNumericArray (mwSize ndim, const mwSize *dims, mxClassID classid, mxComplexity flag);
+mxArray *mxCreateDoubleMatrix (mwSize m, mwSize n, mxComplexity flag);
+mxArray *mxCreateDoubleScalar (double value);
+mxArray *mxCreateLogicalArray (mwSize ndim, const mwSize *dims);
+mxArray *mxCreateLogicalScalar (bool value);
+mxArray *mxCreateString (const char *str);
+mxArray *mxCreateCellMatrix (mwSize m, mwSize n);
+mxArray *mxCreateStructMatrix (mwSize m, mwSize n, int nfields, const char **fieldnames);
+void mxDestroyArray (mxArray *pa);
+
+// array access
+void *mxGetData (const mxArray *pa);
+double *mxGetPr (const mxArray *pa);
+double mxGetScalar (const mxArray *pa);
+mwSize mxGetM (const mxArray *pa);
+mwSize mxGetN (const mxArray *pa);
+mwSize mxGetNumberOfElements (const mxArray *pa);
+mwSize mxGetNumberOfDimensions (const mxArray *pa);
+const mwSize *mxGetDimensions (const mxArray *pa);
+mxClassID mxGetClassID (const mxArray *pa);
+mwIndex mxCalcSingleSubscript (const mxArray *pa, mwSize nsubs, const mwIndex *subs);
+mxArray *mxGetCell (const mxArray *pa, mwIndex i);
+void mxSetCell (mxArray *pa, mwIndex i, mxArray *value);
+mxArray *mxGetField (const mxArray *pa, mwIndex i, const char *fieldname);
+void mxSetField (mxArray *pa, mwIndex i, const char *fieldname, mxArray *value);
+int mxGetString (const mxArray *pa, char *buf, mwSize buflen);
+char *mxArrayToString (const mxArray *pa);
+void mxFree (void *ptr);
+double mxGetNaN (void);
+double mxGetInf (void);
+
+// array type queries
+bool mxIsNumeric (const mxArray *pa);
+bool mxIsDouble (const mxArray *pa);
+bool mxIsUint64 (const mxArray *pa);
+bool mxIsComplex (const mxArray *pa);
+bool mxIsChar (const mxArray *pa);
+bool mxIsCell (const mxArray *pa);
+bool mxIsStruct (const mxArray *pa);
+bool mxIsLogical (const mxArray *pa);
+bool mxIsEmpty (const mxArray *pa);
+
+// mex environment
+void mexErrMsgTxt (const char *msg);
+void mexErrMsgIdAndTxt (const char *id, const char *fmt, ...);
+void mexWarnMsgTxt (const char *msg);
+void mexWarnMsgIdAndTxt (const char *id, const char *fmt, ...);
+int mexPrintf (const char *fmt, ...);
+int mexEvalString (const char *command);
+void mexLock (void);
+void mexUnlock (void);
+int mexAtExit (void (*exit_fcn)(void));
+void mexMakeArrayPersistent (mxArray *pa);
+
+// the entry point implemented by the mexfunction
+void mexFunction (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]);
+
+#endif // __MEX_STUB_MEX_H__
@@ -0,0 +1,368 @@
+/*
+   mex_stub.cpp
+   
+   Minimal stand-in for the Matlab/Octave mex API, see mex.h
+
+*/
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "mex.h"
+
+struct mxArray
+{
+    mxClassID classid;
+    std::vector<mwSize> dims;
+    // numeric, logical and char data
+    std::vector<unsigned char> data;
+    // cell contents, or struct field values in field-major order per element
+    std::vector<mxArray*> children;
+    std::vector<std::string> fieldnames;
+};
+
+namespace {
+
+size_t element_size (mxClassID classid)
+{
+    switch (classid)
+    {
+        case mxDOUBLE_CLASS: 
+        case mxINT64_CLASS: 
+        case mxUINT64_CLASS: 
+            return 8;
+        case mxSINGLE_CLASS: 
+        case mxINT32_CLASS: 
+        case mxUINT32_CLASS: 
+            return 4;
+        case mxINT16_CLASS: 
+        case mxUINT16_CLASS: 
+        case mxCHAR_CLASS: 
+            return 2;
+        default: 
+            return 1;
+    }
+}
+
+mwSize numel (const mxArray *pa)
+{
+    mwSize n = 1;
+    
+    for (size_t i = 0; i < pa->dims.size (); i++)
+    {
+        n *= pa->dims[i];
+    }
+    
+    return n;
+}
+
+std::string format (const char *fmt, va_list ap)
+{
+    char buf[2048];
+    vsnprintf (buf, sizeof (buf), fmt, ap);
+    return std::string (buf);
+}
+
+int field_number (const mxArray *pa, const char *fieldname)
+{
+    for (size_t i = 0; i < pa->fieldnames.size (); i++)
+    {
+        if (pa->fieldnames[i] == fieldname) { return (int)i; }
+    }
+    
+    return -1;
+}
+
+} // anonymous namespace
+
+mxArray *mxCreateNumericArray (mwSize ndim, const mwSize *dims, mxClassID classid, mxComplexity flag)
+{
+    mxArray *pa = new mxArray;
+    
+    pa->classid = classid;
+    pa->dims.assign (dims, dims + ndim);
+    
+    while (pa->dims.size () < 2) { pa->dims.push_back (1); }
+    
+    if (classid == mxCELL_CLASS || classid == mxSTRUCT_CLASS)
+    {
+        pa->children.assign (numel (pa), (mxArray*)NULL);
+    }
+    else
+    {
+        pa->data.assign (numel (pa) * element_size (classid), 0);
+    }
+    
+    return pa;
+}
+
+mxArray *mxCreateNumericMatrix (mwSize m, mwSize n, mxClassID classid, mxComplexity flag)
+{
+    mwSize dims[2] = { m, n };
+    return mxCreateNumericArray (2, dims, classid, flag);
+}
+
+mxArray *mxCreateDoubleMatrix (mwSize m, mwSize n, mxComplexity flag)
+{
+    return mxCreateNumericMatrix (m, n, mxDOUBLE_CLASS, flag);
+}
+
+mxArray *mxCreateDoubleScalar (double value)
+{
+    mxArray *pa = mxCreateDoubleMatrix (1, 1, mxREAL);
+    *mxGetPr (pa) = value;
+    return pa;
+}
+
+mxArray *mxCreateLogicalArray (mwSize ndim, const mwSize *dims)
+{
+    return mxCreateNumericArray (ndim, dims, mxLOGICAL_CLASS, mxREAL);
+}
+
+mxArray *mxCreateLogicalScalar (bool value)
+{
+    mxArray *pa = mxCreateNumericMatrix (1, 1, mxLOGICAL_CLASS, mxREAL);
+    *((mxLogical *)mxGetData (pa)) = value;
+    return pa;
+}
+
+mxArray *mxCreateString (const char *str)
+{
+    size_t n = std::strlen (str);
+    mxArray *pa = mxCreateNumericMatrix (1, n, mxCHAR_CLASS, mxREAL);
+    mxChar *data = (mxChar *)mxGetData (pa);
+    
+    for (size_t i = 0; i < n; i++) { data[i] = (mxChar)str[i]; }
+    
+    return pa;
+}
+
+mxArray *mxCreateCellMatrix (mwSize m, mwSize n)
+{
+    return mxCreateNumericMatrix (m, n, mxCELL_CLASS, mxREAL);
+}
+
+mxArray *mxCreateStructMatrix (mwSize m, mwSize n, int nfields, const char **fieldnames)
+{
+    mxArray *pa = mxCreateNumericMatrix (m, n, mxSTRUCT_CLASS, mxREAL);
+    
+    pa->fieldnames.assign (fieldnames, fieldnames + nfields);
+    pa->children.assign (m * n * nfields, (mxArray*)NULL);
+    
+    return pa;
+}
+
+void mxDestroyArray (mxArray *pa)
+{
+    if (pa == NULL) { return; }
+    
+    for (size_t i = 0; i < pa->children.size (); i++)
+    {
+        mxDestroyArray (pa->children[i]);
+    }
+    
+    delete pa;
+}
+
+void *mxGetData (const mxArray *pa)
+{
+    return pa->data.empty () ? NULL : (void *)&pa->data[0];
+}
+
+double *mxGetPr (const mxArray *pa)
+{
+    return (double *)mxGetData (pa);
+}
+
+double mxGetScalar (const mxArray *pa)
+{
+    const void *data = mxGetData (pa);
+    
+    if (data == NULL) { return 0; }
+    
+    switch (pa->classid)
+    {
+        case mxDOUBLE_CLASS: return *(const double *)data;
+        case mxSINGLE_CLASS: return *(const float *)data;
+        case mxINT32_CLASS: return *(const int *)data;
+        case mxUINT32_CLASS: return *(const unsigned int *)data;
+        case mxINT64_CLASS: return (double)*(const long long *)data;
+        case mxUINT64_CLASS: return (double)*(const unsigned long long *)data;
+        case mxINT16_CLASS: return *(const short *)data;
+        case mxUINT16_CLASS: case mxCHAR_CLASS: return *(const unsigned short *)data;
+        case mxINT8_CLASS: return *(const signed char *)data;
+        default: return *(const unsigned char *)data;
+    }
+}
+
+mwSize mxGetM (const mxArray *pa) { return pa->dims[0]; }
+
+mwSize mxGetN (const mxArray *pa) { return numel (pa) / (pa->dims[0] ? pa->dims[0] : 1); }
+
+mwSize mxGetNumberOfElements (const mxArray *pa) { return numel (pa); }
+
+mwSize mxGetNumberOfDimensions (const mxArray *pa) { return pa->dims.size (); }
+
+const mwSize *mxGetDimensions (const mxArray *pa) { return &pa->dims[0]; }
+
+mxClassID mxGetClassID (const mxArray *pa) { return pa->classid; }
+
+mwIndex mxCalcSingleSubscript (const mxArray *pa, mwSize nsubs, const mwIndex *subs)
+{
+    mwIndex index = 0;
+    mwIndex stride = 1;
+    
+    for (mwSize i = 0; i < nsubs && i < pa->dims.size (); i++)
+    {
+        index += subs[i] * stride;
+        stride *= pa->dims[i];
+    }
+    
+    return index;
+}
+
+mxArray *mxGetCell (const mxArray *pa, mwIndex i)
+{
+    return pa->children[i];
+}
+
+void mxSetCell (mxArray *pa, mwIndex i, mxArray *value)
+{
+    pa->children[i] = value;
+}
+
+mxArray *mxGetField (const mxArray *pa, mwIndex i, const char *fieldname)
+{
+    int field = field_number (pa, fieldname);
+    
+    if (field < 0) { return NULL; }
+    
+    return pa->children[i * pa->fieldnames.size () + field];
+}
+
+void mxSetField (mxArray *pa, mwIndex i, const char *fieldname, mxArray *value)
+{
+    int field = field_number (pa, fieldname);
+    
+    if (field < 0)
+    {
+        mexErrMsgIdAndTxt ("MEXSTUB:mxSetField", "No field named %s.", fieldname);
+    }
+    
+    pa->children[i * pa->fieldnames.size () + field] = value;
+}
+
+int mxGetString (const mxArray *pa, char *buf, mwSize buflen)
+{
+    if (pa->classid != mxCHAR_CLASS || buflen == 0) { return 1; }
+    
+    mwSize n = numel (pa);
+    const mxChar *data = (const mxChar *)mxGetData (pa);
+    mwSize i = 0;
+    
+    for (; i < n && i + 1 < buflen; i++) { buf[i] = (char)data[i]; }
+    
+    buf[i] = '\0';
+    
+    return (n + 1 > buflen) ? 1 : 0;
+}
+
+char *mxArrayToString (const mxArray *pa)
+{
+    if (pa->classid != mxCHAR_CLASS) { return NULL; }
+    
+    mwSize n = numel (pa);
+    char *str = (char *)std::malloc (n + 1);
+    
+    mxGetString (pa, str, n + 1);
+    
+    return str;
+}
+
+void mxFree (void *ptr) { std::free (ptr); }
+
+double mxGetNaN (void) { return std::numeric_limits<double>::quiet_NaN (); }
+
+double mxGetInf (void) { return std::numeric_limits<double>::infinity (); }
+
+bool mxIsNumeric (const mxArray *pa) { return pa->classid >= mxDOUBLE_CLASS; }
+
+bool mxIsDouble (const mxArray *pa) { return pa->classid == mxDOUBLE_CLASS; }
+
+bool mxIsUint64 (const mxArray *pa) { return pa->classid == mxUINT64_CLASS; }
+
+bool mxIsComplex (const mxArray *pa) { return false; }
+
+bool mxIsChar (const mxArray *pa) { return pa->classid == mxCHAR_CLASS; }
+
+bool mxIsCell (const mxArray *pa) { return pa->classid == mxCELL_CLASS; }
+
+bool mxIsStruct (const mxArray *pa) { return pa->classid == mxSTRUCT_CLASS; }
+
+bool mxIsLogical (const mxArray *pa) { return pa->classid == mxLOGICAL_CLASS; }
+
+bool mxIsEmpty (const mxArray *pa) { return numel (pa) == 0; }
+
+void mexErrMsgTxt (const char *msg)
+{
+    throw mex_stub_error ("", msg);
+}
+
+void mexErrMsgIdAndTxt (const char *id, const char *fmt, ...)
+{
+    va_list ap;
+    va_start (ap, fmt);
+    std::string msg = format (fmt, ap);
+    va_end (ap);
+    
+    throw mex_stub_error (id, msg);
+}
+
+void mexWarnMsgTxt (const char *msg)
+{
+    std::fprintf (stderr, "Warning: %s\n", msg);
+}
+
+void mexWarnMsgIdAndTxt (const char *id, const char *fmt, ...)
+{
+    va_list ap;
+    va_start (ap, fmt);
+    std::string msg = format (fmt, ap);
+    va_end (ap);
+    
+    std::fprintf (stderr, "Warning (%s): %s\n", id, msg.c_str ());
+}
+
+int mexPrintf (const char *fmt, ...)
+{
+    va_list ap;
+    va_start (ap, fmt);
+    int n = std::vfprintf (stdout, fmt, ap);
+    va_end (ap);
+    
+    return n;
+}
+
+int mexEvalString (const char *command)
+{
+    // there is no interpreter, only flush any printed output
+    std::fflush (stdout);
+    
+    return 0;
+}
+
+void mexLock (void) {}
+
+void mexUnlock (void) {}
+
+int mexAtExit (void (*exit_fcn)(void))
+{
+    // there is no mexfunction to clear, so run at program exit instead
+    return std::atexit (exit_fcn);
+}
+
+void mexMakeArrayPersistent (mxArray *pa) {}
@@ -0,0 +1,27 @@
+# Find the libpolyhcsg library from pyPolyCSG
+#
+# Defines the imported target polyhcsg::polyhcsg, and the variables
+#
+#   polyhcsg_FOUND
+#   polyhcsg_INCLUDE_DIR
+#   polyhcsg_LIBRARY
+#
+# Set polyhcsg_ROOT to search a non-standard install prefix first.
+
+find_path(polyhcsg_INCLUDE_DIR polyhcsg/polyhedron.h)
+find_library(polyhcsg_LIBRARY polyhcsg)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(polyhcsg
+    REQUIRED_VARS polyhcsg_LIBRARY polyhcsg_INCLUDE_DIR
+)
+
+if(polyhcsg_FOUND AND NOT TARGET polyhcsg::polyhcsg)
+    add_library(polyhcsg::polyhcsg UNKNOWN IMPORTED)
+    set_target_properties(polyhcsg::polyhcsg PROPERTIES
+        IMPORTED_LOCATION "${polyhcsg_LIBRARY}"
+        INTERFACE_INCLUDE_DIRECTORIES "${polyhcsg_INCLUDE_DIR}"
+    )
+endif()
+
+mark_as_advanced(polyhcsg_INCLUDE_DIR polyhcsg_LIBRARY)
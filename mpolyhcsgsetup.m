@@ -1,10 +1,11 @@
-function mpolyhcsgsetup(dodebug, verbose)
+function mpolyhcsgsetup(dodebug, verbose, withzstd)
 % compiles the fpproc mexfunction
 %
 % Syntax
 % mpolyhcsgsetup()
 % mpolyhcsgsetup(dodebug)
 % mpolyhcsgsetup(dodebug, verbose)
+% mpolyhcsgsetup(dodebug, verbose, withzstd)
 %
 % Input
 %
@@ -13,6 +14,9 @@ function mpolyhcsgsetup(dodebug, verbose)
 %  verbose - flag determines whether to print compiler output to command
 %    line
 %
+%  withzstd - flag determines whether to build with support for
+%    compressing serialized polyhedra, requires libzstd. Default is false.
+%
 
 % Copyright 2012-2014 Richard Crozier
 % 
@@ -24,6 +28,10 @@ function mpolyhcsgsetup(dodebug, verbose)
     if nargin < 2
         verbose = false;
     end 
+    
+    if nargin < 3
+        withzstd = false;
+    end
 
     if isoctave
         cc.Name = 'gcc';
@@ -68,13 +76,70 @@ function mpolyhcsgsetup(dodebug, verbose)
     if verbose
         common_compiler_flags = [common_compiler_flags, {'-v'}];
     end
+    
+    % the algorithm sources require C++11
+    if isoctave
+        origcxxflags = getenv ('CXXFLAGS');
+        OCF = onCleanup (@() setenv ('CXXFLAGS', origcxxflags));
+        setenv ('CXXFLAGS', [strtrim(mkoctfile('-p', 'CXXFLAGS')), ' -std=c++11']);
+    else
+        common_compiler_flags = [common_compiler_flags, {'CXXFLAGS=$CXXFLAGS -std=c++11'}];
+    end
 
     libcommands = {'-lpolyhcsg' };
+    
+    if isunix
+        % long operations are run on a worker thread, and boolean 
+        % operations can be run in worker processes, which are found with
+        % dladdr and return their results in POSIX shared memory
+        libcommands = [libcommands, {'-lpthread', '-ldl'}];
+        if ~ismac
+            libcommands = [libcommands, {'-lrt'}];
+        end
+    end
+    
+    if ~isoctave
+        % allow Ctrl-C to cancel long operations, using the undocumented 
+        % utIsInterruptPending function from libut
+        common_compiler_flags = [common_compiler_flags, {'-DMPOLYCSG_UT_INTERRUPT'}];
+        libcommands = [libcommands, {'-lut'}];
+    end
+    
+    if withzstd
+        common_compiler_flags = [common_compiler_flags, {'-DMPOLYCSG_WITH_ZSTD'}];
+        libcommands = [libcommands, {'-lzstd'}];
+    end
+    
+    % the mexfunction and the engine it wraps
+    srcfiles = { '../src/mexpolyhedron.cpp', ...
+                 '../src/adjacency.cpp', ...
+                 '../src/backend.cpp', ...
+                 '../src/components.cpp', ...
+                 '../src/distance.cpp', ...
+                 '../src/extrude.cpp', ...
+                 '../src/hull.cpp', ...
+                 '../src/interference.cpp', ...
+                 '../src/mesh_data.cpp', ...
+                 '../src/mesh_export.cpp', ...
+                 '../src/offset.cpp', ...
+                 '../src/parallel.cpp', ...
+                 '../src/polyhedron_engine.cpp', ...
+                 '../src/progress.cpp', ...
+                 '../src/quality.cpp', ...
+                 '../src/serialize.cpp', ...
+                 '../src/simplify.cpp', ...
+                 '../src/stats.cpp', ...
+                 '../src/sweep.cpp', ...
+                 '../src/tessellation.cpp', ...
+                 '../src/triangulate.cpp', ...
+                 '../src/voxelize.cpp', ...
+                 '../src/worker_pool.cpp', ...
+               };
 
     % put all the compiler commands in a cell array
     mexcommands = [ common_compiler_flags, ...
+                    srcfiles, ...
                     { ...
-                      '../src/mexpolyhedron.cpp', ...
                       ['-I"', fullfile(thisfiledir, 'src') ,'"'], ...
                     }, ...
                     libcommands ...
@@ -87,6 +152,25 @@ function mpolyhcsgsetup(dodebug, verbose)
         mex(mexcommands{:});
     end
     
+    if isunix
+        % the worker process, built from the same engine sources and put
+        % next to the mexfunction where the engine looks for it
+        workercommands = [ common_compiler_flags, ...
+                           {'../src/mpolycsg_worker.cpp'}, ...
+                           srcfiles(2:end), ...
+                           { ...
+                             ['-I"', fullfile(thisfiledir, 'src') ,'"'], ...
+                           }, ...
+                           libcommands ...
+                         ];
+        
+        if isoctave
+            mkoctfile('--link-stand-alone', '-o', 'mpolycsg_worker', workercommands{:});
+        else
+            mex('-client', 'engine', '-output', 'mpolycsg_worker', workercommands{:});
+        end
+    end
+    
     addpath (fullfile (thisfiledir, mexdir));
 
 end
@@ -0,0 +1,226 @@
+/*
+   adjacency.cpp
+   
+   Edge and face adjacency of a mesh, stored as flat arrays indexed by
+   edge and by half-edge
+
+*/
+
+#include <algorithm>
+
+#include "adjacency.hpp"
+
+namespace mpolycsg {
+
+void mesh_adjacency::clear ()
+{
+    edge_verts.clear ();
+    edge_face_start.assign (1, 0);
+    edge_faces.clear ();
+    half_edge.clear ();
+    half_face.clear ();
+    half_twin.clear ();
+    num_boundary_edges = 0;
+    num_nonmanifold_edges = 0;
+    num_nonmanifold_vertices = 0;
+}
+
+namespace {
+
+// the next and previous half-edges around the face of half-edge h
+inline int next_half (const mesh_data &mesh, const mesh_adjacency &adj, int h)
+{
+    int f = adj.half_face[h];
+    int start = mesh.face_start[f];
+    int n = mesh.face_start[f+1] - start;
+    
+    return start + (h - start + 1) % n;
+}
+
+inline int prev_half (const mesh_data &mesh, const mesh_adjacency &adj, int h)
+{
+    int f = adj.half_face[h];
+    int start = mesh.face_start[f];
+    int n = mesh.face_start[f+1] - start;
+    
+    return start + (h - start + n - 1) % n;
+}
+
+// the twin of half-edge h if it runs the opposite way, so the faces on
+// either side have consistent orientations, otherwise -1
+inline int oriented_twin (const mesh_data &mesh, const mesh_adjacency &adj, int h)
+{
+    int t = adj.half_twin[h];
+    
+    if (t < 0 || mesh.face_verts[t] == mesh.face_verts[h])
+    {
+        return -1;
+    }
+    
+    return t;
+}
+
+} // anonymous namespace
+
+void build_adjacency (const mesh_data &mesh, mesh_adjacency &adj)
+{
+    adj.clear ();
+    
+    int nfaces = mesh.num_faces ();
+    int nverts = mesh.num_vertices ();
+    int nhalf = (int)mesh.face_verts.size ();
+    
+    adj.half_face.resize (nhalf);
+    adj.half_edge.resize (nhalf);
+    adj.half_twin.assign (nhalf, -1);
+    
+    // the higher vertex index of each half-edge, and the half-edges
+    // bucketed by their lower vertex index, counting then filling
+    std::vector<int> half_high (nhalf);
+    std::vector<int> bucket_start (nverts + 1, 0);
+    
+    for (int f = 0; f < nfaces; f++)
+    {
+        const int *verts = mesh.face (f);
+        int n = mesh.face_size (f);
+        int start = mesh.face_start[f];
+        
+        for (int k = 0; k < n; k++)
+        {
+            int a = verts[k];
+            int b = verts[(k + 1) % n];
+            
+            adj.half_face[start+k] = f;
+            half_high[start+k] = std::max (a, b);
+            bucket_start[std::min (a, b) + 1]++;
+        }
+    }
+    
+    for (int v = 0; v < nverts; v++)
+    {
+        bucket_start[v+1] += bucket_start[v];
+    }
+    
+    std::vector<int> bucket (nhalf);
+    std::vector<int> fill (bucket_start.begin (), bucket_start.end () - 1);
+    
+    for (int f = 0; f < nfaces; f++)
+    {
+        const int *verts = mesh.face (f);
+        int n = mesh.face_size (f);
+        int start = mesh.face_start[f];
+        
+        for (int k = 0; k < n; k++)
+        {
+            bucket[fill[std::min (verts[k], verts[(k + 1) % n])]++] = start + k;
+        }
+    }
+    
+    // within each bucket, half-edges with the same higher vertex lie on the
+    // same edge, sorting them numbers the edges in order of their vertices
+    // and keeps the faces of each edge in order
+    adj.edge_faces.reserve (nhalf);
+    
+    for (int a = 0; a < nverts; a++)
+    {
+        std::vector<int>::iterator first = bucket.begin () + bucket_start[a];
+        std::vector<int>::iterator last = bucket.begin () + bucket_start[a+1];
+        
+        std::sort (first, last, [&half_high] (int x, int y)
+        {
+            return (half_high[x] != half_high[y]) ? half_high[x] < half_high[y] : x < y;
+        });
+        
+        for (std::vector<int>::iterator it = first; it != last; )
+        {
+            int b = half_high[*it];
+            int e = adj.num_edges ();
+            std::vector<int>::iterator end = it;
+            
+            while (end != last && half_high[*end] == b)
+            {
+                adj.half_edge[*end] = e;
+                adj.edge_faces.push_back (adj.half_face[*end]);
+                ++end;
+            }
+            
+            adj.edge_verts.push_back (a);
+            adj.edge_verts.push_back (b);
+            adj.edge_face_start.push_back ((int)adj.edge_faces.size ());
+            
+            int uses = (int)(end - it);
+            
+            if (uses == 1)
+            {
+                adj.num_boundary_edges++;
+            }
+            else if (uses == 2)
+            {
+                adj.half_twin[it[0]] = it[1];
+                adj.half_twin[it[1]] = it[0];
+                
+                if (mesh.face_verts[it[0]] == mesh.face_verts[it[1]])
+                {
+                    adj.num_nonmanifold_edges++;
+                }
+            }
+            else
+            {
+                adj.num_nonmanifold_edges++;
+            }
+            
+            it = end;
+        }
+    }
+    
+    // count the fans of faces around each vertex, walking from each
+    // unvisited half-edge leaving a vertex to its neighbours in both
+    // directions across consistently oriented edges
+    std::vector<char> visited (nhalf, 0);
+    std::vector<int> fans (nverts, 0);
+    
+    for (int h = 0; h < nhalf; h++)
+    {
+        if (visited[h])
+        {
+            continue;
+        }
+        
+        int v = mesh.face_verts[h];
+        
+        if (++fans[v] == 2)
+        {
+            adj.num_nonmanifold_vertices++;
+        }
+        
+        visited[h] = 1;
+        
+        // the half-edge entering v in the same face, then across its edge
+        for (int c = h; ; )
+        {
+            int t = oriented_twin (mesh, adj, prev_half (mesh, adj, c));
+            
+            if (t < 0 || visited[t]) { break; }
+            
+            visited[t] = 1;
+            c = t;
+        }
+        
+        // across the edge of this half-edge, then the next in that face
+        for (int c = h; ; )
+        {
+            int t = oriented_twin (mesh, adj, c);
+            
+            if (t < 0) { break; }
+            
+            t = next_half (mesh, adj, t);
+            
+            if (visited[t]) { break; }
+            
+            visited[t] = 1;
+            c = t;
+        }
+    }
+}
+
+} // namespace mpolycsg
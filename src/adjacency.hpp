@@ -0,0 +1,86 @@
+/*
+   adjacency.hpp
+   
+   Edge and face adjacency of a mesh, stored as flat arrays indexed by
+   edge and by half-edge
+
+*/
+
+#ifndef __ADJACENCY_HPP__
+#define __ADJACENCY_HPP__
+
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// The topology of a face-vertex mesh. A half-edge is a corner of a face,
+// numbered as the vertex indices in mesh_data::face_verts, half-edge h of
+// face f runs from corner k to corner k+1 of the face. An edge is an
+// unordered pair of vertex indices used by one or more half-edges.
+class mesh_adjacency
+{
+public:
+    
+    mesh_adjacency () { clear (); }
+    
+    void clear ();
+    
+    int num_edges () const { return (int)(edge_face_start.size () - 1); }
+    
+    int num_half_edges () const { return (int)half_edge.size (); }
+    
+    // the face on the other side of half-edge h, -1 for a boundary or
+    // non-manifold edge
+    int neighbour (int h) const
+    {
+        return (half_twin[h] < 0) ? -1 : half_face[half_twin[h]];
+    }
+    
+    // every edge is used by one face, or by two faces with opposite
+    // orientations, and the faces around each vertex form a single fan
+    bool is_manifold () const
+    {
+        return num_nonmanifold_edges == 0 && num_nonmanifold_vertices == 0;
+    }
+    
+    // manifold with no boundary, i.e. watertight and consistently oriented
+    bool is_closed () const
+    {
+        return is_manifold () && num_boundary_edges == 0;
+    }
+    
+    // the two vertices of each edge, lower index first, the edges are
+    // sorted by their vertices
+    std::vector<int> edge_verts;
+    // offset of the first face of each edge in edge_faces, the last entry
+    // is the total length of edge_faces
+    std::vector<int> edge_face_start;
+    // the faces using each edge, in order, one after the other
+    std::vector<int> edge_faces;
+    
+    // for each half-edge, the edge it lies on, the face it belongs to and
+    // the other half-edge of the same edge when the edge is used exactly
+    // twice, otherwise -1
+    std::vector<int> half_edge;
+    std::vector<int> half_face;
+    std::vector<int> half_twin;
+    
+    // edges used by a single face
+    int num_boundary_edges;
+    // edges used by more than two faces, or twice in the same direction
+    int num_nonmanifold_edges;
+    // vertices whose faces form more than one fan, e.g. where two bodies
+    // touch at a point
+    int num_nonmanifold_vertices;
+    
+};
+
+// Build the adjacency of a mesh in linear time, bucketing the half-edges
+// by their lowest vertex index as face_components does.
+void build_adjacency (const mesh_data &mesh, mesh_adjacency &adjacency);
+
+} // namespace mpolycsg
+
+#endif // __ADJACENCY_HPP__
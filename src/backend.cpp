@@ -0,0 +1,198 @@
+/*
+   backend.cpp
+   
+   Selection of how boolean operations use the CSG kernel
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+
+#include "backend.hpp"
+#include "mesh_data.hpp"
+#include "stats.hpp"
+#include "triangulate.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+std::atomic<int> the_default_backend (backend_auto);
+
+std::atomic<double> the_snap_tolerance (1e-8);
+
+// extend the box lo, hi around the vertices of a mesh
+void add_extent (const mesh_data &mesh, double *lo, double *hi)
+{
+    for (size_t i = 0; i < mesh.coords.size (); i++)
+    {
+        lo[i % 3] = std::min (lo[i % 3], mesh.coords[i]);
+        hi[i % 3] = std::max (hi[i % 3], mesh.coords[i]);
+    }
+}
+
+// round the coordinates to multiples of grid, merge the vertices which 
+// then coincide and remove the triangles they collapse
+void snap_and_weld (mesh_data &mesh, double grid)
+{
+    int nverts = mesh.num_vertices ();
+    
+    for (size_t i = 0; i < mesh.coords.size (); i++)
+    {
+        // exact, grid is a power of two
+        mesh.coords[i] = std::round (mesh.coords[i] / grid) * grid;
+    }
+    
+    // the vertices sorted by their coordinates, each mapped to the first
+    // with the same coordinates
+    std::vector<int> order (nverts);
+    
+    for (int i = 0; i < nverts; i++) { order[i] = i; }
+    
+    const std::vector<double> &x = mesh.coords;
+    
+    std::sort (order.begin (), order.end (), [&x] (int a, int b)
+    {
+        return std::lexicographical_compare (&x[3*a], &x[3*a+3], &x[3*b], &x[3*b+3]);
+    });
+    
+    std::vector<int> merged (nverts);
+    std::vector<double> coords;
+    coords.reserve (x.size ());
+    
+    for (int i = 0; i < nverts; i++)
+    {
+        int v = order[i];
+        
+        if (i == 0 || !std::equal (&x[3*v], &x[3*v+3], &x[3*order[i-1]]))
+        {
+            coords.insert (coords.end (), &x[3*v], &x[3*v+3]);
+        }
+        
+        merged[v] = (int)(coords.size () / 3) - 1;
+    }
+    
+    mesh_data welded;
+    welded.coords.swap (coords);
+    welded.face_start.reserve (mesh.face_start.size ());
+    welded.face_verts.reserve (mesh.face_verts.size ());
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        const int *verts = mesh.face (f);
+        
+        int a = merged[verts[0]];
+        int b = merged[verts[1]];
+        int c = merged[verts[2]];
+        
+        if (a != b && b != c && c != a)
+        {
+            welded.add_triangle (a, b, c);
+        }
+    }
+    
+    mesh.coords.swap (welded.coords);
+    mesh.face_start.swap (welded.face_start);
+    mesh.face_verts.swap (welded.face_verts);
+}
+
+} // anonymous namespace
+
+void set_default_backend (csg_backend backend)
+{
+    the_default_backend = (backend == backend_default) ? backend_auto : backend;
+}
+
+csg_backend default_backend ()
+{
+    return (csg_backend)the_default_backend.load ();
+}
+
+const char* backend_name (csg_backend backend)
+{
+    switch (backend)
+    {
+        case backend_fast: return "fast";
+        case backend_robust: return "robust";
+        case backend_auto: return "auto";
+        case backend_isolated: return "isolated";
+        default: return backend_name (default_backend ());
+    }
+}
+
+void set_snap_tolerance (double tolerance)
+{
+    if (!(tolerance >= 0.0 && tolerance < 1.0))
+    {
+        throw std::invalid_argument ("The snap tolerance must be at least zero and less than one.");
+    }
+    
+    the_snap_tolerance = tolerance;
+}
+
+double snap_tolerance ()
+{
+    return the_snap_tolerance.load ();
+}
+
+bool parse_backend (const std::string &name, csg_backend &backend)
+{
+    if (name == "fast") { backend = backend_fast; }
+    else if (name == "robust") { backend = backend_robust; }
+    else if (name == "auto") { backend = backend_auto; }
+    else if (name == "isolated") { backend = backend_isolated; }
+    else { return false; }
+    
+    return true;
+}
+
+void condition_for_kernel (const polyhcsg::polyhedron &a, const polyhcsg::polyhedron &b, 
+                           polyhcsg::polyhedron &a_out, polyhcsg::polyhedron &b_out)
+{
+    scoped_timer timer ("kernel.condition");
+    timer.set_faces_in (a.num_faces () + b.num_faces ());
+    
+    mesh_data polys, ma, mb;
+    
+    polyhedron_to_mesh (a, polys);
+    triangulate_mesh (polys, ma);
+    
+    polyhedron_to_mesh (b, polys);
+    triangulate_mesh (polys, mb);
+    
+    // the same grid for both, so their features snap together
+    double lo[3], hi[3];
+    
+    for (int d = 0; d < 3; d++)
+    {
+        lo[d] = HUGE_VAL;
+        hi[d] = -HUGE_VAL;
+    }
+    
+    add_extent (ma, lo, hi);
+    add_extent (mb, lo, hi);
+    
+    double size = std::max (hi[0] - lo[0], std::max (hi[1] - lo[1], hi[2] - lo[2]));
+    double tolerance = snap_tolerance ();
+    
+    if (size > 0.0 && tolerance > 0.0)
+    {
+        // a power of two, so the rounding is exact
+        int exponent;
+        std::frexp (tolerance * size, &exponent);
+        
+        double grid = std::ldexp (1.0, exponent - 1);
+        
+        snap_and_weld (ma, grid);
+        snap_and_weld (mb, grid);
+    }
+    
+    timer.set_faces_out (ma.num_faces () + mb.num_faces ());
+    
+    mesh_to_polyhedron (ma, a_out);
+    mesh_to_polyhedron (mb, b_out);
+}
+
+} // namespace mpolycsg
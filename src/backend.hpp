@@ -0,0 +1,75 @@
+/*
+   backend.hpp
+   
+   Selection of how boolean operations use the CSG kernel
+
+*/
+
+#ifndef __BACKEND_HPP__
+#define __BACKEND_HPP__
+
+#include <string>
+
+#include "polyhcsg/polyhedron.h"
+
+namespace mpolycsg {
+
+// How a boolean operation is computed:
+//
+// backend_fast runs the pyPolyCSG kernel directly on the operands.
+//
+// backend_robust first conditions the operands for the kernel, see 
+// condition_for_kernel, which avoids most of the near degenerate 
+// configurations a floating point kernel fails on, at the cost of the 
+// conditioning and of the extra faces of the triangulation.
+//
+// backend_auto tries backend_fast and only if the kernel throws retries
+// with backend_robust.
+//
+// backend_isolated runs the operation as backend_auto does, but in a 
+// worker process, see worker_pool.hpp, so a crash of the kernel is 
+// reported as an error rather than ending the calling process.
+//
+// backend_default stands for the backend set with set_default_backend.
+enum csg_backend
+{
+    backend_default = -1,
+    backend_fast,
+    backend_robust,
+    backend_auto,
+    backend_isolated
+};
+
+// the backend used where backend_default is given, initially backend_auto
+void set_default_backend (csg_backend backend);
+csg_backend default_backend ();
+
+// "fast", "robust", "auto" or "isolated"
+const char* backend_name (csg_backend backend);
+
+// the backend with the given name, returns false if there is none
+bool parse_backend (const std::string &name, csg_backend &backend);
+
+// The spacing of the grid condition_for_kernel rounds coordinates to, as a
+// fraction of the largest side of the box around both operands, initially
+// 1e-8. It should be at least the tolerance of the kernel, so features the
+// kernel cannot tell apart are merged, and well below the size of the
+// smallest features which must be kept. Zero turns the conditioning off
+// apart from the triangulation. Throws std::invalid_argument unless the
+// tolerance is at least zero and less than one.
+void set_snap_tolerance (double tolerance);
+double snap_tolerance ();
+
+// Copies of two operands of a boolean operation prepared for the kernel: 
+// the faces are triangulated, the coordinates of both are rounded to a 
+// common grid, the largest power of two no more than snap_tolerance () of
+// the size of the operands, vertices which then coincide are merged, and
+// triangles collapsed by the merging are removed. Vertices closer than the
+// grid spacing are merged unless a grid line falls between them, so most
+// near coincidences between the operands become exact.
+void condition_for_kernel (const polyhcsg::polyhedron &a, const polyhcsg::polyhedron &b, 
+                           polyhcsg::polyhedron &a_out, polyhcsg::polyhedron &b_out);
+
+} // namespace mpolycsg
+
+#endif // __BACKEND_HPP__
@@ -0,0 +1,278 @@
+/*
+   components.cpp
+   
+   Connected components of a mesh
+
+*/
+
+#include <algorithm>
+
+#include "components.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// disjoint sets with union by size and path halving
+class union_find
+{
+public:
+    
+    union_find (int n) : parent_m(n), size_m(n, 1)
+    {
+        for (int i = 0; i < n; i++) { parent_m[i] = i; }
+    }
+    
+    int find (int x)
+    {
+        while (parent_m[x] != x)
+        {
+            parent_m[x] = parent_m[parent_m[x]];
+            x = parent_m[x];
+        }
+        
+        return x;
+    }
+    
+    void unite (int a, int b)
+    {
+        a = find (a);
+        b = find (b);
+        
+        if (a == b) { return; }
+        
+        if (size_m[a] < size_m[b]) { std::swap (a, b); }
+        
+        parent_m[b] = a;
+        size_m[a] += size_m[b];
+    }
+    
+private:
+    
+    std::vector<int> parent_m;
+    std::vector<int> size_m;
+    
+};
+
+// number the components in order of their first face
+int label_components (union_find &sets, int nfaces, std::vector<int> &component)
+{
+    std::vector<int> label (nfaces, -1);
+    int ncomponents = 0;
+    
+    for (int f = 0; f < nfaces; f++)
+    {
+        int root = sets.find (f);
+        
+        if (label[root] < 0)
+        {
+            label[root] = ncomponents++;
+        }
+        
+        component[f] = label[root];
+    }
+    
+    return ncomponents;
+}
+
+} // anonymous namespace
+
+int face_components (const mesh_data &mesh, std::vector<int> &component)
+{
+    int nfaces = mesh.num_faces ();
+    int nverts = mesh.num_vertices ();
+    
+    component.assign (nfaces, -1);
+    
+    if (nfaces == 0)
+    {
+        return 0;
+    }
+    
+    // bucket the edges by their lower vertex index, counting then filling
+    std::vector<int> bucket_start (nverts + 1, 0);
+    
+    for (int f = 0; f < nfaces; f++)
+    {
+        const int *verts = mesh.face (f);
+        int n = mesh.face_size (f);
+        
+        for (int k = 0; k < n; k++)
+        {
+            int a = verts[k];
+            int b = verts[(k + 1) % n];
+            
+            bucket_start[std::min (a, b) + 1]++;
+        }
+    }
+    
+    for (int v = 0; v < nverts; v++)
+    {
+        bucket_start[v+1] += bucket_start[v];
+    }
+    
+    // the higher vertex index and face of each edge
+    std::vector<int> edge_vert (bucket_start[nverts]);
+    std::vector<int> edge_face (bucket_start[nverts]);
+    std::vector<int> fill (bucket_start.begin (), bucket_start.end () - 1);
+    
+    for (int f = 0; f < nfaces; f++)
+    {
+        const int *verts = mesh.face (f);
+        int n = mesh.face_size (f);
+        
+        for (int k = 0; k < n; k++)
+        {
+            int a = verts[k];
+            int b = verts[(k + 1) % n];
+            
+            int e = fill[std::min (a, b)]++;
+            edge_vert[e] = std::max (a, b);
+            edge_face[e] = f;
+        }
+    }
+    
+    // join the faces of edges with the same vertices, within each bucket 
+    // the first face seen with each higher vertex is remembered, stamped
+    // with the bucket so the arrays never need clearing
+    union_find sets (nfaces);
+    
+    std::vector<int> stamp (nverts, -1);
+    std::vector<int> first_face (nverts);
+    
+    for (int a = 0; a < nverts; a++)
+    {
+        for (int e = bucket_start[a]; e < bucket_start[a+1]; e++)
+        {
+            int b = edge_vert[e];
+            
+            if (stamp[b] == a)
+            {
+                sets.unite (first_face[b], edge_face[e]);
+            }
+            else
+            {
+                stamp[b] = a;
+                first_face[b] = edge_face[e];
+            }
+        }
+    }
+    
+    return label_components (sets, nfaces, component);
+}
+
+int face_components (const mesh_adjacency &adjacency, int nfaces, std::vector<int> &component)
+{
+    component.assign (nfaces, -1);
+    
+    union_find sets (nfaces);
+    
+    for (int e = 0; e < adjacency.num_edges (); e++)
+    {
+        int first = adjacency.edge_face_start[e];
+        
+        for (int i = first + 1; i < adjacency.edge_face_start[e+1]; i++)
+        {
+            sets.unite (adjacency.edge_faces[first], adjacency.edge_faces[i]);
+        }
+    }
+    
+    return label_components (sets, nfaces, component);
+}
+
+void split_components (const mesh_data &mesh, std::vector<mesh_data> &parts)
+{
+    std::vector<int> component;
+    int ncomponents = face_components (mesh, component);
+    int nfaces = mesh.num_faces ();
+    
+    // the faces of each component, counting then filling
+    std::vector<int> part_start (ncomponents + 1, 0);
+    
+    for (int f = 0; f < nfaces; f++)
+    {
+        part_start[component[f] + 1]++;
+    }
+    
+    for (int c = 0; c < ncomponents; c++)
+    {
+        part_start[c+1] += part_start[c];
+    }
+    
+    std::vector<int> part_faces (nfaces);
+    std::vector<int> fill (part_start.begin (), part_start.end () - 1);
+    
+    for (int f = 0; f < nfaces; f++)
+    {
+        part_faces[fill[component[f]]++] = f;
+    }
+    
+    parts.assign (ncomponents, mesh_data ());
+    
+    // the index of each vertex in the part, stamped with the part, a 
+    // vertex joining components at a single point is copied to each
+    std::vector<int> stamp (mesh.num_vertices (), -1);
+    std::vector<int> new_index (mesh.num_vertices ());
+    std::vector<int> verts_used;
+    
+    for (int c = 0; c < ncomponents; c++)
+    {
+        mesh_data &part = parts[c];
+        
+        verts_used.clear ();
+        size_t nface_verts = 0;
+        
+        for (int i = part_start[c]; i < part_start[c+1]; i++)
+        {
+            int f = part_faces[i];
+            const int *verts = mesh.face (f);
+            int n = mesh.face_size (f);
+            
+            for (int k = 0; k < n; k++)
+            {
+                if (stamp[verts[k]] != c)
+                {
+                    stamp[verts[k]] = c;
+                    verts_used.push_back (verts[k]);
+                }
+            }
+            
+            nface_verts += n;
+        }
+        
+        // keep the original vertex order
+        std::sort (verts_used.begin (), verts_used.end ());
+        
+        part.coords.resize (3 * verts_used.size ());
+        
+        for (size_t i = 0; i < verts_used.size (); i++)
+        {
+            const double *x = mesh.vertex (verts_used[i]);
+            
+            part.coords[3*i] = x[0];
+            part.coords[3*i+1] = x[1];
+            part.coords[3*i+2] = x[2];
+            
+            new_index[verts_used[i]] = (int)i;
+        }
+        
+        part.face_start.reserve (part_start[c+1] - part_start[c] + 1);
+        part.face_verts.reserve (nface_verts);
+        
+        for (int i = part_start[c]; i < part_start[c+1]; i++)
+        {
+            int f = part_faces[i];
+            const int *verts = mesh.face (f);
+            int n = mesh.face_size (f);
+            
+            for (int k = 0; k < n; k++)
+            {
+                part.face_verts.push_back (new_index[verts[k]]);
+            }
+            
+            part.face_start.push_back ((int)part.face_verts.size ());
+        }
+    }
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,36 @@
+/*
+   components.hpp
+   
+   Connected components of a mesh
+
+*/
+
+#ifndef __COMPONENTS_HPP__
+#define __COMPONENTS_HPP__
+
+#include <vector>
+
+#include "adjacency.hpp"
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// Label each face of a mesh with the connected component it belongs to, 
+// faces are connected when they share an edge, i.e. a pair of vertex 
+// indices. Bodies touching at a single vertex are separate components. 
+// Components are numbered from zero in order of their first face. Returns
+// the number of components. Runs in near linear time, using a union-find 
+// over the faces with the edges bucketed by their lowest vertex index.
+int face_components (const mesh_data &mesh, std::vector<int> &component);
+
+// As above, from the already built adjacency of a mesh with nfaces faces.
+int face_components (const mesh_adjacency &adjacency, int nfaces, std::vector<int> &component);
+
+// Split a mesh into one mesh per connected component, ordered as labelled
+// by face_components. Each part contains only the vertices used by its 
+// faces, in their original order.
+void split_components (const mesh_data &mesh, std::vector<mesh_data> &parts);
+
+} // namespace mpolycsg
+
+#endif // __COMPONENTS_HPP__
@@ -0,0 +1,37 @@
+/*
+   csg_error.hpp
+   
+   Exception thrown by the mpolycsg engine. Each error carries an 
+   identifier of the form "CSG:operation" in addition to its message, which
+   the Matlab/Octave interface uses as the error identifier.
+
+*/
+
+#ifndef __CSG_ERROR_HPP__
+#define __CSG_ERROR_HPP__
+
+#include <stdexcept>
+#include <string>
+
+namespace mpolycsg {
+
+class csg_error : public std::runtime_error
+{
+public:
+    
+    csg_error (const std::string &id, const std::string &msg) 
+        : std::runtime_error (msg), id_m (id) {}
+    
+    ~csg_error () throw () {}
+    
+    const std::string& id () const { return id_m; }
+    
+private:
+    
+    std::string id_m;
+    
+};
+
+} // namespace mpolycsg
+
+#endif // __CSG_ERROR_HPP__
@@ -0,0 +1,536 @@
+/*
+   distance.cpp
+   
+   Distances between surfaces, by sampling one and finding the nearest
+   points of the other through a bounding volume hierarchy
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include "distance.hpp"
+#include "parallel.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// triangles in each leaf of the hierarchy
+const int LEAF_SIZE = 4;
+
+// below this many points per thread, threads cost more than they save
+const long MIN_CHUNK_POINTS = 1024;
+
+inline double dot (const double *a, const double *b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+inline double distance2 (const double *a, const double *b)
+{
+    double d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    
+    return dot (d, d);
+}
+
+// squared distance from p to the segment a b
+double segment_distance2 (const double *p, const double *a, const double *b)
+{
+    double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+    double len2 = dot (ab, ab);
+    double t = (len2 > 0.0) ? std::max (0.0, std::min (1.0, dot (ap, ab) / len2)) : 0.0;
+    double q[3] = { a[0] + t * ab[0], a[1] + t * ab[1], a[2] + t * ab[2] };
+    
+    return distance2 (p, q);
+}
+
+// squared distance from p to the triangle a b c, finding the region of the
+// triangle nearest p from the barycentric coordinates of its projection
+// (Ericson, Real-Time Collision Detection, 5.1.5)
+double triangle_distance2 (const double *p, const double *a, const double *b, const double *c)
+{
+    double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    double ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+    
+    double d1 = dot (ab, ap);
+    double d2 = dot (ac, ap);
+    
+    if (d1 <= 0.0 && d2 <= 0.0)
+    {
+        return distance2 (p, a);
+    }
+    
+    double bp[3] = { p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+    double d3 = dot (ab, bp);
+    double d4 = dot (ac, bp);
+    
+    if (d3 >= 0.0 && d4 <= d3)
+    {
+        return distance2 (p, b);
+    }
+    
+    double cp[3] = { p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+    double d5 = dot (ab, cp);
+    double d6 = dot (ac, cp);
+    
+    if (d6 >= 0.0 && d5 <= d6)
+    {
+        return distance2 (p, c);
+    }
+    
+    double vc = d1 * d4 - d3 * d2;
+    double vb = d5 * d2 - d1 * d6;
+    double va = d3 * d6 - d5 * d4;
+    
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+        return segment_distance2 (p, a, b);
+    }
+    
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+        return segment_distance2 (p, a, c);
+    }
+    
+    if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+    {
+        return segment_distance2 (p, b, c);
+    }
+    
+    double sum = va + vb + vc;
+    
+    // a degenerate triangle, nearest along one of its edges
+    if (!(sum > 0.0))
+    {
+        return std::min (segment_distance2 (p, a, b),
+                         std::min (segment_distance2 (p, b, c), segment_distance2 (p, a, c)));
+    }
+    
+    double v = vb / sum;
+    double w = vc / sum;
+    double q[3] = { a[0] + v * ab[0] + w * ac[0],
+                    a[1] + v * ab[1] + w * ac[1],
+                    a[2] + v * ab[2] + w * ac[2] };
+    
+    return distance2 (p, q);
+}
+
+void check_mesh (const mesh_data &tris)
+{
+    if (tris.num_faces () == 0)
+    {
+        throw std::invalid_argument ("Distances cannot be found to or from a polyhedron with no faces.");
+    }
+    
+    if (!tris.is_triangulated ())
+    {
+        throw std::invalid_argument ("The mesh must be triangulated to find distances.");
+    }
+}
+
+// the box around the vertices used by the faces of a mesh
+void surface_extent (const mesh_data &tris, double *lo, double *hi)
+{
+    for (int d = 0; d < 3; d++)
+    {
+        lo[d] = std::numeric_limits<double>::infinity ();
+        hi[d] = -std::numeric_limits<double>::infinity ();
+    }
+    
+    for (size_t i = 0; i < tris.face_verts.size (); i++)
+    {
+        const double *x = tris.vertex (tris.face_verts[i]);
+        
+        for (int d = 0; d < 3; d++)
+        {
+            lo[d] = std::min (lo[d], x[d]);
+            hi[d] = std::max (hi[d], x[d]);
+        }
+    }
+}
+
+// the directed deviation of the samples of one mesh from the other, added
+// to the totals
+void add_deviations (const mesh_data &from, const mesh_data &to, long nsamples, int num_threads,
+                     double &max, double &sum, double &sum2, long &count)
+{
+    triangle_bvh bvh (to);
+    
+    std::vector<double> points;
+    sample_surface (from, nsamples, points);
+    
+    std::vector<double> distances;
+    surface_distances (bvh, points, distances, num_threads);
+    
+    for (size_t i = 0; i < distances.size (); i++)
+    {
+        max = std::max (max, distances[i]);
+        sum += distances[i];
+        sum2 += distances[i] * distances[i];
+    }
+    
+    count += (long)distances.size ();
+}
+
+// whether every sample of one mesh is within tol of the other
+bool all_within (const mesh_data &from, const mesh_data &to, double tol, long nsamples, int num_threads)
+{
+    triangle_bvh bvh (to);
+    
+    std::vector<double> points;
+    sample_surface (from, nsamples, points);
+    
+    long npoints = (long)points.size () / 3;
+    int nchunks = num_work_chunks (npoints, MIN_CHUNK_POINTS, num_threads);
+    
+    std::atomic<bool> beyond (false);
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        long first = npoints * c / nchunks;
+        long last = npoints * (c + 1) / nchunks;
+        
+        for (long i = first; i < last && !beyond.load (std::memory_order_relaxed); i++)
+        {
+            if (bvh.distance (&points[3*i], tol) > tol)
+            {
+                beyond = true;
+            }
+        }
+    });
+    
+    return !beyond;
+}
+
+} // anonymous namespace
+
+triangle_bvh::triangle_bvh (const mesh_data &tris)
+    : tris_m(tris)
+{
+    int ntris = tris.num_faces ();
+    
+    order_m.resize (ntris);
+    std::vector<double> centroids (3 * ntris);
+    
+    for (int t = 0; t < ntris; t++)
+    {
+        const int *verts = tris.face (t);
+        
+        order_m[t] = t;
+        
+        for (int d = 0; d < 3; d++)
+        {
+            centroids[3*t+d] = (tris.vertex (verts[0])[d] + tris.vertex (verts[1])[d] + tris.vertex (verts[2])[d]) / 3.0;
+        }
+    }
+    
+    if (ntris > 0)
+    {
+        build (0, ntris, centroids);
+    }
+}
+
+int triangle_bvh::build (int first, int last, std::vector<double> &centroids)
+{
+    int node = (int)first_m.size ();
+    
+    first_m.push_back (first);
+    count_m.push_back (last - first);
+    
+    // the box of the triangles and of their centroids
+    double lo[3], hi[3], clo[3], chi[3];
+    
+    for (int d = 0; d < 3; d++)
+    {
+        lo[d] = clo[d] = std::numeric_limits<double>::infinity ();
+        hi[d] = chi[d] = -std::numeric_limits<double>::infinity ();
+    }
+    
+    for (int i = first; i < last; i++)
+    {
+        const int *verts = tris_m.face (order_m[i]);
+        
+        for (int d = 0; d < 3; d++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                lo[d] = std::min (lo[d], tris_m.vertex (verts[k])[d]);
+                hi[d] = std::max (hi[d], tris_m.vertex (verts[k])[d]);
+            }
+            
+            clo[d] = std::min (clo[d], centroids[3*order_m[i]+d]);
+            chi[d] = std::max (chi[d], centroids[3*order_m[i]+d]);
+        }
+    }
+    
+    box_min_m.insert (box_min_m.end (), lo, lo + 3);
+    box_max_m.insert (box_max_m.end (), hi, hi + 3);
+    
+    if (last - first <= LEAF_SIZE)
+    {
+        return node;
+    }
+    
+    // split at the median along the longest side of the centroids' box
+    int axis = 0;
+    
+    for (int d = 1; d < 3; d++)
+    {
+        if (chi[d] - clo[d] > chi[axis] - clo[axis])
+        {
+            axis = d;
+        }
+    }
+    
+    int mid = (first + last) / 2;
+    
+    std::nth_element (order_m.begin () + first, order_m.begin () + mid, order_m.begin () + last,
+                      [&centroids, axis] (int a, int b)
+    {
+        return centroids[3*a+axis] < centroids[3*b+axis];
+    });
+    
+    count_m[node] = 0;
+    
+    // building the children may move first_m, so the index of the second
+    // is stored afterwards
+    build (first, mid, centroids);
+    int second = build (mid, last, centroids);
+    
+    first_m[node] = second;
+    
+    return node;
+}
+
+double triangle_bvh::distance (const double *p, double stop_below) const
+{
+    double best = std::numeric_limits<double>::infinity ();
+    double stop = (stop_below > 0.0) ? stop_below * stop_below : -1.0;
+    
+    if (first_m.empty ())
+    {
+        return best;
+    }
+    
+    // squared distance from p to the box of a node
+    auto box_distance2 = [this, p] (int node)
+    {
+        double d2 = 0.0;
+        
+        for (int d = 0; d < 3; d++)
+        {
+            double lo = box_min_m[3*node+d] - p[d];
+            double hi = p[d] - box_max_m[3*node+d];
+            double out = std::max (0.0, std::max (lo, hi));
+            
+            d2 += out * out;
+        }
+        
+        return d2;
+    };
+    
+    // the depth of the tree is at most about log2 of the number of
+    // triangles, with at most one node waiting at each level
+    int stack[128];
+    int top = 0;
+    
+    stack[top++] = 0;
+    
+    while (top > 0)
+    {
+        int node = stack[--top];
+        
+        if (box_distance2 (node) >= best)
+        {
+            continue;
+        }
+        
+        if (count_m[node] > 0)
+        {
+            for (int i = first_m[node]; i < first_m[node] + count_m[node]; i++)
+            {
+                const int *verts = tris_m.face (order_m[i]);
+                
+                double d2 = triangle_distance2 (p, tris_m.vertex (verts[0]),
+                                                tris_m.vertex (verts[1]), tris_m.vertex (verts[2]));
+                
+                if (d2 < best)
+                {
+                    best = d2;
+                    
+                    if (best <= stop)
+                    {
+                        return std::sqrt (best);
+                    }
+                }
+            }
+            
+            continue;
+        }
+        
+        // visit the nearer child first
+        int left = node + 1;
+        int right = first_m[node];
+        
+        if (box_distance2 (left) <= box_distance2 (right))
+        {
+            std::swap (left, right);
+        }
+        
+        stack[top++] = left;
+        stack[top++] = right;
+    }
+    
+    return std::sqrt (best);
+}
+
+void sample_surface (const mesh_data &tris, long nsamples, std::vector<double> &points)
+{
+    int ntris = tris.num_faces ();
+    
+    points.clear ();
+    
+    // every vertex used by a face
+    std::vector<char> used (tris.num_vertices (), 0);
+    
+    for (size_t i = 0; i < tris.face_verts.size (); i++)
+    {
+        used[tris.face_verts[i]] = 1;
+    }
+    
+    for (int v = 0; v < tris.num_vertices (); v++)
+    {
+        if (used[v])
+        {
+            points.insert (points.end (), tris.vertex (v), tris.vertex (v) + 3);
+        }
+    }
+    
+    if (nsamples <= 0 || ntris == 0)
+    {
+        return;
+    }
+    
+    // the triangles are chosen at equal steps along their cumulative area,
+    // and the points within them at random with a fixed seed
+    std::vector<double> area (ntris + 1, 0.0);
+    
+    for (int t = 0; t < ntris; t++)
+    {
+        const int *verts = tris.face (t);
+        const double *a = tris.vertex (verts[0]);
+        const double *b = tris.vertex (verts[1]);
+        const double *c = tris.vertex (verts[2]);
+        
+        double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        double n[3] = { u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0] };
+        
+        area[t+1] = area[t] + 0.5 * std::sqrt (dot (n, n));
+    }
+    
+    if (!(area[ntris] > 0.0))
+    {
+        return;
+    }
+    
+    std::mt19937_64 rng (5489u);
+    std::uniform_real_distribution<double> uniform (0.0, 1.0);
+    
+    points.reserve (points.size () + 3 * nsamples);
+    
+    for (long s = 0; s < nsamples; s++)
+    {
+        double at = area[ntris] * (s + 0.5) / nsamples;
+        int t = (int)(std::upper_bound (area.begin () + 1, area.end (), at) - area.begin ()) - 1;
+        t = std::max (0, std::min (ntris - 1, t));
+        
+        const int *verts = tris.face (t);
+        const double *a = tris.vertex (verts[0]);
+        const double *b = tris.vertex (verts[1]);
+        const double *c = tris.vertex (verts[2]);
+        
+        // uniformly distributed barycentric coordinates
+        double r1 = std::sqrt (uniform (rng));
+        double r2 = uniform (rng);
+        double wa = 1.0 - r1;
+        double wb = r1 * (1.0 - r2);
+        double wc = r1 * r2;
+        
+        for (int d = 0; d < 3; d++)
+        {
+            points.push_back (wa * a[d] + wb * b[d] + wc * c[d]);
+        }
+    }
+}
+
+void surface_distances (const triangle_bvh &bvh, const std::vector<double> &points,
+                        std::vector<double> &distances, int num_threads)
+{
+    long npoints = (long)points.size () / 3;
+    int nchunks = num_work_chunks (npoints, MIN_CHUNK_POINTS, num_threads);
+    
+    distances.resize (npoints);
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        long first = npoints * c / nchunks;
+        long last = npoints * (c + 1) / nchunks;
+        
+        for (long i = first; i < last; i++)
+        {
+            distances[i] = bvh.distance (&points[3*i]);
+        }
+    });
+}
+
+void hausdorff_distance (const mesh_data &a, const mesh_data &b, long nsamples,
+                         deviation_stats &stats, int num_threads)
+{
+    check_mesh (a);
+    check_mesh (b);
+    
+    double max = 0.0, sum = 0.0, sum2 = 0.0;
+    long count = 0;
+    
+    add_deviations (a, b, nsamples, num_threads, max, sum, sum2, count);
+    add_deviations (b, a, nsamples, num_threads, max, sum, sum2, count);
+    
+    stats.max = max;
+    stats.mean = sum / count;
+    stats.rms = std::sqrt (sum2 / count);
+    stats.samples = count;
+}
+
+bool approx_equal (const mesh_data &a, const mesh_data &b, double tol, long nsamples, int num_threads)
+{
+    check_mesh (a);
+    check_mesh (b);
+    
+    // the Hausdorff distance is at least the difference between the
+    // extents of the two along each axis
+    double alo[3], ahi[3], blo[3], bhi[3];
+    
+    surface_extent (a, alo, ahi);
+    surface_extent (b, blo, bhi);
+    
+    for (int d = 0; d < 3; d++)
+    {
+        if (std::fabs (alo[d] - blo[d]) > tol || std::fabs (ahi[d] - bhi[d]) > tol)
+        {
+            return false;
+        }
+    }
+    
+    return all_within (a, b, tol, nsamples, num_threads)
+        && all_within (b, a, tol, nsamples, num_threads);
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,93 @@
+/*
+   distance.hpp
+   
+   Distances between surfaces, by sampling one and finding the nearest
+   points of the other through a bounding volume hierarchy
+
+*/
+
+#ifndef __DISTANCE_HPP__
+#define __DISTANCE_HPP__
+
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// A bounding volume hierarchy of the triangles of a mesh, for finding the
+// distance from a point to the nearest point of the surface. The boxes
+// are split at the median of their longest side, with up to four
+// triangles in each leaf. The nodes are stored depth first, the first
+// child of a node follows it.
+class triangle_bvh
+{
+public:
+    
+    // the mesh must be triangulated and must outlive the hierarchy
+    triangle_bvh (const mesh_data &tris);
+    
+    // the distance from p to the surface. If stop_below is positive the
+    // search stops at the first triangle closer than that, returning its
+    // distance, which is then not necessarily the smallest
+    double distance (const double *p, double stop_below=0.0) const;
+    
+private:
+    
+    int build (int first, int last, std::vector<double> &centroids);
+    
+    const mesh_data &tris_m;
+    
+    // the triangles, reordered so each node holds a contiguous range
+    std::vector<int> order_m;
+    
+    // per node, the box corners, the range of triangles for a leaf, or
+    // for an inner node the second child and a count of zero
+    std::vector<double> box_min_m;
+    std::vector<double> box_max_m;
+    std::vector<int> first_m;
+    std::vector<int> count_m;
+    
+};
+
+// The deviation of one surface from another at a set of sample points.
+class deviation_stats
+{
+public:
+    
+    deviation_stats () : max(0.0), mean(0.0), rms(0.0), samples(0) {}
+    
+    double max;
+    double mean;
+    double rms;
+    long samples;
+    
+};
+
+// Points on the surface of a triangle mesh, its vertices and nsamples
+// more points spread uniformly over its area. The points are always the
+// same for the same mesh and number of samples.
+void sample_surface (const mesh_data &tris, long nsamples, std::vector<double> &points);
+
+// The distance from each point, x, y, z triplets, to the surface, the
+// points are split between up to num_threads threads, zero for the
+// default.
+void surface_distances (const triangle_bvh &bvh, const std::vector<double> &points,
+                        std::vector<double> &distances, int num_threads=0);
+
+// The two sided Hausdorff distance between two triangle meshes, estimated
+// by sampling each with sample_surface and finding the distances of the
+// samples to the other surface. max is the Hausdorff distance, mean and
+// rms are over the samples of both. Throws std::invalid_argument if either
+// mesh has no faces or is not triangulated.
+void hausdorff_distance (const mesh_data &a, const mesh_data &b, long nsamples,
+                         deviation_stats &stats, int num_threads=0);
+
+// Whether the Hausdorff distance between two triangle meshes, estimated
+// as above, is at most tol, stopping as soon as a sample further away is
+// found.
+bool approx_equal (const mesh_data &a, const mesh_data &b, double tol, long nsamples, int num_threads=0);
+
+} // namespace mpolycsg
+
+#endif // __DISTANCE_HPP__
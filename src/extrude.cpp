@@ -0,0 +1,435 @@
+/*
+   extrude.cpp
+   
+   Extrusion of planar regions bounded by any number of loops
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "extrude.hpp"
+#include "triangulate.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+struct loop_info
+{
+    // index of the first vertex of the loop in the bottom layer
+    int first;
+    int size;
+    double area;
+    double bbox[4];
+    // number of loops containing this one, and the innermost of them
+    int depth;
+    int parent;
+};
+
+// twice the signed area of the 2D triangle a, b, c
+inline double area2 (const double *a, const double *b, const double *c)
+{
+    return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+double loop_area (const double *xy, int n)
+{
+    double a = 0.0;
+    
+    for (int i = 0; i < n; i++)
+    {
+        const double *p = &xy[2*i];
+        const double *q = &xy[2*((i + 1) % n)];
+        
+        a += p[0] * q[1] - q[0] * p[1];
+    }
+    
+    return 0.5 * a;
+}
+
+// crossing number test of a point against a loop
+bool point_in_loop (const double *p, const double *xy, int n)
+{
+    bool inside = false;
+    
+    for (int i = 0, j = n - 1; i < n; j = i++)
+    {
+        const double *a = &xy[2*i];
+        const double *b = &xy[2*j];
+        
+        if ((a[1] > p[1]) != (b[1] > p[1])
+            && p[0] < (b[0] - a[0]) * (p[1] - a[1]) / (b[1] - a[1]) + a[0])
+        {
+            inside = !inside;
+        }
+    }
+    
+    return inside;
+}
+
+// true if b is inside the interior angle of the counter-clockwise polygon 
+// at vertex a, with neighbours prev and next
+bool locally_inside (const double *prev, const double *a, const double *next, const double *b)
+{
+    if (area2 (prev, a, next) >= 0)
+    {
+        return area2 (a, next, b) >= 0 && area2 (prev, a, b) >= 0;
+    }
+    
+    return area2 (a, next, b) >= 0 || area2 (prev, a, b) >= 0;
+}
+
+// join a clockwise hole to a counter-clockwise outer polygon by a pair of
+// coincident edges, so the two can be triangulated as one polygon. The 
+// bridge runs from the rightmost vertex of the hole to a vertex of the 
+// outer polygon visible from it (D. Eberly, Triangulation by Ear Clipping)
+void bridge_hole (std::vector<int> &outer, const std::vector<int> &hole, const std::vector<double> &xy)
+{
+    size_t mi = 0;
+    
+    for (size_t i = 1; i < hole.size (); i++)
+    {
+        if (xy[2*hole[i]] > xy[2*hole[mi]])
+        {
+            mi = i;
+        }
+    }
+    
+    const double *m = &xy[2*hole[mi]];
+    size_t n = outer.size ();
+    
+    // the nearest intersection of the ray from m along +x with the outer
+    // polygon
+    double ix = std::numeric_limits<double>::infinity ();
+    size_t edge = n;
+    
+    for (size_t i = 0; i < n; i++)
+    {
+        const double *a = &xy[2*outer[i]];
+        const double *b = &xy[2*outer[(i + 1) % n]];
+        
+        // the ray leaves the interior through an edge going up, as the 
+        // polygon is counter-clockwise
+        if (!(a[1] <= m[1] && b[1] > m[1]))
+        {
+            continue;
+        }
+        
+        double x = a[0] + (m[1] - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+        
+        if (x >= m[0] && x < ix)
+        {
+            ix = x;
+            edge = i;
+        }
+    }
+    
+    if (edge == n)
+    {
+        throw std::invalid_argument ("Hole is not inside its outer boundary.");
+    }
+    
+    // the end of the edge furthest along the ray is visible from m unless 
+    // a reflex vertex lies in the triangle between m, the intersection and
+    // that vertex, in which case the one making the smallest angle with 
+    // the ray is used
+    size_t pi = (xy[2*outer[edge]] > xy[2*outer[(edge + 1) % n]]) ? edge : (edge + 1) % n;
+    const double *p = &xy[2*outer[pi]];
+    double inter[2] = { ix, m[1] };
+    
+    if (p[1] != m[1])
+    {
+        double best_tan = std::numeric_limits<double>::infinity ();
+        double best_dist = std::numeric_limits<double>::infinity ();
+        bool upper = p[1] > m[1];
+        
+        for (size_t i = 0; i < n; i++)
+        {
+            const double *r = &xy[2*outer[i]];
+            
+            if (i == pi || r[0] < m[0] || r[0] > std::max (ix, p[0]))
+            {
+                continue;
+            }
+            
+            const double *prev = &xy[2*outer[(i + n - 1) % n]];
+            const double *next = &xy[2*outer[(i + 1) % n]];
+            
+            if (area2 (prev, r, next) >= 0)
+            {
+                // convex
+                continue;
+            }
+            
+            bool inside = upper ? (area2 (m, inter, r) > 0 && area2 (inter, p, r) > 0 && area2 (p, m, r) > 0)
+                                : (area2 (m, p, r) > 0 && area2 (p, inter, r) > 0 && area2 (inter, m, r) > 0);
+            
+            if (!inside)
+            {
+                continue;
+            }
+            
+            double dx = r[0] - m[0];
+            double dy = std::fabs (r[1] - m[1]);
+            double t = (dx > 0) ? dy / dx : std::numeric_limits<double>::infinity ();
+            double d = dx * dx + dy * dy;
+            
+            if (t < best_tan || (t == best_tan && d < best_dist))
+            {
+                best_tan = t;
+                best_dist = d;
+                pi = i;
+            }
+        }
+    }
+    
+    // earlier bridges repeat vertices, choose the copy of the vertex whose
+    // interior angle contains the bridge
+    int pvert = outer[pi];
+    for (size_t i = 0; i < n; i++)
+    {
+        if (outer[i] == pvert
+            && locally_inside (&xy[2*outer[(i + n - 1) % n]], &xy[2*outer[i]], &xy[2*outer[(i + 1) % n]], m))
+        {
+            pi = i;
+            break;
+        }
+    }
+    
+    // outer up to p, round the hole from m back to m, then back to p
+    std::vector<int> merged;
+    merged.reserve (n + hole.size () + 2);
+    
+    merged.insert (merged.end (), outer.begin (), outer.begin () + pi + 1);
+    
+    for (size_t i = 0; i <= hole.size (); i++)
+    {
+        merged.push_back (hole[(mi + i) % hole.size ()]);
+    }
+    
+    merged.push_back (outer[pi]);
+    merged.insert (merged.end (), outer.begin () + pi + 1, outer.end ());
+    
+    outer.swap (merged);
+}
+
+} // anonymous namespace
+
+void region_cap (const std::vector< std::vector<double> > &loops, mesh_data &cap, 
+                 std::vector< std::vector<int> > &boundaries)
+{
+    cap.clear ();
+    
+    int nloops = (int)loops.size ();
+    
+    // the vertices of every loop one after the other
+    std::vector<double> xy;
+    std::vector<loop_info> info (nloops);
+    
+    for (int l = 0; l < nloops; l++)
+    {
+        int n = (int)(loops[l].size () / 2);
+        
+        loop_info &li = info[l];
+        
+        li.first = (int)(xy.size () / 2);
+        li.size = n;
+        li.area = (n >= 3) ? loop_area (&loops[l][0], n) : 0.0;
+        
+        if (li.area == 0.0)
+        {
+            throw std::invalid_argument ("Loops must have at least three vertices and non-zero area.");
+        }
+        
+        xy.insert (xy.end (), loops[l].begin (), loops[l].begin () + 2*n);
+        
+        li.bbox[0] = li.bbox[2] = xy[2*li.first];
+        li.bbox[1] = li.bbox[3] = xy[2*li.first+1];
+        
+        for (int i = 1; i < n; i++)
+        {
+            const double *p = &xy[2*(li.first + i)];
+            li.bbox[0] = std::min (li.bbox[0], p[0]);
+            li.bbox[1] = std::min (li.bbox[1], p[1]);
+            li.bbox[2] = std::max (li.bbox[2], p[0]);
+            li.bbox[3] = std::max (li.bbox[3], p[1]);
+        }
+    }
+    
+    // nesting, the loops don't cross so testing a single vertex of each 
+    // is enough
+    for (int l = 0; l < nloops; l++)
+    {
+        info[l].depth = 0;
+        info[l].parent = -1;
+        
+        const double *p = &xy[2*info[l].first];
+        
+        for (int k = 0; k < nloops; k++)
+        {
+            const loop_info &lk = info[k];
+            
+            if (k == l || std::fabs (lk.area) <= std::fabs (info[l].area)
+                || p[0] < lk.bbox[0] || p[0] > lk.bbox[2] 
+                || p[1] < lk.bbox[1] || p[1] > lk.bbox[3])
+            {
+                continue;
+            }
+            
+            if (point_in_loop (p, &xy[2*lk.first], lk.size))
+            {
+                info[l].depth++;
+                
+                // the innermost container is the smallest
+                if (info[l].parent < 0 || std::fabs (lk.area) < std::fabs (info[info[l].parent].area))
+                {
+                    info[l].parent = k;
+                }
+            }
+        }
+    }
+    
+    // the vertex order of each loop with the material on its left, outer
+    // boundaries counter-clockwise and holes clockwise
+    std::vector< std::vector<int> > &order = boundaries;
+    order.assign (nloops, std::vector<int> ());
+    
+    for (int l = 0; l < nloops; l++)
+    {
+        bool is_hole = (info[l].depth % 2) == 1;
+        bool reverse = is_hole ? (info[l].area > 0) : (info[l].area < 0);
+        
+        order[l].resize (info[l].size);
+        
+        for (int i = 0; i < info[l].size; i++)
+        {
+            order[l][i] = info[l].first + (reverse ? info[l].size - 1 - i : i);
+        }
+    }
+    
+    int nverts = (int)(xy.size () / 2);
+    
+    cap.coords.assign (3 * nverts, 0.0);
+    
+    for (int i = 0; i < nverts; i++)
+    {
+        cap.coords[3*i] = xy[2*i];
+        cap.coords[3*i+1] = xy[2*i+1];
+    }
+    
+    // one region per outer boundary with the holes directly inside it
+    std::vector<int> tris;
+    
+    for (int l = 0; l < nloops; l++)
+    {
+        if (info[l].depth % 2 == 1)
+        {
+            continue;
+        }
+        
+        std::vector<int> region = order[l];
+        
+        // holes are bridged in order of decreasing x so that each bridge 
+        // is to part of the boundary already merged
+        std::vector< std::pair<double, int> > holes;
+        
+        for (int k = 0; k < nloops; k++)
+        {
+            if (info[k].parent == l && info[k].depth % 2 == 1)
+            {
+                holes.push_back (std::make_pair (-info[k].bbox[2], k));
+            }
+        }
+        
+        std::sort (holes.begin (), holes.end ());
+        
+        for (size_t h = 0; h < holes.size (); h++)
+        {
+            bridge_hole (region, order[holes[h].second], xy);
+        }
+        
+        if (holes.empty ())
+        {
+            cap.add_face (&region[0], (int)region.size ());
+        }
+        else
+        {
+            tris.clear ();
+            triangulate_polygon (&cap.coords[0], &region[0], (int)region.size (), tris);
+            
+            for (size_t t = 0; t < tris.size (); t += 3)
+            {
+                cap.add_face (&tris[t], 3);
+            }
+        }
+    }
+}
+
+void extrude_region (const std::vector< std::vector<double> > &loops, double distance, mesh_data &mesh)
+{
+    mesh_data cap;
+    std::vector< std::vector<int> > order;
+    
+    region_cap (loops, cap, order);
+    
+    mesh.clear ();
+    
+    int nverts = cap.num_vertices ();
+    
+    double z0 = std::min (0.0, distance);
+    double z1 = std::max (0.0, distance);
+    
+    // a bottom and a top layer of vertices
+    mesh.coords.resize (6 * nverts);
+    
+    for (int i = 0; i < nverts; i++)
+    {
+        mesh.coords[3*i] = mesh.coords[3*(i + nverts)] = cap.coords[3*i];
+        mesh.coords[3*i+1] = mesh.coords[3*(i + nverts)+1] = cap.coords[3*i+1];
+        mesh.coords[3*i+2] = z0;
+        mesh.coords[3*(i + nverts)+2] = z1;
+    }
+    
+    // the caps, the bottom facing down
+    std::vector<int> face;
+    
+    for (int f = 0; f < cap.num_faces (); f++)
+    {
+        int n = cap.face_size (f);
+        const int *verts = cap.face (f);
+        
+        face.resize (n);
+        
+        for (int i = 0; i < n; i++)
+        {
+            face[i] = verts[n - 1 - i];
+        }
+        mesh.add_face (&face[0], n);
+        
+        for (int i = 0; i < n; i++)
+        {
+            face[i] = verts[i] + nverts;
+        }
+        mesh.add_face (&face[0], n);
+    }
+    
+    // the sides, a quadrilateral for each edge of every loop
+    for (size_t l = 0; l < order.size (); l++)
+    {
+        int n = (int)order[l].size ();
+        
+        for (int i = 0; i < n; i++)
+        {
+            int a = order[l][i];
+            int b = order[l][(i + 1) % n];
+            
+            int quad[4] = { a, b, b + nverts, a + nverts };
+            mesh.add_face (quad, 4);
+        }
+    }
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,42 @@
+/*
+   extrude.hpp
+   
+   Extrusion of planar regions bounded by any number of loops, e.g. an 
+   outer boundary with holes, or many separate profiles, directly to a 
+   mesh without any boolean operations
+
+*/
+
+#ifndef __EXTRUDE_HPP__
+#define __EXTRUDE_HPP__
+
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// Cover the region of the x-y plane bounded by a set of closed loops, 
+// nested as described for extrude_region. The cap receives the vertices of
+// all the loops one after the other at z = 0, and faces covering the 
+// region, counter-clockwise seen from +z: a single polygon for each outer 
+// boundary without holes, otherwise triangles. boundaries receives the 
+// vertex indices of each loop, ordered with the region on the left, so 
+// outer boundaries are counter-clockwise and holes clockwise.
+void region_cap (const std::vector< std::vector<double> > &loops, mesh_data &cap, 
+                 std::vector< std::vector<int> > &boundaries);
+
+// Extrude the region of the x-y plane bounded by a set of closed loops 
+// along z, from z = 0 to z = distance. Each loop is a list of x, y 
+// coordinate pairs, in either direction. 
+//
+// The loops must be simple and must not intersect each other, but may be
+// nested to any depth: a loop inside an odd number of other loops bounds a
+// hole, any other loop bounds solid material, so islands within holes are
+// also extruded. Caps with holes are triangulated, other caps are single 
+// polygons. Throws std::invalid_argument for degenerate loops.
+void extrude_region (const std::vector< std::vector<double> > &loops, double distance, mesh_data &mesh);
+
+} // namespace mpolycsg
+
+#endif // __EXTRUDE_HPP__
@@ -0,0 +1,114 @@
+/*
+   geometry_buffer.hpp
+   
+   Reference counted, copy-on-write storage for a polyhcsg::polyhedron, so
+   copies of a polyhedron share their geometry until one of them is 
+   modified, together with a cache of its adjacency which is dropped
+   whenever the geometry changes
+
+*/
+
+#ifndef __GEOMETRY_BUFFER_HPP__
+#define __GEOMETRY_BUFFER_HPP__
+
+#include <memory>
+
+#include "polyhcsg/polyhedron.h"
+
+namespace mpolycsg {
+
+class mesh_adjacency;
+
+class geometry_buffer
+{
+public:
+    
+    geometry_buffer () : data_m (std::make_shared<polyhcsg::polyhedron> ()) {}
+    
+    // read only access to the geometry, never copies
+    const polyhcsg::polyhedron& get () const { return *data_m; }
+    
+    // access for modifying the geometry in place, the geometry is first
+    // copied if it is shared with any other buffer
+    polyhcsg::polyhedron& edit ()
+    {
+        if (data_m.use_count () > 1)
+        {
+            data_m = std::make_shared<polyhcsg::polyhedron> (*data_m);
+        }
+        
+        drop_adjacency ();
+        
+        return *data_m;
+    }
+    
+    // detach from the current geometry and return a new empty polyhedron
+    // to be initialised, for methods which replace the geometry entirely
+    polyhcsg::polyhedron& reset ()
+    {
+        data_m = std::make_shared<polyhcsg::polyhedron> ();
+        drop_adjacency ();
+        
+        return *data_m;
+    }
+    
+    // replace the geometry with a copy of a polyhedron, typically the 
+    // result of an operation on the current geometry
+    void assign (const polyhcsg::polyhedron &ph)
+    {
+        data_m = std::make_shared<polyhcsg::polyhedron> (ph);
+        drop_adjacency ();
+    }
+    
+    // replace the geometry with a polyhedron which is not referenced 
+    // anywhere else, without copying it
+    void adopt (const std::shared_ptr<polyhcsg::polyhedron> &ph)
+    {
+        data_m = ph;
+        drop_adjacency ();
+    }
+    
+    // a reference to the current geometry which keeps it alive and 
+    // unchanged, whatever then happens to this buffer
+    std::shared_ptr<const polyhcsg::polyhedron> shared () const { return data_m; }
+    
+    // share the geometry of another buffer, O(1)
+    void share (const geometry_buffer &other)
+    {
+        data_m = other.data_m;
+        set_adjacency (other.adjacency ());
+    }
+    
+    // number of buffers sharing this geometry
+    long use_count () const { return data_m.use_count (); }
+    
+    // the adjacency of the current geometry, if it has been stored since 
+    // the geometry last changed, otherwise NULL. Safe to call from several
+    // threads reading the same buffer
+    std::shared_ptr<const mesh_adjacency> adjacency () const 
+    { 
+        return std::atomic_load (&adjacency_m); 
+    }
+    
+    void set_adjacency (const std::shared_ptr<const mesh_adjacency> &adjacency) const
+    {
+        std::atomic_store (&adjacency_m, adjacency);
+    }
+    
+private:
+    
+    void drop_adjacency ()
+    {
+        set_adjacency (std::shared_ptr<const mesh_adjacency> ());
+    }
+    
+    std::shared_ptr<polyhcsg::polyhedron> data_m;
+    
+    // built on demand from a const engine, so mutable
+    mutable std::shared_ptr<const mesh_adjacency> adjacency_m;
+    
+};
+
+} // namespace mpolycsg
+
+#endif // __GEOMETRY_BUFFER_HPP__
@@ -0,0 +1,803 @@
+/*
+   hull.cpp
+   
+   Convex hull of a set of points in 3D by quickhull
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "hull.hpp"
+#include "parallel.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// minimum number of points worth handing to a thread
+const long MIN_CHUNK_POINTS = 16384;
+
+////////////////////////   exact arithmetic   ////////////////////////
+
+// Expansions are sums of non-overlapping doubles in increasing order of
+// magnitude, representing a number exactly (Shewchuk, 1997)
+typedef std::vector<double> expansion;
+
+// x + y = a + b exactly
+inline void two_sum (double a, double b, double &x, double &y)
+{
+    x = a + b;
+    double bv = x - a;
+    double av = x - bv;
+    y = (a - av) + (b - bv);
+}
+
+// x + y = a - b exactly
+inline void two_diff (double a, double b, double &x, double &y)
+{
+    x = a - b;
+    double bv = a - x;
+    double av = x + bv;
+    y = (a - av) + (bv - b);
+}
+
+// x + y = a * b exactly
+inline void two_product (double a, double b, double &x, double &y)
+{
+    x = a * b;
+    y = std::fma (a, b, -x);
+}
+
+// e + b
+expansion grow (const expansion &e, double b)
+{
+    expansion h;
+    double q = b;
+    
+    for (size_t i = 0; i < e.size (); i++)
+    {
+        double x, y;
+        two_sum (q, e[i], x, y);
+        q = x;
+        
+        if (y != 0.0) { h.push_back (y); }
+    }
+    
+    if (q != 0.0) { h.push_back (q); }
+    
+    return h;
+}
+
+// e + f
+expansion sum (const expansion &e, const expansion &f)
+{
+    expansion h = e;
+    
+    for (size_t i = 0; i < f.size (); i++)
+    {
+        h = grow (h, f[i]);
+    }
+    
+    return h;
+}
+
+// e * b
+expansion scale (const expansion &e, double b)
+{
+    expansion h;
+    
+    if (e.empty () || b == 0.0)
+    {
+        return h;
+    }
+    
+    double q, lo;
+    two_product (e[0], b, q, lo);
+    
+    if (lo != 0.0) { h.push_back (lo); }
+    
+    for (size_t i = 1; i < e.size (); i++)
+    {
+        double p1, p0, s, t;
+        two_product (e[i], b, p1, p0);
+        two_sum (q, p0, s, t);
+        
+        if (t != 0.0) { h.push_back (t); }
+        
+        two_sum (p1, s, q, t);
+        
+        if (t != 0.0) { h.push_back (t); }
+    }
+    
+    if (q != 0.0) { h.push_back (q); }
+    
+    return h;
+}
+
+// e * f
+expansion product (const expansion &e, const expansion &f)
+{
+    expansion h;
+    
+    for (size_t i = 0; i < f.size (); i++)
+    {
+        h = sum (h, scale (e, f[i]));
+    }
+    
+    return h;
+}
+
+// a - b
+expansion difference (double a, double b)
+{
+    double x, y;
+    two_diff (a, b, x, y);
+    
+    expansion h;
+    if (y != 0.0) { h.push_back (y); }
+    if (x != 0.0) { h.push_back (x); }
+    
+    return h;
+}
+
+expansion negate (expansion e)
+{
+    for (size_t i = 0; i < e.size (); i++) { e[i] = -e[i]; }
+    
+    return e;
+}
+
+// the exact sign of (a - d) . ((b - d) x (c - d))
+double orient3d_exact (const double *a, const double *b, const double *c, const double *d)
+{
+    expansion ad[3], bd[3], cd[3];
+    
+    for (int k = 0; k < 3; k++)
+    {
+        ad[k] = difference (a[k], d[k]);
+        bd[k] = difference (b[k], d[k]);
+        cd[k] = difference (c[k], d[k]);
+    }
+    
+    // the components of (b - d) x (c - d)
+    expansion cx = sum (product (bd[1], cd[2]), negate (product (bd[2], cd[1])));
+    expansion cy = sum (product (bd[2], cd[0]), negate (product (bd[0], cd[2])));
+    expansion cz = sum (product (bd[0], cd[1]), negate (product (bd[1], cd[0])));
+    
+    expansion det = sum (sum (product (ad[0], cx), product (ad[1], cy)), product (ad[2], cz));
+    
+    // the largest component has the sign of the sum
+    return det.empty () ? 0.0 : det.back ();
+}
+
+////////////////////////   quickhull   ////////////////////////
+
+// a triangle of the hull, counter-clockwise seen from outside, adj[k] is
+// the face across the edge from v[k] to v[(k+1)%3]
+struct hull_face
+{
+    int v[3];
+    int adj[3];
+    // the points above the face which are not above any face before it,
+    // a list linked through quickhull::next_point_m, and the furthest of 
+    // them
+    int outside;
+    int furthest;
+    double furthest_height;
+    bool deleted;
+    // the last iteration which tested the visibility of the face
+    int visit;
+    bool visible;
+};
+
+class quickhull
+{
+public:
+    
+    quickhull (const std::vector<double> &points, int num_threads)
+        : points_m(points), npoints_m((int)(points.size () / 3)), num_threads_m(num_threads), 
+          iteration_m(0), next_point_m(npoints_m, -1) {}
+    
+    void run (mesh_data &mesh)
+    {
+        initial_simplex ();
+        
+        // faces given outside points are queued, by the time they are
+        // reached they may have been removed, or their slot reused
+        while (!pending_m.empty ())
+        {
+            int f = pending_m.back ();
+            pending_m.pop_back ();
+            
+            if (!faces_m[f].deleted && faces_m[f].outside >= 0)
+            {
+                add_point (f);
+            }
+        }
+        
+        output (mesh);
+    }
+
+private:
+    
+    const double* point (int i) const { return &points_m[3*i]; }
+    
+    // height of point p above face f, with the correct sign
+    double height (int f, int p) const
+    {
+        const hull_face &face = faces_m[f];
+        
+        return orient3d (point (face.v[0]), point (face.v[1]), point (face.v[2]), point (p));
+    }
+    
+    int add_face (int a, int b, int c)
+    {
+        // reuse the slot of a removed face if there is one
+        int f;
+        
+        if (free_faces_m.empty ())
+        {
+            f = (int)faces_m.size ();
+            faces_m.push_back (hull_face ());
+        }
+        else
+        {
+            f = free_faces_m.back ();
+            free_faces_m.pop_back ();
+        }
+        
+        hull_face &face = faces_m[f];
+        face.v[0] = a;
+        face.v[1] = b;
+        face.v[2] = c;
+        face.adj[0] = face.adj[1] = face.adj[2] = -1;
+        face.furthest = -1;
+        face.furthest_height = 0.0;
+        face.deleted = false;
+        face.visit = -1;
+        face.visible = false;
+        face.outside = -1;
+        
+        return f;
+    }
+    
+    void initial_simplex ()
+    {
+        if (npoints_m < 4)
+        {
+            throw std::invalid_argument ("At least four points are needed to form a convex hull.");
+        }
+        
+        // the most distant pair of the extreme points along the axes
+        int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+        
+        for (int i = 1; i < npoints_m; i++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                if (point (i)[k] < point (extremes[2*k])[k]) { extremes[2*k] = i; }
+                if (point (i)[k] > point (extremes[2*k+1])[k]) { extremes[2*k+1] = i; }
+            }
+        }
+        
+        int a = 0, b = 0;
+        double maxdist = 0.0;
+        
+        for (int i = 0; i < 6; i++)
+        {
+            for (int j = i + 1; j < 6; j++)
+            {
+                double dist = distance2 (point (extremes[i]), point (extremes[j]));
+                
+                if (dist > maxdist)
+                {
+                    maxdist = dist;
+                    a = extremes[i];
+                    b = extremes[j];
+                }
+            }
+        }
+        
+        // the point furthest from the line through them
+        int c = -1;
+        double maxarea = 0.0;
+        
+        for (int i = 0; i < npoints_m; i++)
+        {
+            double ab[3], ai[3], n[3];
+            sub (point (b), point (a), ab);
+            sub (point (i), point (a), ai);
+            cross (ab, ai, n);
+            
+            double area = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+            
+            if (area > maxarea)
+            {
+                maxarea = area;
+                c = i;
+            }
+        }
+        
+        // the point furthest from the plane through all three, or if they
+        // all appear to be on it, any point which is exactly off it
+        int d = -1;
+        double maxheight = 0.0;
+        
+        if (c >= 0)
+        {
+            for (int i = 0; i < npoints_m; i++)
+            {
+                double h = std::fabs (orient3d (point (a), point (b), point (c), point (i)));
+                
+                if (h > maxheight)
+                {
+                    maxheight = h;
+                    d = i;
+                }
+            }
+        }
+        
+        if (d < 0)
+        {
+            throw std::invalid_argument ("The points are coplanar, their convex hull has no volume.");
+        }
+        
+        // each face with the remaining vertex below it
+        int tets[4][4] = { {a, b, c, d}, {a, d, b, c}, {b, d, c, a}, {a, c, d, b} };
+        
+        for (int t = 0; t < 4; t++)
+        {
+            if (orient3d (point (tets[t][0]), point (tets[t][1]), point (tets[t][2]), point (tets[t][3])) > 0)
+            {
+                std::swap (tets[t][1], tets[t][2]);
+            }
+            
+            add_face (tets[t][0], tets[t][1], tets[t][2]);
+        }
+        
+        // link the faces across their shared edges
+        for (int f = 0; f < 4; f++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                int p = faces_m[f].v[k];
+                int q = faces_m[f].v[(k + 1) % 3];
+                
+                for (int g = 0; g < 4; g++)
+                {
+                    for (int j = 0; j < 3; j++)
+                    {
+                        if (faces_m[g].v[j] == q && faces_m[g].v[(j + 1) % 3] == p)
+                        {
+                            faces_m[f].adj[k] = g;
+                        }
+                    }
+                }
+            }
+        }
+        
+        // all the other points which are outside
+        std::vector<int> candidates;
+        candidates.reserve (npoints_m);
+        
+        for (int i = 0; i < npoints_m; i++)
+        {
+            if (i != a && i != b && i != c && i != d)
+            {
+                candidates.push_back (i);
+            }
+        }
+        
+        int new_faces[4] = { 0, 1, 2, 3 };
+        assign_points (candidates, new_faces, 4);
+    }
+    
+    // give each candidate point to the first of the faces it is above,
+    // deciding for every point in parallel then distributing in order so
+    // the result does not depend on the number of threads
+    void assign_points (const std::vector<int> &candidates, const int *new_faces, int nfaces)
+    {
+        long n = (long)candidates.size ();
+        
+        assignment_m.resize (n);
+        heights_m.resize (n);
+        
+        int nchunks = num_work_chunks (n, MIN_CHUNK_POINTS, num_threads_m);
+        
+        if (nchunks > 1)
+        {
+            parallel_for_chunks (nchunks, [&] (int chunk)
+            {
+                find_faces (candidates, n * chunk / nchunks, n * (chunk + 1) / nchunks, new_faces, nfaces);
+            });
+        }
+        else
+        {
+            // most of the time only a few points move
+            find_faces (candidates, 0, n, new_faces, nfaces);
+        }
+        
+        for (long i = 0; i < n; i++)
+        {
+            if (assignment_m[i] < 0)
+            {
+                continue;
+            }
+            
+            hull_face &face = faces_m[assignment_m[i]];
+            
+            if (face.outside < 0)
+            {
+                pending_m.push_back (assignment_m[i]);
+            }
+            
+            next_point_m[candidates[i]] = face.outside;
+            face.outside = candidates[i];
+            
+            if (face.furthest < 0 || heights_m[i] > face.furthest_height)
+            {
+                face.furthest = candidates[i];
+                face.furthest_height = heights_m[i];
+            }
+        }
+    }
+    
+    // the first of the faces each candidate from first to last is above
+    void find_faces (const std::vector<int> &candidates, long first, long last, const int *new_faces, int nfaces)
+    {
+        for (long i = first; i < last; i++)
+        {
+            assignment_m[i] = -1;
+            
+            for (int j = 0; j < nfaces; j++)
+            {
+                double h = height (new_faces[j], candidates[i]);
+                
+                if (h > 0)
+                {
+                    assignment_m[i] = new_faces[j];
+                    heights_m[i] = h;
+                    break;
+                }
+            }
+        }
+    }
+    
+    // add the furthest point above face f to the hull
+    void add_point (int f)
+    {
+        int eye = faces_m[f].furthest;
+        iteration_m++;
+        
+        // the faces the point can see, spreading from f, and the edges of
+        // the horizon between them and the rest, as the start vertex, end
+        // vertex and face on the far side of each
+        std::vector<int> &visible = visible_m;
+        std::vector<int> &horizon = horizon_m;
+        std::vector<int> &stack = stack_m;
+        
+        visible.clear ();
+        horizon.clear ();
+        stack.assign (1, f);
+        
+        faces_m[f].visit = iteration_m;
+        faces_m[f].visible = true;
+        
+        while (!stack.empty ())
+        {
+            int g = stack.back ();
+            stack.pop_back ();
+            visible.push_back (g);
+            
+            for (int k = 0; k < 3; k++)
+            {
+                int n = faces_m[g].adj[k];
+                
+                if (faces_m[n].visit != iteration_m)
+                {
+                    faces_m[n].visit = iteration_m;
+                    faces_m[n].visible = height (n, eye) > 0;
+                    
+                    if (faces_m[n].visible)
+                    {
+                        stack.push_back (n);
+                    }
+                }
+                
+                if (!faces_m[n].visible)
+                {
+                    horizon.push_back (faces_m[g].v[k]);
+                    horizon.push_back (faces_m[g].v[(k + 1) % 3]);
+                    horizon.push_back (n);
+                }
+            }
+        }
+        
+        // the points outside the faces removed may be outside the new ones,
+        // the slots of the faces are reused for the new ones
+        std::vector<int> &candidates = candidates_m;
+        candidates.clear ();
+        
+        for (size_t i = 0; i < visible.size (); i++)
+        {
+            hull_face &face = faces_m[visible[i]];
+            
+            for (int p = face.outside; p >= 0; p = next_point_m[p])
+            {
+                if (p != eye)
+                {
+                    candidates.push_back (p);
+                }
+            }
+            
+            face.deleted = true;
+            free_faces_m.push_back (visible[i]);
+        }
+        
+        // a cone of new faces from the horizon to the point
+        size_t nhorizon = horizon.size () / 3;
+        std::vector<int> &new_faces = new_faces_m;
+        new_faces.resize (nhorizon);
+        
+        if (vertex_face_m.empty ())
+        {
+            vertex_face_m.assign (npoints_m, -1);
+        }
+        
+        for (size_t e = 0; e < nhorizon; e++)
+        {
+            int a = horizon[3*e];
+            int b = horizon[3*e+1];
+            int n = horizon[3*e+2];
+            
+            int g = add_face (a, b, eye);
+            new_faces[e] = g;
+            
+            // the face beyond the horizon now borders the new face
+            faces_m[g].adj[0] = n;
+            
+            for (int k = 0; k < 3; k++)
+            {
+                if (faces_m[n].v[k] == b && faces_m[n].v[(k + 1) % 3] == a)
+                {
+                    faces_m[n].adj[k] = g;
+                }
+            }
+            
+            // the new face starting at each horizon vertex
+            vertex_face_m[a] = g;
+        }
+        
+        // the new faces border each other across the edges to the point,
+        // the face from a to b meets the one starting at b
+        for (size_t e = 0; e < nhorizon; e++)
+        {
+            int g = new_faces[e];
+            int h = vertex_face_m[faces_m[g].v[1]];
+            
+            faces_m[g].adj[1] = h;
+            faces_m[h].adj[2] = g;
+        }
+        
+        assign_points (candidates, &new_faces[0], (int)nhorizon);
+    }
+    
+    // the hull as a mesh, with the vertices renumbered in their original
+    // order and coplanar neighbouring triangles merged
+    void output (mesh_data &mesh)
+    {
+        mesh.clear ();
+        
+        int nfaces = (int)faces_m.size ();
+        
+        // the groups of coplanar faces, by flood fill across edges where the
+        // far vertex of the neighbour is exactly on the plane
+        std::vector<int> group (nfaces, -1);
+        std::vector<int> group_faces;
+        std::vector<int> group_start;
+        std::vector<char> on_hull (npoints_m, 0);
+        
+        for (int f = 0; f < nfaces; f++)
+        {
+            if (faces_m[f].deleted || group[f] >= 0)
+            {
+                continue;
+            }
+            
+            int g = (int)group_start.size ();
+            group_start.push_back ((int)group_faces.size ());
+            group[f] = g;
+            
+            std::vector<int> stack (1, f);
+            
+            while (!stack.empty ())
+            {
+                int h = stack.back ();
+                stack.pop_back ();
+                group_faces.push_back (h);
+                
+                for (int k = 0; k < 3; k++)
+                {
+                    on_hull[faces_m[h].v[k]] = 1;
+                    
+                    int n = faces_m[h].adj[k];
+                    
+                    if (group[n] < 0 && height (f, far_vertex (h, k)) == 0.0)
+                    {
+                        group[n] = g;
+                        stack.push_back (n);
+                    }
+                }
+            }
+        }
+        
+        group_start.push_back ((int)group_faces.size ());
+        
+        // the vertices in their original order
+        std::vector<int> new_index (npoints_m, -1);
+        
+        for (int i = 0; i < npoints_m; i++)
+        {
+            if (on_hull[i])
+            {
+                new_index[i] = mesh.add_vertex (point (i)[0], point (i)[1], point (i)[2]);
+            }
+        }
+        
+        // the boundary of each group, a convex polygon, as the next vertex
+        // after each
+        std::vector<int> next (npoints_m, -1);
+        std::vector<int> polygon;
+        
+        for (size_t g = 0; g + 1 < group_start.size (); g++)
+        {
+            int nedges = 0;
+            int start = -1;
+            
+            for (int i = group_start[g]; i < group_start[g+1]; i++)
+            {
+                const hull_face &face = faces_m[group_faces[i]];
+                
+                for (int k = 0; k < 3; k++)
+                {
+                    if (group[face.adj[k]] != (int)g)
+                    {
+                        next[face.v[k]] = face.v[(k + 1) % 3];
+                        start = face.v[k];
+                        nedges++;
+                    }
+                }
+            }
+            
+            polygon.clear ();
+            int v = start;
+            
+            for (int i = 0; i < nedges && v >= 0; i++)
+            {
+                polygon.push_back (new_index[v]);
+                v = next[v];
+                
+                if (v == start) { break; }
+            }
+            
+            if ((int)polygon.size () == nedges && v == start)
+            {
+                mesh.add_face (&polygon[0], nedges);
+            }
+            else
+            {
+                // not a single loop, keep the triangles
+                for (int i = group_start[g]; i < group_start[g+1]; i++)
+                {
+                    const hull_face &face = faces_m[group_faces[i]];
+                    mesh.add_triangle (new_index[face.v[0]], new_index[face.v[1]], new_index[face.v[2]]);
+                }
+            }
+        }
+    }
+    
+    // the vertex of the neighbour across edge k of face f not on the edge
+    int far_vertex (int f, int k) const
+    {
+        const hull_face &face = faces_m[f];
+        const hull_face &other = faces_m[face.adj[k]];
+        
+        for (int j = 0; j < 3; j++)
+        {
+            if (other.v[j] != face.v[k] && other.v[j] != face.v[(k + 1) % 3])
+            {
+                return other.v[j];
+            }
+        }
+        
+        return other.v[0];
+    }
+    
+    static double distance2 (const double *a, const double *b)
+    {
+        double d[3];
+        sub (a, b, d);
+        
+        return d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+    }
+    
+    static void sub (const double *a, const double *b, double *r)
+    {
+        r[0] = a[0] - b[0];
+        r[1] = a[1] - b[1];
+        r[2] = a[2] - b[2];
+    }
+    
+    static void cross (const double *a, const double *b, double *r)
+    {
+        r[0] = a[1]*b[2] - a[2]*b[1];
+        r[1] = a[2]*b[0] - a[0]*b[2];
+        r[2] = a[0]*b[1] - a[1]*b[0];
+    }
+    
+    const std::vector<double> &points_m;
+    int npoints_m;
+    int num_threads_m;
+    
+    std::vector<hull_face> faces_m;
+    int iteration_m;
+    
+    // the next point in the outside list of the face each point is above
+    std::vector<int> next_point_m;
+    
+    // scratch space, reused from one point to the next
+    std::vector<int> assignment_m;
+    std::vector<double> heights_m;
+    std::vector<int> vertex_face_m;
+    std::vector<int> visible_m;
+    std::vector<int> horizon_m;
+    std::vector<int> stack_m;
+    std::vector<int> new_faces_m;
+    std::vector<int> candidates_m;
+    std::vector<int> free_faces_m;
+    std::vector<int> pending_m;
+    
+};
+    
+} // anonymous namespace
+
+double orient3d (const double *a, const double *b, const double *c, const double *d)
+{
+    double adx = a[0] - d[0], bdx = b[0] - d[0], cdx = c[0] - d[0];
+    double ady = a[1] - d[1], bdy = b[1] - d[1], cdy = c[1] - d[1];
+    double adz = a[2] - d[2], bdz = b[2] - d[2], cdz = c[2] - d[2];
+    
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+    
+    double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+    
+    double permanent = (std::fabs (bdxcdy) + std::fabs (cdxbdy)) * std::fabs (adz)
+                     + (std::fabs (cdxady) + std::fabs (adxcdy)) * std::fabs (bdz)
+                     + (std::fabs (adxbdy) + std::fabs (bdxady)) * std::fabs (cdz);
+    
+    // Shewchuk's bound on the error of the floating point evaluation
+    const double eps = std::numeric_limits<double>::epsilon () / 2.0;
+    const double errbound = (7.0 + 56.0 * eps) * eps;
+    
+    // det is positive with d below the plane, the opposite of the result
+    if (det > errbound * permanent || -det > errbound * permanent)
+    {
+        return -det;
+    }
+    
+    return -orient3d_exact (a, b, c, d);
+}
+
+void convex_hull (const std::vector<double> &points, mesh_data &mesh, int num_threads)
+{
+    quickhull hull (points, num_threads);
+    
+    hull.run (mesh);
+}
+    
+} // namespace mpolycsg
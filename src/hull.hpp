@@ -0,0 +1,37 @@
+/*
+   hull.hpp
+   
+   Convex hull of a set of points in 3D
+
+*/
+
+#ifndef __HULL_HPP__
+#define __HULL_HPP__
+
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// Orientation of the point d relative to the plane through a, b and c,
+// positive if d lies above the plane, where a, b, c appear counter-clockwise,
+// negative if below, zero if the four points are coplanar. The sign is
+// always correct, the value is computed in floating point and only
+// evaluated exactly when it is too close to zero to be trusted (Shewchuk,
+// 1997). Away from zero it is six times the volume of the tetrahedron.
+double orient3d (const double *a, const double *b, const double *c, const double *d);
+
+// Convex hull of points given as x, y, z triplets, by quickhull, with all
+// the orientation tests exact. The points outside each new face are found
+// in parallel using up to num_threads threads, zero for the default. The
+// mesh contains only the hull vertices, in the order they appear in the
+// points, with coplanar triangles merged into convex polygons facing
+// outwards. Points exactly on the hull between its corners may be kept as
+// vertices. Throws std::invalid_argument if the points are coplanar, so
+// the hull has no volume.
+void convex_hull (const std::vector<double> &points, mesh_data &mesh, int num_threads=0);
+
+} // namespace mpolycsg
+
+#endif // __HULL_HPP__
@@ -0,0 +1,717 @@
+/*
+   interference.cpp
+   
+   Clashes between the parts of an assembly, found without boolean
+   operations, by a sweep and prune over the bounding boxes of the parts
+   followed by triangle against triangle tests for the pairs whose boxes
+   overlap
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "interference.hpp"
+#include "parallel.hpp"
+#include "voxelize.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+inline double dot (const double *a, const double *b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+inline void cross (const double *a, const double *b, double *c)
+{
+    c[0] = a[1] * b[2] - a[2] * b[1];
+    c[1] = a[2] * b[0] - a[0] * b[2];
+    c[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// the box around a part and around each of its triangles, three values
+// per triangle in tri_lo and tri_hi
+class part_boxes
+{
+public:
+    
+    part_boxes ()
+    {
+        for (int d = 0; d < 3; d++)
+        {
+            lo[d] = std::numeric_limits<double>::infinity ();
+            hi[d] = -std::numeric_limits<double>::infinity ();
+        }
+    }
+    
+    bool empty () const { return lo[0] > hi[0]; }
+    
+    double lo[3];
+    double hi[3];
+    std::vector<double> tri_lo;
+    std::vector<double> tri_hi;
+    
+};
+
+void find_boxes (const mesh_data &tris, part_boxes &boxes)
+{
+    int ntris = tris.num_faces ();
+    
+    boxes.tri_lo.resize (3 * ntris);
+    boxes.tri_hi.resize (3 * ntris);
+    
+    for (int t = 0; t < ntris; t++)
+    {
+        const int *verts = tris.face (t);
+        
+        for (int d = 0; d < 3; d++)
+        {
+            double x0 = tris.coords[3*verts[0]+d];
+            double x1 = tris.coords[3*verts[1]+d];
+            double x2 = tris.coords[3*verts[2]+d];
+            
+            boxes.tri_lo[3*t+d] = std::min (x0, std::min (x1, x2));
+            boxes.tri_hi[3*t+d] = std::max (x0, std::max (x1, x2));
+            
+            boxes.lo[d] = std::min (boxes.lo[d], boxes.tri_lo[3*t+d]);
+            boxes.hi[d] = std::max (boxes.hi[d], boxes.tri_hi[3*t+d]);
+        }
+    }
+}
+
+// The extent along the line where the planes of two triangles meet of
+// a triangle crossing the other's plane, from the points where its edges
+// cross the plane, given the signed distances dist of its vertices from
+// the plane and their positions proj along the line.
+void plane_interval (const double *dist, const double *proj, double &lo, double &hi)
+{
+    lo = std::numeric_limits<double>::infinity ();
+    hi = -std::numeric_limits<double>::infinity ();
+    
+    for (int i = 0; i < 3; i++)
+    {
+        int j = (i + 1) % 3;
+        
+        if (dist[i] == 0.0)
+        {
+            lo = std::min (lo, proj[i]);
+            hi = std::max (hi, proj[i]);
+        }
+        
+        if ((dist[i] < 0.0 && dist[j] > 0.0) || (dist[i] > 0.0 && dist[j] < 0.0))
+        {
+            double x = proj[i] + (proj[j] - proj[i]) * dist[i] / (dist[i] - dist[j]);
+            
+            lo = std::min (lo, x);
+            hi = std::max (hi, x);
+        }
+    }
+}
+
+// distances from a plane within this fraction of the size of the triangles
+// are taken as zero, so faces which share a plane but whose vertices are
+// rounded differently are still found to lie in it
+const double COPLANAR_TOLERANCE = 1e-12;
+
+// the signed distances, scaled by the length of normal, of the vertices of
+// u from the plane of v with the given normal, those lost in the rounding
+// set to zero
+void plane_distances (const double *const *u, const double *const *v, const double *normal, double *dist)
+{
+    double size = 0.0;
+    
+    for (int i = 0; i < 3; i++)
+    {
+        double r[3] = { u[i][0] - v[0][0], u[i][1] - v[0][1], u[i][2] - v[0][2] };
+        
+        dist[i] = dot (normal, r);
+        size = std::max (size, dot (r, r));
+    }
+    
+    double tol = COPLANAR_TOLERANCE * std::sqrt (dot (normal, normal) * size);
+    
+    for (int i = 0; i < 3; i++)
+    {
+        if (std::fabs (dist[i]) <= tol)
+        {
+            dist[i] = 0.0;
+        }
+    }
+}
+
+// Whether the interiors of two triangles in the same plane, with normal,
+// overlap, from their projections onto the coordinate plane closest to
+// theirs. Convex polygons are apart when an edge of one has all of the
+// other on its outer side, touching edges and vertices do not overlap.
+bool coplanar_overlap (const double *const *u, const double *const *v, const double *normal)
+{
+    int axis = 0;
+    
+    for (int d = 1; d < 3; d++)
+    {
+        if (std::fabs (normal[d]) > std::fabs (normal[axis]))
+        {
+            axis = d;
+        }
+    }
+    
+    int x = (axis + 1) % 3;
+    int y = (axis + 2) % 3;
+    
+    // twice the signed area of the projection of p, q, r, zero if r is on
+    // the line through p and q but for the rounding
+    auto orient = [&] (const double *p, const double *q, const double *r) -> double
+    {
+        double qx = q[x] - p[x], qy = q[y] - p[y];
+        double rx = r[x] - p[x], ry = r[y] - p[y];
+        double area2 = qx * ry - qy * rx;
+        
+        if (std::fabs (area2) <= COPLANAR_TOLERANCE * std::sqrt ((qx * qx + qy * qy) * (rx * rx + ry * ry)))
+        {
+            return 0.0;
+        }
+        
+        return area2;
+    };
+    
+    const double *const *tri[2] = { u, v };
+    
+    for (int t = 0; t < 2; t++)
+    {
+        const double *const *s = tri[t];
+        const double *const *o = tri[1-t];
+        
+        double sign = (orient (s[0], s[1], s[2]) > 0.0) ? 1.0 : -1.0;
+        
+        for (int i = 0; i < 3; i++)
+        {
+            const double *p = s[i];
+            const double *q = s[(i + 1) % 3];
+            
+            if (sign * orient (p, q, o[0]) <= 0.0 && sign * orient (p, q, o[1]) <= 0.0
+                && sign * orient (p, q, o[2]) <= 0.0)
+            {
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+// Whether two triangles cross, each passing through the interior of the
+// other's plane and their intervals along the line where the planes meet
+// overlapping (Moller, A Fast Triangle-Triangle Intersection Test, 1997).
+// Triangles which only touch, or which lie in the same plane, do not
+// cross, but flush is set for triangles in the same plane facing the same
+// way whose interiors overlap, the parts then share the volume just behind
+// them. Facing opposite ways, as where two parts rest against each other,
+// they do not.
+bool triangles_cross (const double *const *u, const double *const *v, bool &flush)
+{
+    double e1[3], e2[3], nu[3], nv[3];
+    
+    for (int d = 0; d < 3; d++)
+    {
+        e1[d] = v[1][d] - v[0][d];
+        e2[d] = v[2][d] - v[0][d];
+    }
+    
+    cross (e1, e2, nv);
+    
+    for (int d = 0; d < 3; d++)
+    {
+        e1[d] = u[1][d] - u[0][d];
+        e2[d] = u[2][d] - u[0][d];
+    }
+    
+    cross (e1, e2, nu);
+    
+    // the distances of the vertices of u from the plane of v
+    double du[3];
+    plane_distances (u, v, nv, du);
+    
+    if (du[0] == 0.0 && du[1] == 0.0 && du[2] == 0.0)
+    {
+        if (dot (nu, nv) > 0.0 && coplanar_overlap (u, v, nv))
+        {
+            flush = true;
+        }
+        
+        return false;
+    }
+    
+    if ((du[0] >= 0.0 && du[1] >= 0.0 && du[2] >= 0.0)
+        || (du[0] <= 0.0 && du[1] <= 0.0 && du[2] <= 0.0))
+    {
+        return false;
+    }
+    
+    // and of the vertices of v from the plane of u
+    double dv[3];
+    plane_distances (v, u, nu, dv);
+    
+    if ((dv[0] >= 0.0 && dv[1] >= 0.0 && dv[2] >= 0.0)
+        || (dv[0] <= 0.0 && dv[1] <= 0.0 && dv[2] <= 0.0))
+    {
+        return false;
+    }
+    
+    // positions along the line where the planes meet, projected onto the
+    // axis closest to its direction, which keeps their order
+    double line[3];
+    cross (nu, nv, line);
+    
+    int axis = 0;
+    
+    for (int d = 1; d < 3; d++)
+    {
+        if (std::fabs (line[d]) > std::fabs (line[axis]))
+        {
+            axis = d;
+        }
+    }
+    
+    double pu[3] = { u[0][axis], u[1][axis], u[2][axis] };
+    double pv[3] = { v[0][axis], v[1][axis], v[2][axis] };
+    
+    double ulo, uhi, vlo, vhi;
+    plane_interval (du, pu, ulo, uhi);
+    plane_interval (dv, pv, vlo, vhi);
+    
+    return std::max (ulo, vlo) < std::min (uhi, vhi);
+}
+
+// the triangles of a part whose boxes overlap the box lo, hi, sorted by
+// the lower side of their boxes along axis
+void triangles_within (const part_boxes &boxes, const double *lo, const double *hi, int axis,
+                       std::vector<int> &tris)
+{
+    int ntris = (int)(boxes.tri_lo.size () / 3);
+    
+    tris.clear ();
+    
+    for (int t = 0; t < ntris; t++)
+    {
+        const double *tlo = &boxes.tri_lo[3*t];
+        const double *thi = &boxes.tri_hi[3*t];
+        
+        if (tlo[0] <= hi[0] && thi[0] >= lo[0] && tlo[1] <= hi[1] && thi[1] >= lo[1]
+            && tlo[2] <= hi[2] && thi[2] >= lo[2])
+        {
+            tris.push_back (t);
+        }
+    }
+    
+    std::sort (tris.begin (), tris.end (), [&] (int s, int t)
+    {
+        return boxes.tri_lo[3*s+axis] < boxes.tri_lo[3*t+axis];
+    });
+}
+
+// Whether any triangle of a crosses any triangle of b, sweeping along the
+// longest side of the overlap lo, hi of their boxes. Both lists of
+// triangles are sorted by the start of their boxes, at each step the
+// triangle starting first is tested against the triangles of the other
+// part starting before it ends. flush is set if any triangles overlap in
+// the same plane, see triangles_cross.
+bool surfaces_cross (const mesh_data &a, const part_boxes &boxes_a,
+                     const mesh_data &b, const part_boxes &boxes_b,
+                     const double *lo, const double *hi, bool &flush)
+{
+    int axis = 0;
+    
+    for (int d = 1; d < 3; d++)
+    {
+        if (hi[d] - lo[d] > hi[axis] - lo[axis])
+        {
+            axis = d;
+        }
+    }
+    
+    std::vector<int> tris_a, tris_b;
+    triangles_within (boxes_a, lo, hi, axis, tris_a);
+    triangles_within (boxes_b, lo, hi, axis, tris_b);
+    
+    // test triangle s of a against triangle t of b, their boxes are known
+    // to overlap along axis
+    auto cross_test = [&] (int s, int t) -> bool
+    {
+        for (int d = 0; d < 3; d++)
+        {
+            if (boxes_a.tri_lo[3*s+d] > boxes_b.tri_hi[3*t+d]
+                || boxes_b.tri_lo[3*t+d] > boxes_a.tri_hi[3*s+d])
+            {
+                return false;
+            }
+        }
+        
+        const int *sv = a.face (s);
+        const int *tv = b.face (t);
+        
+        const double *u[3] = { &a.coords[3*sv[0]], &a.coords[3*sv[1]], &a.coords[3*sv[2]] };
+        const double *v[3] = { &b.coords[3*tv[0]], &b.coords[3*tv[1]], &b.coords[3*tv[2]] };
+        
+        return triangles_cross (u, v, flush);
+    };
+    
+    size_t i = 0, j = 0;
+    
+    while (i < tris_a.size () && j < tris_b.size ())
+    {
+        int s = tris_a[i];
+        int t = tris_b[j];
+        
+        if (boxes_a.tri_lo[3*s+axis] < boxes_b.tri_lo[3*t+axis])
+        {
+            for (size_t k = j; k < tris_b.size () && boxes_b.tri_lo[3*tris_b[k]+axis] <= boxes_a.tri_hi[3*s+axis]; k++)
+            {
+                if (cross_test (s, tris_b[k]))
+                {
+                    return true;
+                }
+            }
+            
+            i++;
+        }
+        else
+        {
+            for (size_t k = i; k < tris_a.size () && boxes_a.tri_lo[3*tris_a[k]+axis] <= boxes_b.tri_hi[3*t+axis]; k++)
+            {
+                if (cross_test (tris_a[k], t))
+                {
+                    return true;
+                }
+            }
+            
+            j++;
+        }
+    }
+    
+    return false;
+}
+
+// The winding number of a closed triangle mesh about p, plus or minus one
+// inside depending on the orientation of the faces and zero outside, the
+// sum of the solid angles of the triangles seen from p (Van Oosterom and
+// Strackee, The Solid Angle of a Plane Triangle, 1983)
+double winding_number (const mesh_data &tris, const double *p)
+{
+    double total = 0.0;
+    
+    for (int t = 0; t < tris.num_faces (); t++)
+    {
+        const int *verts = tris.face (t);
+        
+        double r[3][3];
+        double len[3];
+        
+        for (int k = 0; k < 3; k++)
+        {
+            for (int d = 0; d < 3; d++)
+            {
+                r[k][d] = tris.coords[3*verts[k]+d] - p[d];
+            }
+            
+            len[k] = std::sqrt (dot (r[k], r[k]));
+        }
+        
+        double n[3];
+        cross (r[1], r[2], n);
+        
+        double det = dot (r[0], n);
+        double denom = len[0] * len[1] * len[2] + dot (r[0], r[1]) * len[2]
+                     + dot (r[1], r[2]) * len[0] + dot (r[2], r[0]) * len[1];
+        
+        total += 2.0 * std::atan2 (det, denom);
+    }
+    
+    return total / (4.0 * 3.14159265358979323846);
+}
+
+// Whether part a lies inside part b, which is only possible when its box
+// lies within that of b. As their surfaces do not cross, a point just
+// inside a, off the middle of its largest triangle, is inside b if a is.
+// A vertex of a would not do, a part touching b from the inside, or a
+// copy of b, has its vertices on the surface of b.
+bool part_inside (const mesh_data &a, const part_boxes &boxes_a, const mesh_data &b, const part_boxes &boxes_b)
+{
+    for (int d = 0; d < 3; d++)
+    {
+        if (boxes_a.lo[d] < boxes_b.lo[d] || boxes_a.hi[d] > boxes_b.hi[d])
+        {
+            return false;
+        }
+    }
+    
+    double largest = 0.0;
+    double centre[3], normal[3];
+    
+    for (int t = 0; t < a.num_faces (); t++)
+    {
+        const int *verts = a.face (t);
+        const double *x[3] = { &a.coords[3*verts[0]], &a.coords[3*verts[1]], &a.coords[3*verts[2]] };
+        
+        double e1[3] = { x[1][0] - x[0][0], x[1][1] - x[0][1], x[1][2] - x[0][2] };
+        double e2[3] = { x[2][0] - x[0][0], x[2][1] - x[0][1], x[2][2] - x[0][2] };
+        double n[3];
+        cross (e1, e2, n);
+        
+        double area2 = std::sqrt (dot (n, n));
+        
+        if (area2 > largest)
+        {
+            largest = area2;
+            
+            for (int d = 0; d < 3; d++)
+            {
+                centre[d] = (x[0][d] + x[1][d] + x[2][d]) / 3.0;
+                normal[d] = n[d] / area2;
+            }
+        }
+    }
+    
+    if (largest == 0.0)
+    {
+        return false;
+    }
+    
+    // a small step against the normal, or along it if the faces of a
+    // point inwards
+    double diagonal[3] = { boxes_a.hi[0] - boxes_a.lo[0], boxes_a.hi[1] - boxes_a.lo[1], boxes_a.hi[2] - boxes_a.lo[2] };
+    double step = 1e-6 * std::sqrt (dot (diagonal, diagonal));
+    double p[3];
+    
+    for (int d = 0; d < 3; d++)
+    {
+        p[d] = centre[d] - step * normal[d];
+    }
+    
+    if (std::fabs (winding_number (a, p)) < 0.5)
+    {
+        for (int d = 0; d < 3; d++)
+        {
+            p[d] = centre[d] + step * normal[d];
+        }
+    }
+    
+    return std::fabs (winding_number (b, p)) > 0.5;
+}
+
+// the volume inside both a and b, from the voxels of a grid fitted to the
+// box lo, hi whose centres are inside both, the voxels are as near cubic
+// as the box allows, with resolution along its longest side
+double overlap_volume (const mesh_data &a, const mesh_data &b, const double *lo, const double *hi,
+                       int resolution)
+{
+    double longest = std::max (hi[0] - lo[0], std::max (hi[1] - lo[1], hi[2] - lo[2]));
+    
+    voxel_grid grid;
+    
+    for (int d = 0; d < 3; d++)
+    {
+        grid.origin[d] = lo[d];
+        grid.dims[d] = std::max (1, (int)std::floor (resolution * (hi[d] - lo[d]) / longest + 0.5));
+        grid.spacing[d] = (hi[d] - lo[d]) / grid.dims[d];
+    }
+    
+    std::unique_ptr<bool[]> inside_a (new bool[grid.num_voxels ()]);
+    std::unique_ptr<bool[]> inside_b (new bool[grid.num_voxels ()]);
+    
+    // one thread each, the pairs are already spread over the threads
+    voxelize (a, grid, inside_a.get (), 1);
+    voxelize (b, grid, inside_b.get (), 1);
+    
+    long count = 0;
+    
+    for (long i = 0; i < grid.num_voxels (); i++)
+    {
+        count += (inside_a[i] && inside_b[i]);
+    }
+    
+    return count * grid.spacing[0] * grid.spacing[1] * grid.spacing[2];
+}
+
+} // anonymous namespace
+
+void find_interference (const std::vector<const mesh_data*> &parts,
+                        std::vector<interference_pair> &pairs,
+                        int volume_resolution, int num_threads)
+{
+    int nparts = (int)parts.size ();
+    
+    for (int i = 0; i < nparts; i++)
+    {
+        if (!parts[i]->is_triangulated ())
+        {
+            throw std::invalid_argument ("The parts must be triangulated to find where they interfere.");
+        }
+    }
+    
+    pairs.clear ();
+    
+    std::vector<part_boxes> boxes (nparts);
+    
+    int nchunks = num_work_chunks (nparts, 1, num_threads);
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        for (int i = nparts * c / nchunks; i < nparts * (c + 1) / nchunks; i++)
+        {
+            find_boxes (*parts[i], boxes[i]);
+        }
+    });
+    
+    // the broad phase, along the axis on which the centres of the boxes
+    // are most spread out, parts with no faces take no part
+    std::vector<int> order;
+    
+    for (int i = 0; i < nparts; i++)
+    {
+        if (!boxes[i].empty ())
+        {
+            order.push_back (i);
+        }
+    }
+    
+    int axis = 0;
+    double best_spread = -1.0;
+    
+    for (int d = 0; d < 3; d++)
+    {
+        double sum = 0.0, sum2 = 0.0;
+        
+        for (size_t k = 0; k < order.size (); k++)
+        {
+            double centre = 0.5 * (boxes[order[k]].lo[d] + boxes[order[k]].hi[d]);
+            
+            sum += centre;
+            sum2 += centre * centre;
+        }
+        
+        double spread = sum2 - sum * sum / std::max ((size_t)1, order.size ());
+        
+        if (spread > best_spread)
+        {
+            best_spread = spread;
+            axis = d;
+        }
+    }
+    
+    std::sort (order.begin (), order.end (), [&] (int i, int j)
+    {
+        return boxes[i].lo[axis] < boxes[j].lo[axis];
+    });
+    
+    // the boxes still open as each box starts, pairs whose boxes only
+    // touch cannot interfere
+    std::vector<interference_pair> candidates;
+    std::vector<int> open;
+    
+    for (size_t k = 0; k < order.size (); k++)
+    {
+        const part_boxes &box = boxes[order[k]];
+        
+        size_t nopen = 0;
+        
+        for (size_t m = 0; m < open.size (); m++)
+        {
+            const part_boxes &other = boxes[open[m]];
+            
+            if (other.hi[axis] <= box.lo[axis])
+            {
+                continue;
+            }
+            
+            open[nopen++] = open[m];
+            
+            bool overlap = true;
+            
+            for (int d = 0; d < 3; d++)
+            {
+                overlap = overlap && other.lo[d] < box.hi[d] && box.lo[d] < other.hi[d];
+            }
+            
+            if (overlap)
+            {
+                interference_pair pair;
+                pair.a = std::min (order[k], open[m]);
+                pair.b = std::max (order[k], open[m]);
+                
+                candidates.push_back (pair);
+            }
+        }
+        
+        open.resize (nopen);
+        open.push_back (order[k]);
+    }
+    
+    // the narrow phase, each thread taking the next pair in turn as their
+    // costs vary widely
+    std::vector<char> interferes (candidates.size (), 0);
+    std::atomic<size_t> next (0);
+    
+    parallel_for_chunks (num_work_chunks (candidates.size (), 1, num_threads), [&] (int)
+    {
+        for (size_t n = next++; n < candidates.size (); n = next++)
+        {
+            interference_pair &pair = candidates[n];
+            
+            const mesh_data &a = *parts[pair.a];
+            const mesh_data &b = *parts[pair.b];
+            
+            double lo[3], hi[3];
+            
+            for (int d = 0; d < 3; d++)
+            {
+                lo[d] = std::max (boxes[pair.a].lo[d], boxes[pair.b].lo[d]);
+                hi[d] = std::min (boxes[pair.a].hi[d], boxes[pair.b].hi[d]);
+            }
+            
+            // parts overlapping only where they sit flush with each other
+            // may still be one inside the other
+            bool flush = false;
+            
+            if (surfaces_cross (a, boxes[pair.a], b, boxes[pair.b], lo, hi, flush))
+            {
+                interferes[n] = 1;
+            }
+            else if (part_inside (a, boxes[pair.a], b, boxes[pair.b])
+                     || part_inside (b, boxes[pair.b], a, boxes[pair.a]))
+            {
+                interferes[n] = 1;
+                pair.contained = true;
+            }
+            else if (flush)
+            {
+                interferes[n] = 1;
+            }
+            
+            if (interferes[n] && volume_resolution > 0)
+            {
+                pair.volume = overlap_volume (a, b, lo, hi, volume_resolution);
+            }
+        }
+    });
+    
+    for (size_t n = 0; n < candidates.size (); n++)
+    {
+        if (interferes[n])
+        {
+            pairs.push_back (candidates[n]);
+        }
+    }
+    
+    std::sort (pairs.begin (), pairs.end (), [] (const interference_pair &p, const interference_pair &q)
+    {
+        return p.a < q.a || (p.a == q.a && p.b < q.b);
+    });
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,69 @@
+/*
+   interference.hpp
+   
+   Clashes between the parts of an assembly, found without boolean
+   operations, by a sweep and prune over the bounding boxes of the parts
+   followed by triangle against triangle tests for the pairs whose boxes
+   overlap
+
+*/
+
+#ifndef __INTERFERENCE_HPP__
+#define __INTERFERENCE_HPP__
+
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// Two parts which interfere, a < b, indices into the list of parts.
+// contained is set when neither surface crosses the other but one part
+// lies inside the other. volume is the estimated volume of the overlap,
+// when asked for, otherwise zero.
+class interference_pair
+{
+public:
+    
+    interference_pair () : a(0), b(0), contained(false), volume(0.0) {}
+    
+    int a;
+    int b;
+    bool contained;
+    double volume;
+    
+};
+
+// Find the pairs of parts which interfere. Each part is a closed triangle
+// mesh with its faces pointing out. Parts interfere if their surfaces
+// cross, if faces of both lie in the same plane facing the same way and
+// overlap, as where parts sit flush with each other, or if one is inside
+// the other. Parts which only touch, with faces, edges or vertices meeting
+// but not crossing, do not.
+//
+// The broad phase sorts the boxes of the parts along the axis on which
+// they are most spread out and sweeps along it, keeping the boxes which
+// are still open, so only pairs whose boxes overlap are examined. Each
+// such pair is then examined by a sweep and prune over the triangles of
+// each part within the overlap of the boxes, testing the pairs of
+// triangles whose boxes overlap, stopping at the first which cross or
+// overlap in the same plane. A pair with no such triangles is tested for
+// containment from the winding number about one part of a point just
+// inside the other.
+//
+// If volume_resolution is positive the volume of each overlap is estimated
+// by voxelizing both parts on a grid over the overlap of their boxes, with
+// volume_resolution voxels along its longest side and voxels as near
+// cubic as the box allows, and counting the voxels whose centres are
+// inside both.
+//
+// The pairs are examined in parallel on up to num_threads threads, zero
+// for the default, and are returned in order of a then b. Throws
+// std::invalid_argument if a part is not triangulated.
+void find_interference (const std::vector<const mesh_data*> &parts,
+                        std::vector<interference_pair> &pairs,
+                        int volume_resolution=0, int num_threads=0);
+
+} // namespace mpolycsg
+
+#endif // __INTERFERENCE_HPP__
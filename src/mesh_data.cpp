@@ -0,0 +1,109 @@
+/*
+   mesh_data.cpp
+   
+   Conversion between polyhcsg::polyhedron and mesh_data
+
+*/
+
+#include <cmath>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+void polyhedron_to_mesh (const polyhcsg::polyhedron &ph, mesh_data &mesh)
+{
+    mesh.clear ();
+    
+    int nverts = ph.num_vertices ();
+    int nfaces = ph.num_faces ();
+    
+    mesh.coords.resize (3 * nverts);
+    
+    for (int i = 0; i < nverts; i++)
+    {
+        ph.get_vertex (i, mesh.coords[3*i], mesh.coords[3*i+1], mesh.coords[3*i+2]);
+    }
+    
+    // size the face index storage in one go before copying the faces
+    mesh.face_start.resize (nfaces + 1);
+    
+    for (int i = 0; i < nfaces; i++)
+    {
+        mesh.face_start[i+1] = mesh.face_start[i] + ph.num_face_vertices (i);
+    }
+    
+    mesh.face_verts.resize (mesh.face_start[nfaces]);
+    
+    for (int i = 0; i < nfaces; i++)
+    {
+        if (mesh.face_size (i) > 0)
+        {
+            ph.get_face_vertices (i, &mesh.face_verts[mesh.face_start[i]]);
+        }
+    }
+}
+
+void mesh_to_polyhedron (const mesh_data &mesh, polyhcsg::polyhedron &ph)
+{
+    // polyhcsg expects each face as the number of vertices in the face 
+    // followed by the vertex indices
+    std::vector<int> faces;
+    
+    faces.reserve (mesh.face_verts.size () + mesh.num_faces ());
+    
+    for (int i = 0; i < mesh.num_faces (); i++)
+    {
+        faces.push_back (mesh.face_size (i));
+        faces.insert (faces.end (), mesh.face (i), mesh.face (i) + mesh.face_size (i));
+    }
+    
+    ph.initialize_load_from_mesh (mesh.coords, faces);
+}
+
+void vertex_normals (const mesh_data &mesh, std::vector<double> &normals)
+{
+    normals.assign (mesh.coords.size (), 0.0);
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        int n = mesh.face_size (f);
+        const int *verts = mesh.face (f);
+        
+        // Newell's method, the length of the result is twice the face area
+        double nx = 0.0, ny = 0.0, nz = 0.0;
+        
+        for (int i = 0; i < n; i++)
+        {
+            const double *a = mesh.vertex (verts[i]);
+            const double *b = mesh.vertex (verts[(i + 1) % n]);
+            
+            nx += (a[1] - b[1]) * (a[2] + b[2]);
+            ny += (a[2] - b[2]) * (a[0] + b[0]);
+            nz += (a[0] - b[0]) * (a[1] + b[1]);
+        }
+        
+        for (int i = 0; i < n; i++)
+        {
+            double *vn = &normals[3*verts[i]];
+            
+            vn[0] += nx;
+            vn[1] += ny;
+            vn[2] += nz;
+        }
+    }
+    
+    for (size_t i = 0; i < normals.size (); i += 3)
+    {
+        double len = std::sqrt (normals[i]*normals[i] + normals[i+1]*normals[i+1] + normals[i+2]*normals[i+2]);
+        
+        if (len > 0)
+        {
+            normals[i] /= len;
+            normals[i+1] /= len;
+            normals[i+2] /= len;
+        }
+    }
+}
+
+} // namespace mpolycsg
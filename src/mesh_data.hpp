@@ -0,0 +1,105 @@
+/*
+   mesh_data.hpp
+   
+   Flat face-vertex mesh representation used by the algorithms which work
+   directly on the geometry of a polyhcsg::polyhedron, and functions to
+   move geometry between the two representations.
+
+*/
+
+#ifndef __MESH_DATA_HPP__
+#define __MESH_DATA_HPP__
+
+#include <vector>
+
+#include "polyhcsg/polyhedron.h"
+
+namespace mpolycsg {
+
+class mesh_data
+{
+public:
+    
+    mesh_data () { clear (); }
+    
+    void clear ()
+    {
+        coords.clear ();
+        face_verts.clear ();
+        face_start.clear ();
+        face_start.push_back (0);
+    }
+    
+    int num_vertices () const { return (int)(coords.size () / 3); }
+    
+    int num_faces () const { return (int)(face_start.size () - 1); }
+    
+    int face_size (int face_id) const 
+    { 
+        return face_start[face_id+1] - face_start[face_id]; 
+    }
+    
+    const int* face (int face_id) const 
+    { 
+        return &face_verts[face_start[face_id]]; 
+    }
+    
+    const double* vertex (int vert_id) const 
+    { 
+        return &coords[3*vert_id]; 
+    }
+    
+    int add_vertex (double x, double y, double z)
+    {
+        coords.push_back (x);
+        coords.push_back (y);
+        coords.push_back (z);
+        
+        return num_vertices () - 1;
+    }
+    
+    int add_face (const int* verts, int nverts)
+    {
+        face_verts.insert (face_verts.end (), verts, verts + nverts);
+        face_start.push_back ((int)face_verts.size ());
+        
+        return num_faces () - 1;
+    }
+    
+    int add_triangle (int a, int b, int c)
+    {
+        int tri[3] = {a, b, c};
+        
+        return add_face (tri, 3);
+    }
+    
+    // true if every face has exactly three vertices
+    bool is_triangulated () const
+    {
+        return (int)face_verts.size () == 3 * num_faces ();
+    }
+    
+    // x, y, z coordinates of each vertex
+    std::vector<double> coords;
+    // offset of the first vertex of each face in face_verts, the last entry
+    // is the total length of face_verts
+    std::vector<int> face_start;
+    // the vertex indices of all faces, one after the other
+    std::vector<int> face_verts;
+    
+};
+
+// copy the vertices and faces of a polyhedron into a mesh_data object
+void polyhedron_to_mesh (const polyhcsg::polyhedron &ph, mesh_data &mesh);
+
+// replace the geometry of a polyhedron with the contents of a mesh_data object
+void mesh_to_polyhedron (const mesh_data &mesh, polyhcsg::polyhedron &ph);
+
+// unit normal of each vertex, the average of the normals of the faces 
+// sharing it weighted by their areas, as x, y, z triplets. Vertices not 
+// used by any face get a zero normal
+void vertex_normals (const mesh_data &mesh, std::vector<double> &normals);
+
+} // namespace mpolycsg
+
+#endif // __MESH_DATA_HPP__
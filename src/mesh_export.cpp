@@ -0,0 +1,433 @@
+/*
+   mesh_export.cpp
+   
+   Streaming export of several bodies into one STL, OBJ or PLY file, one
+   body at a time, without combining them first
+
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "mesh_export.hpp"
+#include "triangulate.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// size of the binary STL header, followed by the number of triangles
+const size_t STL_HEADER_SIZE = 80;
+
+void put_uint (std::vector<unsigned char> &out, uint64_t value, int nbytes)
+{
+    for (int i = 0; i < nbytes; i++)
+    {
+        out.push_back ((unsigned char)(value >> (8*i)));
+    }
+}
+
+void put_float (std::vector<unsigned char> &out, float value)
+{
+    uint32_t bits;
+    std::memcpy (&bits, &value, sizeof (bits));
+    put_uint (out, bits, 4);
+}
+
+void put_double (std::vector<unsigned char> &out, double value)
+{
+    uint64_t bits;
+    std::memcpy (&bits, &value, sizeof (bits));
+    put_uint (out, bits, 8);
+}
+
+void put_text (std::vector<unsigned char> &out, const char *text)
+{
+    out.insert (out.end (), text, text + std::strlen (text));
+}
+
+// a line of text of up to 255 characters
+template <typename... T>
+void put_line (std::vector<unsigned char> &out, const char *format, T... values)
+{
+    char line[256];
+    int n = std::snprintf (line, sizeof (line), format, values...);
+    
+    out.insert (out.end (), line, line + std::min (n, (int)sizeof (line) - 1));
+}
+
+// the vertices of a mesh transformed by a row-major 4 x 4 matrix, which may
+// be NULL, returning true if the transform mirrors the mesh
+bool transform_vertices (const mesh_data &mesh, const double *m, std::vector<double> &coords)
+{
+    coords = mesh.coords;
+    
+    if (m == NULL)
+    {
+        return false;
+    }
+    
+    for (size_t i = 0; i < coords.size (); i += 3)
+    {
+        double x = coords[i], y = coords[i+1], z = coords[i+2];
+        double w = m[12] * x + m[13] * y + m[14] * z + m[15];
+        
+        if (w == 0.0)
+        {
+            w = 1.0;
+        }
+        
+        coords[i]   = (m[0] * x + m[1] * y + m[2]  * z + m[3])  / w;
+        coords[i+1] = (m[4] * x + m[5] * y + m[6]  * z + m[7])  / w;
+        coords[i+2] = (m[8] * x + m[9] * y + m[10] * z + m[11]) / w;
+    }
+    
+    double det = m[0] * (m[5] * m[10] - m[6] * m[9])
+               - m[1] * (m[4] * m[10] - m[6] * m[8])
+               + m[2] * (m[4] * m[9]  - m[5] * m[8]);
+    
+    return det < 0.0;
+}
+
+// the unit normal of a triangle, zero if it is degenerate
+void triangle_normal (const double *a, const double *b, const double *c, double *n)
+{
+    double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+    
+    double len = std::sqrt (n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    
+    for (int d = 0; d < 3; d++)
+    {
+        n[d] = (len > 0.0) ? n[d] / len : 0.0;
+    }
+}
+
+} // anonymous namespace
+
+const char* export_format_name (export_format format)
+{
+    switch (format)
+    {
+        case export_stl: return "stl";
+        case export_stl_ascii: return "stl_ascii";
+        case export_obj: return "obj";
+        case export_ply: return "ply";
+    }
+    
+    return "unknown";
+}
+
+bool parse_export_format (const std::string &name, export_format &format)
+{
+    // the extension of a file name, in lower case
+    std::string ext = name.substr (name.find_last_of ('.') + 1);
+    std::transform (ext.begin (), ext.end (), ext.begin (), ::tolower);
+    
+    if (ext == "stl") { format = export_stl; }
+    else if (ext == "stl_ascii") { format = export_stl_ascii; }
+    else if (ext == "obj") { format = export_obj; }
+    else if (ext == "ply") { format = export_ply; }
+    else { return false; }
+    
+    return true;
+}
+
+mesh_exporter::mesh_exporter (const std::string &filename, export_format format,
+                              long total_vertices, long total_faces)
+    : filename_m(filename), format_m(format), file_m(NULL), faces_m(NULL),
+      total_vertices_m(total_vertices), total_faces_m(total_faces),
+      num_vertices_m(0), num_faces_m(0)
+{
+    file_m = std::fopen (filename.c_str (), "wb");
+    
+    if (file_m == NULL)
+    {
+        throw std::runtime_error ("Could not open " + filename + " for writing.");
+    }
+    
+    std::vector<unsigned char> header;
+    
+    switch (format_m)
+    {
+        case export_stl:
+            // the header must not start with "solid", which marks ASCII
+            // STL, the number of triangles is filled in by finish
+            put_text (header, "binary STL written by mpolycsg");
+            header.resize (STL_HEADER_SIZE, 0);
+            put_uint (header, 0, 4);
+            break;
+        
+        case export_stl_ascii:
+            break;
+        
+        case export_obj:
+            put_text (header, "# written by mpolycsg\n");
+            break;
+        
+        case export_ply:
+            faces_m = std::tmpfile ();
+            
+            if (faces_m == NULL)
+            {
+                std::fclose (file_m);
+                throw std::runtime_error ("Could not create a temporary file for the faces of " + filename + ".");
+            }
+            
+            put_text (header, "ply\nformat binary_little_endian 1.0\ncomment written by mpolycsg\n");
+            put_line (header, "element vertex %ld\n", total_vertices_m);
+            put_text (header, "property double x\nproperty double y\nproperty double z\n");
+            put_line (header, "element face %ld\n", total_faces_m);
+            put_text (header, "property list int int vertex_indices\nend_header\n");
+            break;
+    }
+    
+    write (file_m, header);
+}
+
+mesh_exporter::~mesh_exporter ()
+{
+    if (file_m != NULL)
+    {
+        std::fclose (file_m);
+    }
+    
+    if (faces_m != NULL)
+    {
+        std::fclose (faces_m);
+    }
+}
+
+void mesh_exporter::write (FILE *file, const std::vector<unsigned char> &data)
+{
+    if (!data.empty () && std::fwrite (&data[0], 1, data.size (), file) != data.size ())
+    {
+        throw std::runtime_error ("Error writing to " + filename_m + ".");
+    }
+}
+
+void mesh_exporter::add_body (const mesh_data &mesh, const double *transform, const std::string &name)
+{
+    if (file_m == NULL)
+    {
+        throw std::runtime_error ("Bodies cannot be added to " + filename_m + " once it is finished.");
+    }
+    
+    std::vector<double> coords;
+    bool mirrored = transform_vertices (mesh, transform, coords);
+    
+    std::vector<unsigned char> out;
+    
+    if (format_m == export_stl || format_m == export_stl_ascii)
+    {
+        mesh_data triangulated;
+        const mesh_data *tris = &mesh;
+        
+        if (!mesh.is_triangulated ())
+        {
+            triangulate_mesh (mesh, triangulated);
+            tris = &triangulated;
+        }
+        
+        int ntris = tris->num_faces ();
+        
+        if (format_m == export_stl)
+        {
+            out.reserve (50 * ntris);
+        }
+        else
+        {
+            put_line (out, "solid %s\n", name.c_str ());
+        }
+        
+        for (int t = 0; t < ntris; t++)
+        {
+            const int *verts = tris->face (t);
+            const double *x[3] = { &coords[3*verts[0]], &coords[3*verts[1]], &coords[3*verts[2]] };
+            
+            if (mirrored)
+            {
+                std::swap (x[1], x[2]);
+            }
+            
+            double n[3];
+            triangle_normal (x[0], x[1], x[2], n);
+            
+            if (format_m == export_stl)
+            {
+                for (int d = 0; d < 3; d++)
+                {
+                    put_float (out, (float)n[d]);
+                }
+                
+                for (int k = 0; k < 3; k++)
+                {
+                    for (int d = 0; d < 3; d++)
+                    {
+                        put_float (out, (float)x[k][d]);
+                    }
+                }
+                
+                put_uint (out, 0, 2);
+            }
+            else
+            {
+                put_line (out, "  facet normal %.9g %.9g %.9g\n    outer loop\n", n[0], n[1], n[2]);
+                
+                for (int k = 0; k < 3; k++)
+                {
+                    put_line (out, "      vertex %.9g %.9g %.9g\n", x[k][0], x[k][1], x[k][2]);
+                }
+                
+                put_text (out, "    endloop\n  endfacet\n");
+            }
+        }
+        
+        if (format_m == export_stl_ascii)
+        {
+            put_line (out, "endsolid %s\n", name.c_str ());
+        }
+        
+        num_faces_m += ntris;
+        num_vertices_m += mesh.num_vertices ();
+        
+        write (file_m, out);
+        
+        return;
+    }
+    
+    // OBJ and PLY write the faces as they are, reversed if mirrored, with
+    // the vertex indices following on from those of the previous bodies
+    std::vector<unsigned char> faces;
+    
+    if (format_m == export_obj)
+    {
+        put_line (out, "g %s\n", name.c_str ());
+    }
+    
+    for (size_t i = 0; i < coords.size (); i += 3)
+    {
+        if (format_m == export_obj)
+        {
+            put_line (out, "v %.17g %.17g %.17g\n", coords[i], coords[i+1], coords[i+2]);
+        }
+        else
+        {
+            put_double (out, coords[i]);
+            put_double (out, coords[i+1]);
+            put_double (out, coords[i+2]);
+        }
+    }
+    
+    std::vector<unsigned char> &face_out = (format_m == export_obj) ? out : faces;
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        const int *verts = mesh.face (f);
+        int nverts = mesh.face_size (f);
+        
+        if (format_m == export_obj)
+        {
+            put_text (face_out, "f");
+        }
+        else
+        {
+            put_uint (face_out, (uint32_t)nverts, 4);
+        }
+        
+        for (int k = 0; k < nverts; k++)
+        {
+            long v = num_vertices_m + verts[mirrored ? nverts - 1 - k : k];
+            
+            if (format_m == export_obj)
+            {
+                // OBJ vertex indices start from one
+                put_line (face_out, " %ld", v + 1);
+            }
+            else
+            {
+                put_uint (face_out, (uint32_t)v, 4);
+            }
+        }
+        
+        if (format_m == export_obj)
+        {
+            put_text (face_out, "\n");
+        }
+    }
+    
+    num_vertices_m += mesh.num_vertices ();
+    num_faces_m += mesh.num_faces ();
+    
+    write (file_m, out);
+    
+    if (faces_m != NULL)
+    {
+        write (faces_m, faces);
+    }
+}
+
+void mesh_exporter::finish ()
+{
+    if (file_m == NULL)
+    {
+        return;
+    }
+    
+    if (format_m == export_ply)
+    {
+        if (num_vertices_m != total_vertices_m || num_faces_m != total_faces_m)
+        {
+            throw std::invalid_argument ("The bodies written to " + filename_m
+                                         + " do not have the numbers of vertices and faces given in its header.");
+        }
+        
+        // append the faces from the temporary file
+        std::rewind (faces_m);
+        
+        std::vector<unsigned char> block (1 << 20);
+        size_t n;
+        
+        while ((n = std::fread (&block[0], 1, block.size (), faces_m)) > 0)
+        {
+            block.resize (n);
+            write (file_m, block);
+            block.resize (1 << 20);
+        }
+        
+        std::fclose (faces_m);
+        faces_m = NULL;
+    }
+    
+    if (format_m == export_stl)
+    {
+        // the number of triangles follows the header
+        std::vector<unsigned char> count;
+        put_uint (count, (uint64_t)num_faces_m, 4);
+        
+        if (std::fseek (file_m, STL_HEADER_SIZE, SEEK_SET) != 0)
+        {
+            throw std::runtime_error ("Error writing to " + filename_m + ".");
+        }
+        
+        write (file_m, count);
+    }
+    
+    FILE *file = file_m;
+    file_m = NULL;
+    
+    if (std::fclose (file) != 0)
+    {
+        throw std::runtime_error ("Error writing to " + filename_m + ".");
+    }
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,99 @@
+/*
+   mesh_export.hpp
+   
+   Streaming export of several bodies into one STL, OBJ or PLY file, one
+   body at a time, without combining them first
+
+*/
+
+#ifndef __MESH_EXPORT_HPP__
+#define __MESH_EXPORT_HPP__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// The file formats which can be written:
+//
+// export_stl is binary STL, the triangles of all the bodies in one list.
+//
+// export_stl_ascii is ASCII STL with one named solid per body.
+//
+// export_obj is Wavefront OBJ with one named group per body, the faces are
+// written as they are, without triangulating them.
+//
+// export_ply is binary little endian PLY, the vertices of all the bodies
+// followed by all their faces, which are written as they are.
+enum export_format
+{
+    export_stl,
+    export_stl_ascii,
+    export_obj,
+    export_ply
+};
+
+// "stl", "stl_ascii", "obj" or "ply"
+const char* export_format_name (export_format format);
+
+// the format with the given name, or for a file name the format given by
+// its extension, returns false if there is none
+bool parse_export_format (const std::string &name, export_format &format);
+
+// Writes bodies one after another to a file, each body is written out as
+// soon as it is added, so only one body need be held in memory at a time.
+// Throws std::runtime_error if the file cannot be written.
+class mesh_exporter
+{
+public:
+    
+    // open the file and write the header. For PLY the header gives the
+    // number of vertices and faces in the file, so the totals over all the
+    // bodies to be added must be given, the other formats ignore them
+    mesh_exporter (const std::string &filename, export_format format,
+                   long total_vertices=0, long total_faces=0);
+    
+    // closes the file if finish was not called, leaving it incomplete
+    ~mesh_exporter ();
+    
+    // append a body, with its vertices transformed by a 4 x 4 matrix,
+    // stored row by row, or untransformed if transform is NULL. A
+    // transform which mirrors the body reverses the order of the vertices
+    // of its faces, so they still face outwards. Faces are triangulated for
+    // STL.
+    void add_body (const mesh_data &mesh, const double *transform, const std::string &name);
+    
+    // complete the file and close it. Throws std::invalid_argument for PLY
+    // if the bodies added do not match the totals given.
+    void finish ();
+    
+private:
+    
+    mesh_exporter (const mesh_exporter&) = delete;
+    mesh_exporter& operator= (const mesh_exporter&) = delete;
+    
+    void write (FILE *file, const std::vector<unsigned char> &data);
+    
+    std::string filename_m;
+    export_format format_m;
+    FILE *file_m;
+    
+    // for PLY, the faces are written to a temporary file until the
+    // vertices of every body have been written
+    FILE *faces_m;
+    
+    long total_vertices_m;
+    long total_faces_m;
+    
+    // vertices and faces (triangles for STL) written so far
+    long num_vertices_m;
+    long num_faces_m;
+    
+};
+
+} // namespace mpolycsg
+
+#endif // __MESH_EXPORT_HPP__
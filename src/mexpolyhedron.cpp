@@ -1,16 +1,73 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
 #include <vector>
 #include "mex.h"
 
+#include "stats.hpp"
+
+// time every command, recorded as mex.<command>
+#define MEX_CLASS_WRAPPER_CALL_SCOPE(CMD) mpolycsg::scoped_timer mex_wrapped_class_call_timer (std::string ("mex.") + CMD);
+
 #define CLASS_HANDLE_SIGNATURE 0xAA01F0A1
 #include "class_handle.hpp"
 
-#include "polyhcsg/polyhedron.h"
-#include "polyhcsg/polyhedron_binary_op.h"
+#include "polyhedron_engine.hpp"
 
-using namespace polyhcsg;
 using namespace mexutils;
+using namespace mpolycsg;
+
+#ifdef MPOLYCSG_UT_INTERRUPT
+// undocumented Matlab function reporting whether Ctrl-C has been pressed, 
+// requires linking with libut
+extern "C" bool utIsInterruptPending ();
+#endif
+
+// seconds between progress reports of long operations
+static double progress_report_interval = 2.0;
+
+// points sampled on each surface when comparing polyhedra, if not given
+static const long DEFAULT_DISTANCE_SAMPLES = 10000;
+
+// bins in the edge length histogram of quality_report, and the smallest
+// angle, in degrees, below which a triangle is counted as a sliver
+static const int DEFAULT_QUALITY_BINS = 10;
+static const double DEFAULT_SLIVER_ANGLE = 10.0;
+
+// voxels along the longest side of the overlap of two parts when
+// estimating its volume in interference
+static const int DEFAULT_INTERFERENCE_RESOLUTION = 64;
+
+static bool interrupt_pending ()
+{
+#ifdef MPOLYCSG_UT_INTERRUPT
+    return utIsInterruptPending ();
+#else
+    // Ctrl-C cannot be detected, but operations can still report progress
+    return false;
+#endif
+}
+
+static void print_progress (const std::string &operation, double fraction, double elapsed)
+{
+    if (fraction >= 0)
+    {
+        mexPrintf ("%s: %3.0f%% complete, %.1f s\n", operation.c_str (), 100.0 * fraction, elapsed);
+    }
+    else
+    {
+        mexPrintf ("%s: running for %.1f s\n", operation.c_str (), elapsed);
+    }
+    
+    // flush the output to the command window
+    mexEvalString ("drawnow;");
+}
 
-// interface to to the polyhedron class from pyPolyCsg
+// interface to the mpolycsg engine, which wraps the polyhedron class from 
+// pyPolyCsg, this class only translates the mexfunction arguments
 class polyhedron_interface
 {
 public:
@@ -19,22 +76,13 @@ public:
     void copy (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
     {
         // get a pointer to the other polyhedron
-        polyhedron* otherph = getotherpoly(nrhs, prhs);
+        const polyhedron_engine* otherph = getotherpoly(nrhs, prhs);
       
         if (otherph != NULL)
         {
-            try
-            {
-                // replace the wrapped poly with a copy of the one supplied
-                ph = polyhedron (*otherph);
-            }
-            catch (...)
-            {
-                ph = polyhedron ();
-                
-                mexErrMsgIdAndTxt("CSG:copy",
-                    "Other polyhedron could not be copied, exception thrown.");
-            }
+            // share the geometry of the one supplied, it is only actually 
+            // copied when one of the two is modified
+            engine.share (*otherph);
         }
         else
         {
@@ -59,7 +107,128 @@ public:
         
         getpolygon (prhs[2], prhs[3], coords, lines);
         
-        ph.initialize_create_extrusion ( coords, lines, distance );
+        engine.make_extrusion ( coords, lines, distance );
+    }
+    
+    void extrude_loops (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        std::vector< std::vector<double> > loops;
+        
+        // cell array of loops and the extrusion distance expected
+        std::vector<int> nallowed;
+        nallowed.push_back (2);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        getloops (prhs[2], loops, "CSG:extrusion");
+        
+        double distance = mxnthargscalar (nrhs, prhs, 2, 2);
+        
+        engine.make_extrusion_region (loops, distance);
+    }
+    
+    void sweep (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        std::vector< std::vector<double> > loops;
+        
+        // cell array of loops, the path and optionally the profile x axis 
+        // direction at the start of the path expected
+        std::vector<int> nallowed;
+        nallowed.push_back (2);
+        nallowed.push_back (3);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        getloops (prhs[2], loops, "CSG:sweep");
+        
+        const mxArray *pathMxArray = prhs[3];
+        
+        if (!mxIsDouble (pathMxArray) || mxGetN (pathMxArray) != 3)
+        {
+            mexErrMsgIdAndTxt("CSG:sweep",
+                "The path must be a (n x 3) matrix of x, y and z coordinates.");
+        }
+        
+        // convert the column major matrix to x, y, z triplets
+        mwSize n = mxGetM (pathMxArray);
+        const double *xyz = mxGetPr (pathMxArray);
+        
+        std::vector<double> path (3 * n);
+        
+        for (mwSize i = 0; i < n; i++)
+        {
+            path[3*i] = xyz[i];
+            path[3*i+1] = xyz[i + n];
+            path[3*i+2] = xyz[i + 2*n];
+        }
+        
+        double normal[3];
+        bool has_normal = (nrhs > 4);
+        
+        if (has_normal)
+        {
+            if (!mxIsDouble (prhs[4]) || mxGetNumberOfElements (prhs[4]) != 3)
+            {
+                mexErrMsgIdAndTxt("CSG:sweep",
+                    "The normal must be a vector of three elements.");
+            }
+            
+            std::copy (mxGetPr (prhs[4]), mxGetPr (prhs[4]) + 3, normal);
+        }
+        
+        engine.make_sweep (loops, path, has_normal ? normal : NULL);
+    }
+    
+    void convex_hull (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // any number of (n x 3) matrices of points and handles to other 
+        // polyhedra whose vertices are included
+        if (nrhs < 3)
+        {
+            mexErrMsgIdAndTxt("CSG:convex_hull",
+                "At least one set of points or polyhedron is required.");
+        }
+        
+        std::vector<double> points;
+        
+        for (int i = 2; i < nrhs; i++)
+        {
+            if (mxIsUint64 (prhs[i]))
+            {
+                const polyhedron_engine *other = convertMat2Ptr<polyhedron_interface>(prhs[i])->getengine ();
+                
+                int nverts = other->num_vertices ();
+                
+                for (int v = 0; v < nverts; v++)
+                {
+                    double x, y, z;
+                    other->get_vertex (v, x, y, z);
+                    
+                    points.push_back (x);
+                    points.push_back (y);
+                    points.push_back (z);
+                }
+            }
+            else if (mxIsDouble (prhs[i]) && mxGetN (prhs[i]) == 3)
+            {
+                mwSize n = mxGetM (prhs[i]);
+                const double *xyz = mxGetPr (prhs[i]);
+                
+                for (mwSize j = 0; j < n; j++)
+                {
+                    points.push_back (xyz[j]);
+                    points.push_back (xyz[j + n]);
+                    points.push_back (xyz[j + 2*n]);
+                }
+            }
+            else
+            {
+                mexErrMsgIdAndTxt("CSG:convex_hull",
+                    "Points must be supplied as (n x 3) matrices of x, y and z coordinates.");
+            }
+        }
+        
+        engine.make_convex_hull (points);
     }
     
     void extrude_rotate (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -81,7 +250,7 @@ public:
         int segments = mxnthargscalar (nrhs, prhs, 4, 2);
         double dTheta = mxnthargscalar (nrhs, prhs, 5, 2);
         
-        ph.initialize_create_extrusion ( coords, lines, distance, segments, dTheta );
+        engine.make_extrusion ( coords, lines, distance, segments, dTheta );
     }
     
     void surface_of_revolution (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -114,7 +283,7 @@ public:
              segments = mxnthargscalar (nrhs, prhs, 4, 2);
         }
         
-        ph.initialize_create_surface_of_revolution ( coords, lines, angle, segments );
+        engine.make_surface_of_revolution ( coords, lines, angle, segments );
     }
       
     void makebox (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -135,7 +304,7 @@ public:
         size_z = mxnthargscalar (nrhs, prhs, 3, 2);
         is_centered = ( (mxnthargscalar (nrhs, prhs, 4, 2) == 0) ? false : true );
         
-        ph.initialize_create_box( size_x, size_y, size_z, is_centered );
+        engine.make_box( size_x, size_y, size_z, is_centered );
     }
     
     void makesphere (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -170,7 +339,7 @@ public:
             vsegments = mxnthargscalar (nrhs, prhs, 4, 2);
         }
         
-        ph.initialize_create_sphere( radius, is_centered, hsegments, vsegments );
+        engine.make_sphere( radius, is_centered, hsegments, vsegments );
         
     }
     
@@ -202,7 +371,7 @@ public:
             segments = mxnthargscalar (nrhs, prhs, 4, 2);
         }
         
-        ph.initialize_create_cylinder( radius, height, is_centered, segments );
+        engine.make_cylinder( radius, height, is_centered, segments );
     }
     
     void makecone (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -233,7 +402,7 @@ public:
             segments = mxnthargscalar (nrhs, prhs, 3, 2);
         }
         
-        ph.initialize_create_cone( radius, height, is_centered, segments );
+        engine.make_cone( radius, height, is_centered, segments );
     }
     
     void maketorus (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -270,8 +439,92 @@ public:
             minor_segments = mxnthargscalar (nrhs, prhs, 5, 2);
         }
         
-        ph.initialize_create_torus( radius_major, radius_minor, is_centered, major_segments, minor_segments );
+        engine.make_torus( radius_major, radius_minor, is_centered, major_segments, minor_segments );
+        
+    }
+    
+    void makesphere_tol (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // radius, centering flag and chordal tolerance expected
+        std::vector<int> nallowed;
+        nallowed.push_back (3);
+
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        double radius = mxnthargscalar (nrhs, prhs, 1, 2);
+        bool is_centered = ( (mxnthargscalar (nrhs, prhs, 2, 2) == 0) ? false : true );
+        double tol = mxnthargscalar (nrhs, prhs, 3, 2);
+        
+        engine.make_sphere_tol( radius, is_centered, tol );
+    }
+    
+    void makecylinder_tol (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // radius, height, centering flag and chordal tolerance expected
+        std::vector<int> nallowed;
+        nallowed.push_back (4);
+
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        double radius = mxnthargscalar (nrhs, prhs, 1, 2);
+        double height = mxnthargscalar (nrhs, prhs, 2, 2);
+        bool is_centered = ( (mxnthargscalar (nrhs, prhs, 3, 2) == 0) ? false : true );
+        double tol = mxnthargscalar (nrhs, prhs, 4, 2);
+        
+        engine.make_cylinder_tol( radius, height, is_centered, tol );
+    }
+    
+    void makecone_tol (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // radius, height, centering flag and chordal tolerance expected
+        std::vector<int> nallowed;
+        nallowed.push_back (4);
+
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        double radius = mxnthargscalar (nrhs, prhs, 1, 2);
+        double height = mxnthargscalar (nrhs, prhs, 2, 2);
+        bool is_centered = ( (mxnthargscalar (nrhs, prhs, 3, 2) == 0) ? false : true );
+        double tol = mxnthargscalar (nrhs, prhs, 4, 2);
+        
+        engine.make_cone_tol( radius, height, is_centered, tol );
+    }
+    
+    void maketorus_tol (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // major and minor radii, centering flag and chordal tolerance 
+        // expected
+        std::vector<int> nallowed;
+        nallowed.push_back (4);
+
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        double radius_major = mxnthargscalar (nrhs, prhs, 1, 2);
+        double radius_minor = mxnthargscalar (nrhs, prhs, 2, 2);
+        bool is_centered = ( (mxnthargscalar (nrhs, prhs, 3, 2) == 0) ? false : true );
+        double tol = mxnthargscalar (nrhs, prhs, 4, 2);
+        
+        engine.make_torus_tol( radius_major, radius_minor, is_centered, tol );
+    }
+    
+    void surface_of_revolution_tol (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        std::vector<double> coords;
+        std::vector<int> lines; 
+        
+        // polygon, angle and chordal tolerance expected
+        std::vector<int> nallowed;
+        nallowed.push_back (4);
+
+        mxnarginchk (nrhs, nallowed, 2);
+
+        // get the polygon to be rotated
+        getpolygon (prhs[2], prhs[3], coords, lines);
+        
+        double angle = mxnthargscalar (nrhs, prhs, 3, 2);
+        double tol = mxnthargscalar (nrhs, prhs, 4, 2);
         
+        engine.make_surface_of_revolution_tol ( coords, lines, angle, tol );
     }
       
     
@@ -284,7 +537,7 @@ public:
         // check the appropriate number of input arguemtns were supplied
         mxnarginchk (nrhs, nallowed, 2);
       
-        int verts = ph.num_vertices ();
+        int verts = engine.num_vertices ();
       
         // return the number of vertices
         mxSetLHS (verts, 1, nlhs, plhs);
@@ -299,7 +552,7 @@ public:
         // check the appropriate number of input arguemtns were supplied
         mxnarginchk (nrhs, nallowed, 2);
       
-        int faces = ph.num_faces ();
+        int faces = engine.num_faces ();
       
         // return the number of vertices
         mxSetLHS (faces, 1, nlhs, plhs);
@@ -321,7 +574,7 @@ public:
         id = mxnthargscalar (nrhs, prhs, 1, 2);
 
         // get the vertex from the polyhedron
-        ph.get_vertex( id, x, y, z );
+        engine.get_vertex( id, x, y, z );
 
         // return it
         double vert[3] = {x,y,z};
@@ -343,7 +596,7 @@ public:
         // get the desired vertex id
         face_id = mxnthargscalar (nrhs, prhs, 1, 2);
         
-        int nverts = ph.num_face_vertices (face_id);
+        int nverts = engine.num_face_vertices (face_id);
 
         // return the number of faces
         mxSetLHS (nverts, 1, nlhs, plhs);
@@ -355,7 +608,7 @@ public:
     {
         double x, y, z;
         int face_id = 0;
-        int *vertex_id_list;
+        std::vector<int> vertex_id_list;
         std::vector<int> nallowed;
 
         // only a single argument is allowed (in addition to class handle
@@ -366,43 +619,187 @@ public:
         // get the desired vertex id
         face_id = mxnthargscalar (nrhs, prhs, 1, 2);
         
-        int nverts = ph.num_face_vertices (face_id);
-
-        vertex_id_list = new int [nverts];
-        
-        ph.get_face_vertices( face_id, vertex_id_list );
+        engine.get_face_vertices( face_id, vertex_id_list );
 
         // return the list
-        mxSetLHS (vertex_id_list, 1, nverts, nlhs, plhs);
+        mxSetLHS (vertex_id_list, 1, nlhs, plhs);
+    }
+    
+    void get_patch_data (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // all the geometry in the form taken by patch, Faces (1-based, 
+        // padded with NaN for faces with fewer vertices), Vertices and 
+        // optionally VertexNormals
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        mesh_data mesh;
+        engine.get_mesh (mesh);
+        
+        mwSize nfaces = mesh.num_faces ();
+        mwSize nverts = mesh.num_vertices ();
+        
+        int maxn = 0;
+        for (mwSize f = 0; f < nfaces; f++)
+        {
+            maxn = std::max (maxn, mesh.face_size (f));
+        }
+        
+        plhs[0] = mxCreateDoubleMatrix (nfaces, maxn, mxREAL);
+        
+        double *faces = mxGetPr (plhs[0]);
+        double nan = mxGetNaN ();
+        
+        for (mwSize f = 0; f < nfaces; f++)
+        {
+            int n = mesh.face_size (f);
+            const int *verts = mesh.face (f);
+            
+            for (int k = 0; k < maxn; k++)
+            {
+                faces[f + k*nfaces] = (k < n) ? verts[k] + 1.0 : nan;
+            }
+        }
+        
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateDoubleMatrix (nverts, 3, mxREAL);
+            copy_columns (mesh.coords, nverts, mxGetPr (plhs[1]));
+        }
+        
+        if (nlhs > 2)
+        {
+            std::vector<double> normals;
+            vertex_normals (mesh, normals);
+            
+            plhs[2] = mxCreateDoubleMatrix (nverts, 3, mxREAL);
+            copy_columns (normals, nverts, mxGetPr (plhs[2]));
+        }
+    }
+    
+    void get_edges (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the 1-based vertex indices of every edge, lower index first, and
+        // optionally the number of faces using each edge
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        std::shared_ptr<const mesh_adjacency> adj = engine.adjacency ();
+        
+        mwSize nedges = adj->num_edges ();
+        
+        plhs[0] = mxCreateDoubleMatrix (nedges, 2, mxREAL);
+        
+        double *edges = mxGetPr (plhs[0]);
+        
+        for (mwSize e = 0; e < nedges; e++)
+        {
+            edges[e] = adj->edge_verts[2*e] + 1.0;
+            edges[e + nedges] = adj->edge_verts[2*e+1] + 1.0;
+        }
+        
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateDoubleMatrix (nedges, 1, mxREAL);
+            
+            double *counts = mxGetPr (plhs[1]);
+            
+            for (mwSize e = 0; e < nedges; e++)
+            {
+                counts[e] = adj->edge_face_start[e+1] - adj->edge_face_start[e];
+            }
+        }
+    }
+    
+    void get_face_adjacency (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // laid out as the Faces of get_patch_data, the 1-based index of the
+        // face across the edge from each vertex to the next, 0 for boundary
+        // and non-manifold edges, NaN padding
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        std::shared_ptr<const mesh_adjacency> adj = engine.adjacency ();
+        
+        mwSize nfaces = engine.num_faces ();
+        mwSize nhalf = adj->num_half_edges ();
+        
+        // the faces are numbered in order along the half-edges
+        std::vector<int> face_start (nfaces + 1, 0);
+        int maxn = 0;
+        
+        for (mwSize h = 0; h < nhalf; h++)
+        {
+            face_start[adj->half_face[h] + 1]++;
+        }
+        
+        for (mwSize f = 0; f < nfaces; f++)
+        {
+            maxn = std::max (maxn, face_start[f+1]);
+            face_start[f+1] += face_start[f];
+        }
+        
+        plhs[0] = mxCreateDoubleMatrix (nfaces, maxn, mxREAL);
         
-        delete[] vertex_id_list;
+        double *neighbours = mxGetPr (plhs[0]);
+        double nan = mxGetNaN ();
+        
+        for (mwSize f = 0; f < nfaces; f++)
+        {
+            int n = face_start[f+1] - face_start[f];
+            
+            for (int k = 0; k < maxn; k++)
+            {
+                neighbours[f + k*nfaces] = (k < n) ? adj->neighbour (face_start[f] + k) + 1.0 : nan;
+            }
+        }
+    }
+    
+    void is_manifold (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // whether the surface is manifold, and optionally whether it is 
+        // also closed
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        std::shared_ptr<const mesh_adjacency> adj = engine.adjacency ();
+        
+        plhs[0] = mxCreateLogicalScalar (adj->is_manifold ());
+        
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateLogicalScalar (adj->is_closed ());
+        }
     }
     
-    polyhedron* getpolyhedron ()
+    const polyhedron_engine* getengine ()
     {
-        return &ph;
+        return &engine;
     }
     
     void csgunion(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) 
     {
-        polyhedron_union union_op;
-
-        // get a pointer to the underlying polyhedron in the other wrapper
-        polyhedron* otherph = getotherpoly(nrhs, prhs);
+        // get a pointer to the underlying polyhedron in the other wrapper,
+        // and the backend if one was given
+        csg_backend backend;
+        const polyhedron_engine* otherph = getbooleanargs(nrhs, prhs, backend);
       
         // replace the polyhedron from this obect with the union of it and the
         // other
         if (otherph != NULL)
         {
-            try
-            {
-                ph = union_op (ph, *otherph);
-            }
-            catch (...)
-            {
-                mexErrMsgIdAndTxt("CSG:union",
-                    "Union operation failed, exception thrown.");
-            }
+            progress_token progress;
+            start_progress (progress);
+            
+            engine.csg_union (*otherph, &progress, backend);
         }
         else
         {
@@ -413,27 +810,31 @@ public:
     
     void csgdifference(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) 
     {
-        polyhedron_difference diff_op;
-
         // get a pointer to the underlying polyhedron in the other wrapper
-        polyhedron* otherph = getotherpoly(nrhs, prhs);
+        csg_backend backend;
+        const polyhedron_engine* otherph = getbooleanargs(nrhs, prhs, backend);
       
         // replace the polyhedron from this obect with the difference of it and 
         // the other
-        ph = diff_op (ph, *otherph);
+        progress_token progress;
+        start_progress (progress);
+        
+        engine.csg_difference (*otherph, &progress, backend);
         
     }
     
     void csgsymmdifference(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
     {
-        polyhedron_symmetric_difference symmdiff_op;
-      
         // get a pointer to the underlying polyhedron in the other wrapper
-        polyhedron* otherph = getotherpoly(nrhs, prhs);
+        csg_backend backend;
+        const polyhedron_engine* otherph = getbooleanargs(nrhs, prhs, backend);
       
         // replace the polyhedron from this obect with the difference of it and 
         // the other
-        ph = symmdiff_op (ph, *otherph);
+        progress_token progress;
+        start_progress (progress);
+        
+        engine.csg_symmetric_difference (*otherph, &progress, backend);
       
     }
     
@@ -449,7 +850,7 @@ public:
         double y = mxnthargscalar (nrhs, prhs, 2, 2);
         double z = mxnthargscalar (nrhs, prhs, 3, 2);
           
-        ph = ph.translate( x, y, z );
+        engine.translate( x, y, z );
     }
 
     void rotate(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -464,7 +865,7 @@ public:
         double theta_y = mxnthargscalar (nrhs, prhs, 2, 2);
         double theta_z = mxnthargscalar (nrhs, prhs, 3, 2);
           
-        ph = ph.rotate( theta_x, theta_y, theta_z );
+        engine.rotate( theta_x, theta_y, theta_z );
     }
     
     void scale(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -479,7 +880,7 @@ public:
         double y = mxnthargscalar (nrhs, prhs, 2, 2);
         double z = mxnthargscalar (nrhs, prhs, 3, 2);
           
-        ph = ph.scale( x, y, z );
+        engine.scale( x, y, z );
     }
     
     void rotmat(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -501,9 +902,11 @@ public:
         double zy = mxnthargscalar (nrhs, prhs, 8, 2);
         double zz = mxnthargscalar (nrhs, prhs, 9, 2);
           
-        ph = ph.mult_matrix_3( xx, xy, xz,
-                               yx, yy, yz,
-                               zx, zy, zz );
+        double m[9] = { xx, xy, xz,
+                        yx, yy, yz,
+                        zx, zy, zz };
+          
+        engine.mult_matrix_3( m );
 
     }
     
@@ -534,40 +937,966 @@ public:
         double az = mxnthargscalar (nrhs, prhs, 15, 2);
         double aa = mxnthargscalar (nrhs, prhs, 16, 2);
       
-        ph =  ph.mult_matrix_4( xx, xy, xz, xa,
-                                yx, yy, yz, ya,
-                                zx, zy, zz, za,
-                                ax, ay, az, aa );
+        double m[16] = { xx, xy, xz, xa,
+                         yx, yy, yz, ya,
+                         zx, zy, zz, za,
+                         ax, ay, az, aa };
+      
+        engine.mult_matrix_4( m );
     }
     
     
     void triangulate (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
     {
-        ph = ph.triangulate ();
+        int num_threads = 0;
+        
+        // optionally the number of threads to use
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        nallowed.push_back (1);
+        
+        int offsetrhs = mxnarginchk (nrhs, nallowed, 2);
+        
+        if (offsetrhs > 0)
+        {
+            num_threads = mxnthargscalar (nrhs, prhs, 1, 2);
+        }
+        
+        engine.triangulate (num_threads);
     }
     
-private:
-
-    polyhedron ph;
-
-    polyhedron* getotherpoly(int nrhs, const mxArray *prhs[]) 
+    void simplify (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
     {
-        // only a single argument is allowed (in addition to class handle
-        // arguments)
+        double max_error = -1.0;
+        
+        // target number of faces, and optionally the maximum error
         std::vector<int> nallowed;
         nallowed.push_back (1);
-        mxnarginchk (nrhs, nallowed, 2);
-
-        // get the pointer to the other nterface class
-        polyhedron_interface* otherph_interface = convertMat2Ptr<polyhedron_interface>(prhs[2]);
-
-        // get a pointer to the underlying polyhedron in the other wrapper
-        polyhedron* otherph = otherph_interface->getpolyhedron ();
-      
-        return otherph;
+        nallowed.push_back (2);
+        
+        int offsetrhs = mxnarginchk (nrhs, nallowed, 2);
+        
+        int target_faces = mxnthargscalar (nrhs, prhs, 1, 2);
+        
+        if (offsetrhs > 1)
+        {
+            max_error = mxnthargscalar (nrhs, prhs, 2, 2);
+        }
+        
+        progress_token progress;
+        start_progress (progress);
+        
+        engine.simplify (target_faces, max_error, &progress);
     }
     
-    void getpolygon (const mxArray * coordsMxArray, const mxArray * linesMxArray, std::vector<double> &coords, std::vector<int> &lines)
+    void offset (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the offset distance expected
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        engine.offset (mxnthargscalar (nrhs, prhs, 1, 2));
+    }
+    
+    void shell (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the wall thickness expected
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        engine.shell (mxnthargscalar (nrhs, prhs, 1, 2));
+    }
+    
+    void num_components (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // no input arguments expected
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        mxSetLHS (engine.num_components (), 1, nlhs, plhs);
+    }
+    
+    void split_components (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // no input arguments expected
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        std::vector<polyhedron_engine> parts;
+        engine.split_components (parts);
+        
+        // a cell array of handles to new interface objects, one per 
+        // component, which take over the geometry of the parts
+        plhs[0] = mxCreateCellMatrix (1, parts.size ());
+        
+        for (size_t i = 0; i < parts.size (); i++)
+        {
+            polyhedron_interface *part = new polyhedron_interface;
+            part->engine.share (parts[i]);
+            
+            mxSetCell (plhs[0], i, convertPtr2Mat<polyhedron_interface> (part));
+        }
+    }
+    
+    void voxelize (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the grid origin, spacing and dimensions, optionally the number of
+        // rows per voxel along y and z for volume fractions, and a block
+        // size for sparse output
+        std::vector<int> nallowed;
+        nallowed.push_back (3);
+        nallowed.push_back (4);
+        nallowed.push_back (5);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        voxel_grid grid;
+        getgrid (prhs, grid);
+        
+        int block_size = 0;
+        
+        if (noffset > 3)
+        {
+            grid.supersample = mxnthargscalar (nrhs, prhs, 4, 2);
+        }
+        
+        if (noffset > 4)
+        {
+            block_size = mxnthargscalar (nrhs, prhs, 5, 2);
+        }
+        
+        bool fractions = (grid.supersample > 0);
+        
+        if (block_size <= 0)
+        {
+            // the whole grid as an array with the same dimensions
+            mwSize dims[3] = { (mwSize)grid.dims[0], (mwSize)grid.dims[1], (mwSize)grid.dims[2] };
+            
+            if (fractions)
+            {
+                plhs[0] = mxCreateNumericArray (3, dims, mxSINGLE_CLASS, mxREAL);
+                engine.voxelize (grid, (float*)mxGetData (plhs[0]));
+            }
+            else
+            {
+                plhs[0] = mxCreateLogicalArray (3, dims);
+                engine.voxelize (grid, (bool*)mxGetData (plhs[0]));
+            }
+            
+            return;
+        }
+        
+        sparse_voxels voxels;
+        engine.voxelize_sparse (grid, block_size, voxels);
+        
+        // a structure of the blocks with any part inside, giving their 
+        // 1-based block indices and values, and the blocks entirely inside
+        const char *fieldnames[] = { "dims", "block_size", "full", "partial", "values" };
+        
+        plhs[0] = mxCreateStructMatrix (1, 1, 5, fieldnames);
+        
+        mxArray *dims = mxCreateDoubleMatrix (1, 3, mxREAL);
+        std::copy (grid.dims, grid.dims + 3, mxGetPr (dims));
+        
+        mxSetField (plhs[0], 0, "dims", dims);
+        mxSetField (plhs[0], 0, "block_size", mxCreateDoubleScalar (block_size));
+        mxSetField (plhs[0], 0, "full", block_indices (voxels.full_blocks));
+        mxSetField (plhs[0], 0, "partial", block_indices (voxels.partial_blocks));
+        
+        mwSize nblocks = voxels.partial_blocks.size () / 3;
+        mwSize value_dims[4] = { (mwSize)block_size, (mwSize)block_size, (mwSize)block_size, nblocks };
+        mxArray *values;
+        
+        if (fractions)
+        {
+            values = mxCreateNumericArray (4, value_dims, mxSINGLE_CLASS, mxREAL);
+            std::copy (voxels.values.begin (), voxels.values.end (), (float*)mxGetData (values));
+        }
+        else
+        {
+            values = mxCreateLogicalArray (4, value_dims);
+            
+            bool *occupied = (bool*)mxGetData (values);
+            
+            for (size_t i = 0; i < voxels.values.size (); i++)
+            {
+                occupied[i] = (voxels.values[i] >= 0.5f);
+            }
+        }
+        
+        mxSetField (plhs[0], 0, "values", values);
+    }
+    
+    void hausdorff (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the other polyhedron, and optionally the number of samples on 
+        // each surface
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        nallowed.push_back (2);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        const polyhedron_engine* otherph = convertMat2Ptr<polyhedron_interface>(prhs[2])->getengine ();
+        
+        long samples = (noffset > 1) ? (long)mxnthargscalar (nrhs, prhs, 2, 2) : DEFAULT_DISTANCE_SAMPLES;
+        
+        deviation_stats stats = engine.hausdorff (*otherph, samples);
+        
+        // the maximum deviation, and optionally the mean and rms
+        plhs[0] = mxCreateDoubleScalar (stats.max);
+        
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateDoubleScalar (stats.mean);
+        }
+        
+        if (nlhs > 2)
+        {
+            plhs[2] = mxCreateDoubleScalar (stats.rms);
+        }
+    }
+    
+    void approx_equal (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the other polyhedron, the tolerance, and optionally the number of 
+        // samples on each surface
+        std::vector<int> nallowed;
+        nallowed.push_back (2);
+        nallowed.push_back (3);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        const polyhedron_engine* otherph = convertMat2Ptr<polyhedron_interface>(prhs[2])->getengine ();
+        
+        double tol = mxnthargscalar (nrhs, prhs, 2, 2);
+        long samples = (noffset > 2) ? (long)mxnthargscalar (nrhs, prhs, 3, 2) : DEFAULT_DISTANCE_SAMPLES;
+        
+        plhs[0] = mxCreateLogicalScalar (engine.approx_equal (*otherph, tol, samples));
+    }
+    
+    void quality_report (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // optionally the number of histogram bins and the sliver angle
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        nallowed.push_back (1);
+        nallowed.push_back (2);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        int nbins = (noffset > 0) ? (int)mxnthargscalar (nrhs, prhs, 1, 2) : DEFAULT_QUALITY_BINS;
+        double sliver_angle = (noffset > 1) ? mxnthargscalar (nrhs, prhs, 2, 2) : DEFAULT_SLIVER_ANGLE;
+        
+        mxnaroutgchk (nlhs, 1);
+        
+        mpolycsg::quality_report report = engine.quality (nbins, sliver_angle);
+        
+        const char *fieldnames[] = { "num_triangles", "num_degenerate", "min_angle", "max_angle",
+                                     "max_aspect_ratio", "mean_aspect_ratio", "sliver_angle", "num_slivers",
+                                     "num_edges", "min_edge", "max_edge", "mean_edge", "edge_bins",
+                                     "edge_counts", "num_boundary_edges", "num_nonmanifold_edges",
+                                     "num_nonmanifold_vertices" };
+        
+        plhs[0] = mxCreateStructMatrix (1, 1, 17, fieldnames);
+        
+        mxSetField (plhs[0], 0, "num_triangles", mxCreateDoubleScalar ((double)report.num_triangles));
+        mxSetField (plhs[0], 0, "num_degenerate", mxCreateDoubleScalar ((double)report.num_degenerate));
+        mxSetField (plhs[0], 0, "min_angle", mxCreateDoubleScalar (report.min_angle));
+        mxSetField (plhs[0], 0, "max_angle", mxCreateDoubleScalar (report.max_angle));
+        mxSetField (plhs[0], 0, "max_aspect_ratio", mxCreateDoubleScalar (report.max_aspect_ratio));
+        mxSetField (plhs[0], 0, "mean_aspect_ratio", mxCreateDoubleScalar (report.mean_aspect_ratio));
+        mxSetField (plhs[0], 0, "sliver_angle", mxCreateDoubleScalar (report.sliver_angle));
+        mxSetField (plhs[0], 0, "num_slivers", mxCreateDoubleScalar ((double)report.num_slivers));
+        mxSetField (plhs[0], 0, "num_edges", mxCreateDoubleScalar ((double)report.num_edges));
+        mxSetField (plhs[0], 0, "min_edge", mxCreateDoubleScalar (report.min_edge));
+        mxSetField (plhs[0], 0, "max_edge", mxCreateDoubleScalar (report.max_edge));
+        mxSetField (plhs[0], 0, "mean_edge", mxCreateDoubleScalar (report.mean_edge));
+        
+        // the histogram as row vectors, the bin limits and the counts
+        mxArray *bins = mxCreateDoubleMatrix (1, report.edge_bins.size (), mxREAL);
+        std::copy (report.edge_bins.begin (), report.edge_bins.end (), mxGetPr (bins));
+        
+        mxArray *counts = mxCreateDoubleMatrix (1, report.edge_counts.size (), mxREAL);
+        std::copy (report.edge_counts.begin (), report.edge_counts.end (), mxGetPr (counts));
+        
+        mxSetField (plhs[0], 0, "edge_bins", bins);
+        mxSetField (plhs[0], 0, "edge_counts", counts);
+        
+        mxSetField (plhs[0], 0, "num_boundary_edges", mxCreateDoubleScalar ((double)report.num_boundary_edges));
+        mxSetField (plhs[0], 0, "num_nonmanifold_edges", mxCreateDoubleScalar ((double)report.num_nonmanifold_edges));
+        mxSetField (plhs[0], 0, "num_nonmanifold_vertices", mxCreateDoubleScalar ((double)report.num_nonmanifold_vertices));
+    }
+    
+    void serialize (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        bool compress = false;
+        
+        // optional compression flag
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        nallowed.push_back (1);
+        
+        int offsetrhs = mxnarginchk (nrhs, nallowed, 2);
+        
+        if (offsetrhs > 0)
+        {
+            compress = ( (mxnthargscalar (nrhs, prhs, 1, 2) == 0) ? false : true );
+        }
+        
+        mxnaroutgchk (nlhs, 1);
+        
+        std::vector<unsigned char> blob;
+        
+        engine.serialize (blob, compress);
+        
+        // return the encoded polyhedron as a uint8 row vector
+        plhs[0] = mxCreateNumericMatrix(1, blob.size (), mxUINT8_CLASS, mxREAL);
+        
+        if (!blob.empty ())
+        {
+            std::memcpy (mxGetData (plhs[0]), &blob[0], blob.size ());
+        }
+    }
+    
+    void deserialize (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the uint8 array produced by serialize is expected
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        if (mxGetClassID (prhs[2]) != mxUINT8_CLASS)
+        {
+            mexErrMsgIdAndTxt("CSG:deserialize",
+                "Serialized polyhedron must be a uint8 array.");
+        }
+        
+        engine.deserialize ((const unsigned char *)mxGetData (prhs[2]), 
+                            mxGetNumberOfElements (prhs[2]));
+    }
+    
+    void save_binary (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        bool compress = false;
+        
+        // file name, and optional compression flag
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        nallowed.push_back (2);
+        
+        int offsetrhs = mxnarginchk (nrhs, nallowed, 2);
+        
+        std::string filename = mxnthargstring (nrhs, prhs, 1, 2);
+        
+        if (offsetrhs > 1)
+        {
+            compress = ( (mxnthargscalar (nrhs, prhs, 2, 2) == 0) ? false : true );
+        }
+        
+        engine.save_binary (filename, compress);
+    }
+    
+    void load_binary (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // file name expected
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        std::string filename = mxnthargstring (nrhs, prhs, 1, 2);
+        
+        engine.load_binary (filename);
+    }
+    
+    void export_bodies (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the file name and a cell array of handles to the polyhedra, 
+        // optionally a (4 x 4 x n) array of transforms, a cell array of 
+        // names and the format, each of which may be empty
+        std::vector<int> nallowed;
+        nallowed.push_back (2);
+        nallowed.push_back (3);
+        nallowed.push_back (4);
+        nallowed.push_back (5);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        std::string filename = mxnthargstring (nrhs, prhs, 1, 2);
+        
+        const mxArray *handles = prhs[3];
+        
+        if (!mxIsCell (handles))
+        {
+            mexErrMsgIdAndTxt("CSG:export_bodies",
+                "The polyhedra must be given as a cell array of handles.");
+        }
+        
+        mwSize nbodies = mxGetNumberOfElements (handles);
+        
+        std::vector<const polyhedron_engine*> bodies;
+        
+        for (mwSize i = 0; i < nbodies; i++)
+        {
+            bodies.push_back (convertMat2Ptr<polyhedron_interface>(mxGetCell (handles, i))->getengine ());
+        }
+        
+        // the transforms are stored column by column, the engine expects 
+        // them row by row
+        std::vector<double> matrices;
+        std::vector<const double*> transforms;
+        
+        if (noffset > 2 && !mxIsEmpty (prhs[4]))
+        {
+            if (!mxIsDouble (prhs[4]) || mxGetM (prhs[4]) != 4 
+                || mxGetNumberOfElements (prhs[4]) != 16 * nbodies)
+            {
+                mexErrMsgIdAndTxt("CSG:export_bodies",
+                    "The transforms must be a (4 x 4 x n) array, one per polyhedron.");
+            }
+            
+            const double *t = mxGetPr (prhs[4]);
+            
+            matrices.resize (16 * nbodies);
+            
+            for (mwSize i = 0; i < nbodies; i++)
+            {
+                for (int r = 0; r < 4; r++)
+                {
+                    for (int c = 0; c < 4; c++)
+                    {
+                        matrices[16*i + 4*r + c] = t[16*i + r + 4*c];
+                    }
+                }
+            }
+            
+            for (mwSize i = 0; i < nbodies; i++)
+            {
+                transforms.push_back (&matrices[16*i]);
+            }
+        }
+        
+        std::vector<std::string> names;
+        
+        if (noffset > 3 && !mxIsEmpty (prhs[5]))
+        {
+            if (!mxIsCell (prhs[5]) || mxGetNumberOfElements (prhs[5]) != nbodies)
+            {
+                mexErrMsgIdAndTxt("CSG:export_bodies",
+                    "The names must be a cell array of strings, one per polyhedron.");
+            }
+            
+            for (mwSize i = 0; i < nbodies; i++)
+            {
+                char *name = mxArrayToString (mxGetCell (prhs[5], i));
+                
+                if (name == NULL)
+                {
+                    mexErrMsgIdAndTxt("CSG:export_bodies",
+                        "The names must be a cell array of strings, one per polyhedron.");
+                }
+                
+                names.push_back (name);
+                mxFree (name);
+            }
+        }
+        
+        // the format, or if not given the extension of the file name
+        std::string format_name = filename;
+        
+        if (noffset > 4 && !mxIsEmpty (prhs[6]))
+        {
+            format_name = mxnthargstring (nrhs, prhs, 5, 2);
+        }
+        
+        export_format format;
+        
+        if (!parse_export_format (format_name, format))
+        {
+            mexErrMsgIdAndTxt("CSG:export_bodies",
+                "Unknown export format, expected 'stl', 'stl_ascii', 'obj' or 'ply'.");
+        }
+        
+        mpolycsg::export_bodies (filename, format, bodies, transforms, names);
+    }
+    
+    void interference (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // a cell array of handles to the parts, and optionally the voxel
+        // resolution used for the overlap volumes
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        nallowed.push_back (2);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        std::vector<const polyhedron_engine*> parts;
+        
+        getengines (prhs[2], parts, "CSG:interference");
+        
+        int resolution = (noffset > 1) ? (int)mxnthargscalar (nrhs, prhs, 2, 2) : DEFAULT_INTERFERENCE_RESOLUTION;
+        
+        if (resolution < 1)
+        {
+            mexErrMsgIdAndTxt("CSG:interference",
+                "The volume resolution must be at least one voxel.");
+        }
+        
+        // the volumes are only found when they are asked for
+        std::vector<interference_pair> pairs;
+        mpolycsg::interference (parts, pairs, (nlhs > 1) ? resolution : 0);
+        
+        // the 1-based indices of the parts in each pair, one pair per
+        // row, then the volumes and whether one part is inside the other
+        mwSize npairs = pairs.size ();
+        
+        plhs[0] = mxCreateDoubleMatrix (npairs, 2, mxREAL);
+        
+        double *indices = mxGetPr (plhs[0]);
+        
+        for (mwSize i = 0; i < npairs; i++)
+        {
+            indices[i] = pairs[i].a + 1.0;
+            indices[i + npairs] = pairs[i].b + 1.0;
+        }
+        
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateDoubleMatrix (npairs, 1, mxREAL);
+            
+            double *volumes = mxGetPr (plhs[1]);
+            
+            for (mwSize i = 0; i < npairs; i++)
+            {
+                volumes[i] = pairs[i].volume;
+            }
+        }
+        
+        if (nlhs > 2)
+        {
+            mwSize dims[2] = { npairs, 1 };
+            plhs[2] = mxCreateLogicalArray (2, dims);
+            
+            bool *contained = (bool*)mxGetData (plhs[2]);
+            
+            for (mwSize i = 0; i < npairs; i++)
+            {
+                contained[i] = pairs[i].contained;
+            }
+        }
+    }
+    
+    void boolean_batch (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // the operation, two cell arrays of handles to the operands, and 
+        // optionally the backend used in the workers
+        std::vector<int> nallowed;
+        nallowed.push_back (3);
+        nallowed.push_back (4);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        std::string opname = mxnthargstring (nrhs, prhs, 1, 2);
+        
+        boolean_op op = boolean_union;
+        
+        if (opname == "union") { op = boolean_union; }
+        else if (opname == "difference") { op = boolean_difference; }
+        else if (opname == "symmetric_difference") { op = boolean_symmetric_difference; }
+        else
+        {
+            mexErrMsgIdAndTxt("CSG:boolean_batch",
+                "Unknown operation '%s', expected 'union', 'difference' or 'symmetric_difference'.", opname.c_str ());
+        }
+        
+        std::vector<const polyhedron_engine*> a, b;
+        
+        getengines (prhs[3], a, "CSG:boolean_batch");
+        getengines (prhs[4], b, "CSG:boolean_batch");
+        
+        csg_backend backend = (noffset > 3) ? getbackend (nrhs, prhs, 4) : backend_default;
+        
+        progress_token progress;
+        start_progress (progress);
+        
+        std::vector<polyhedron_engine> results;
+        isolated_booleans (op, a, b, results, backend, &progress);
+        
+        // a cell array of handles to new interface objects holding the 
+        // results
+        plhs[0] = mxCreateCellMatrix (1, results.size ());
+        
+        for (size_t i = 0; i < results.size (); i++)
+        {
+            polyhedron_interface *result = new polyhedron_interface;
+            result->engine.share (results[i]);
+            
+            mxSetCell (plhs[0], i, convertPtr2Mat<polyhedron_interface> (result));
+        }
+    }
+    
+    void set_workers (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // optionally the number of worker processes, the path of the
+        // worker executable, which is kept if empty, and the timeout for a
+        // job, the previous number is returned
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        nallowed.push_back (1);
+        nallowed.push_back (2);
+        nallowed.push_back (3);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        int previous = worker_count ();
+        
+        if (noffset > 2)
+        {
+            try
+            {
+                set_worker_timeout (mxnthargscalar (nrhs, prhs, 3, 2));
+            }
+            catch (std::invalid_argument &e)
+            {
+                throw csg_error ("CSG:set_workers", e.what ());
+            }
+        }
+        
+        if (noffset > 1 && !mxIsEmpty (prhs[3]))
+        {
+            set_worker_path (mxnthargstring (nrhs, prhs, 2, 2));
+        }
+        
+        if (noffset > 0)
+        {
+            // this also stops the idle workers, so a new path takes effect
+            set_worker_count ((int)mxnthargscalar (nrhs, prhs, 1, 2));
+        }
+        
+        plhs[0] = mxCreateDoubleScalar (previous);
+    }
+    
+    void stats (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        mxnaroutgchk (nlhs, 1);
+        
+        std::map<std::string, op_stats> ops = stats_registry::instance ().snapshot ();
+        
+        // one element of a struct array per operation called so far
+        const char *fieldnames[] = { "name", "calls", "total_time", "max_time", 
+                                     "mean_time", "bytes_allocated", "faces_in", "faces_out" };
+        
+        plhs[0] = mxCreateStructMatrix (1, ops.size (), 8, fieldnames);
+        
+        mwIndex i = 0;
+        for (std::map<std::string, op_stats>::const_iterator it = ops.begin (); it != ops.end (); ++it, i++)
+        {
+            const op_stats &s = it->second;
+            
+            mxSetField (plhs[0], i, "name", mxCreateString (it->first.c_str ()));
+            mxSetField (plhs[0], i, "calls", mxCreateDoubleScalar ((double)s.calls));
+            mxSetField (plhs[0], i, "total_time", mxCreateDoubleScalar (s.total_time));
+            mxSetField (plhs[0], i, "max_time", mxCreateDoubleScalar (s.max_time));
+            mxSetField (plhs[0], i, "mean_time", mxCreateDoubleScalar (s.calls > 0 ? s.total_time / s.calls : 0.0));
+            mxSetField (plhs[0], i, "bytes_allocated", mxCreateDoubleScalar ((double)s.bytes_allocated));
+            mxSetField (plhs[0], i, "faces_in", mxCreateDoubleScalar ((double)s.faces_in));
+            mxSetField (plhs[0], i, "faces_out", mxCreateDoubleScalar ((double)s.faces_out));
+        }
+    }
+    
+    void reset_stats (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        stats_registry::instance ().reset ();
+    }
+    
+    void progress_interval (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // seconds between progress reports for long operations, zero or 
+        // inf to switch them off
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        progress_report_interval = mxnthargscalar (nrhs, prhs, 1, 2);
+    }
+    
+    void set_backend (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // optionally the name of the new default backend and the snap
+        // tolerance of the robust backend, the previous name and
+        // tolerance are returned
+        std::vector<int> nallowed;
+        nallowed.push_back (0);
+        nallowed.push_back (1);
+        nallowed.push_back (2);
+        
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        std::string previous = backend_name (default_backend ());
+        double previous_tolerance = snap_tolerance ();
+        
+        if (noffset > 1)
+        {
+            // the range is checked by the engine
+            try
+            {
+                set_snap_tolerance (mxnthargscalar (nrhs, prhs, 2, 2));
+            }
+            catch (std::invalid_argument &e)
+            {
+                throw csg_error ("CSG:set_backend", e.what ());
+            }
+        }
+        
+        if (noffset > 0)
+        {
+            set_default_backend (getbackend (nrhs, prhs, 1));
+        }
+        
+        plhs[0] = mxCreateString (previous.c_str ());
+        
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateDoubleScalar (previous_tolerance);
+        }
+    }
+    
+    void trace (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // switch the recording of trace events on or off
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        stats_registry::instance ().set_tracing (mxnthargscalar (nrhs, prhs, 1, 2) != 0);
+    }
+    
+    void trace_dump (int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+    {
+        // file name expected
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        
+        mxnarginchk (nrhs, nallowed, 2);
+        
+        std::string filename = mxnthargstring (nrhs, prhs, 1, 2);
+        
+        if (!stats_registry::instance ().write_trace (filename))
+        {
+            mexErrMsgIdAndTxt("CSG:trace_dump",
+                "Could not write trace file %s.", filename.c_str ());
+        }
+    }
+    
+private:
+
+    // the engine doing the actual work
+    polyhedron_engine engine;
+
+    // set up the progress token for a long operation, progress is printed 
+    // in the command window and Ctrl-C cancels the operation
+    void start_progress (progress_token &progress)
+    {
+        progress.set_interrupt_check (interrupt_pending);
+        
+        if (progress_report_interval > 0 && std::isfinite (progress_report_interval))
+        {
+            progress.set_progress_callback (print_progress, progress_report_interval, progress_report_interval);
+        }
+        
+        progress.start ();
+    }
+    
+    // copy x, y, z triplets into the columns of an n x 3 matrix
+    static void copy_columns (const std::vector<double> &xyz, mwSize n, double *matrix)
+    {
+        for (mwSize i = 0; i < n; i++)
+        {
+            matrix[i] = xyz[3*i];
+            matrix[i + n] = xyz[3*i+1];
+            matrix[i + 2*n] = xyz[3*i+2];
+        }
+    }
+    
+    // the 1-based x, y, z block indices as the rows of an n x 3 matrix
+    static mxArray* block_indices (const std::vector<int> &blocks)
+    {
+        mwSize n = blocks.size () / 3;
+        mxArray *indices = mxCreateDoubleMatrix (n, 3, mxREAL);
+        double *ind = mxGetPr (indices);
+        
+        for (mwSize i = 0; i < n; i++)
+        {
+            for (int d = 0; d < 3; d++)
+            {
+                ind[i + d*n] = blocks[3*i+d] + 1.0;
+            }
+        }
+        
+        return indices;
+    }
+    
+    // the origin, spacing (one value for all axes or one for each) and 
+    // dimensions of a grid of voxels in the first three arguments
+    static void getgrid (const mxArray *prhs[], voxel_grid &grid)
+    {
+        const mxArray *origin = prhs[2];
+        const mxArray *spacing = prhs[3];
+        const mxArray *dims = prhs[4];
+        
+        if (!mxIsDouble (origin) || mxGetNumberOfElements (origin) != 3
+            || !mxIsDouble (dims) || mxGetNumberOfElements (dims) != 3)
+        {
+            mexErrMsgIdAndTxt("CSG:voxelize",
+                "The grid origin and dimensions must be vectors of three elements.");
+        }
+        
+        mwSize nspacing = mxGetNumberOfElements (spacing);
+        
+        if (!mxIsDouble (spacing) || (nspacing != 1 && nspacing != 3))
+        {
+            mexErrMsgIdAndTxt("CSG:voxelize",
+                "The grid spacing must be a scalar or a vector of three elements.");
+        }
+        
+        for (int d = 0; d < 3; d++)
+        {
+            // checked here, the dimensions size the output arrays before
+            // the engine sees them
+            double n = mxGetPr (dims)[d];
+            
+            if (!std::isfinite (n) || n < 0.0 || n != std::floor (n) || n > (double)INT_MAX)
+            {
+                mexErrMsgIdAndTxt("CSG:voxelize",
+                    "The grid dimensions must be non-negative integers.");
+            }
+            
+            grid.origin[d] = mxGetPr (origin)[d];
+            grid.spacing[d] = mxGetPr (spacing)[nspacing == 3 ? d : 0];
+            grid.dims[d] = (int)n;
+        }
+    }
+    
+    const polyhedron_engine* getotherpoly(int nrhs, const mxArray *prhs[]) 
+    {
+        // only a single argument is allowed (in addition to class handle
+        // arguments)
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        mxnarginchk (nrhs, nallowed, 2);
+
+        // get the pointer to the other nterface class
+        polyhedron_interface* otherph_interface = convertMat2Ptr<polyhedron_interface>(prhs[2]);
+
+        // get a pointer to the underlying polyhedron in the other wrapper
+        const polyhedron_engine* otherph = otherph_interface->getengine ();
+      
+        return otherph;
+    }
+    
+    // the other polyhedron of a boolean operation, and the backend to use 
+    // if its name is also given
+    const polyhedron_engine* getbooleanargs(int nrhs, const mxArray *prhs[], csg_backend &backend) 
+    {
+        std::vector<int> nallowed;
+        nallowed.push_back (1);
+        nallowed.push_back (2);
+        int noffset = mxnarginchk (nrhs, nallowed, 2);
+        
+        backend = (noffset > 1) ? getbackend (nrhs, prhs, 2) : backend_default;
+        
+        return convertMat2Ptr<polyhedron_interface>(prhs[2])->getengine ();
+    }
+    
+    static csg_backend getbackend (int nrhs, const mxArray *prhs[], int ntharg)
+    {
+        std::string name = mxnthargstring (nrhs, prhs, ntharg, 2);
+        
+        csg_backend backend;
+        
+        if (!parse_backend (name, backend))
+        {
+            mexErrMsgIdAndTxt("CSG:backend",
+                "Unknown backend '%s', the backend must be 'fast', 'robust', 'auto' or 'isolated'.", name.c_str ());
+        }
+        
+        return backend;
+    }
+    
+    // the engines of a cell array of handles to polyhedra
+    void getengines (const mxArray *handles, std::vector<const polyhedron_engine*> &engines, const char *errid)
+    {
+        if (!mxIsCell (handles))
+        {
+            mexErrMsgIdAndTxt(errid,
+                "Polyhedra must be supplied as a cell array of handles.");
+        }
+        
+        for (mwSize i = 0; i < mxGetNumberOfElements (handles); i++)
+        {
+            engines.push_back (convertMat2Ptr<polyhedron_interface>(mxGetCell (handles, i))->getengine ());
+        }
+    }
+    
+    void getloops (const mxArray * loopsMxArray, std::vector< std::vector<double> > &loops, const char *errid)
+    {
+        if (!mxIsCell (loopsMxArray))
+        {
+            mexErrMsgIdAndTxt(errid,
+                "Loops must be supplied as a cell array of (n x 2) matrices.");
+        }
+        
+        mwSize nloops = mxGetNumberOfElements (loopsMxArray);
+        
+        loops.resize (nloops);
+        
+        for (mwIndex l = 0; l < nloops; l++)
+        {
+            const mxArray *loop = mxGetCell (loopsMxArray, l);
+            
+            if (loop == NULL || !mxIsDouble (loop) || mxGetN (loop) != 2)
+            {
+                mexErrMsgIdAndTxt(errid,
+                    "Each loop must be a (n x 2) matrix of x and y coordinates.");
+            }
+            
+            // convert the column major matrix to x, y pairs
+            mwSize n = mxGetM (loop);
+            const double *xy = mxGetPr (loop);
+            
+            loops[l].resize (2 * n);
+            
+            for (mwSize i = 0; i < n; i++)
+            {
+                loops[l][2*i] = xy[i];
+                loops[l][2*i+1] = xy[i + n];
+            }
+        }
+    }
+    
+    void getpolygon (const mxArray * coordsMxArray, const mxArray * linesMxArray, std::vector<double> &coords, std::vector<int> &lines)
     {
         
         coords.clear ();
@@ -609,6 +1938,12 @@ private:
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 {
   
+  // errors from the engine are thrown as csg_error, and converted to 
+  // Matlab/Octave errors here
+  mex_error_raised () = false;
+  
+  try
+  {
      BEGIN_MEX_CLASS_WRAPPER(polyhedron_interface)
        REGISTER_CLASS_METHOD(polyhedron_interface,copy)
        REGISTER_CLASS_METHOD(polyhedron_interface,num_vertices)
@@ -616,6 +1951,10 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
        REGISTER_CLASS_METHOD(polyhedron_interface,get_vertex)
        REGISTER_CLASS_METHOD(polyhedron_interface,num_face_vertices)
        REGISTER_CLASS_METHOD(polyhedron_interface,get_face_vertices)
+       REGISTER_CLASS_METHOD(polyhedron_interface,get_patch_data)
+       REGISTER_CLASS_METHOD(polyhedron_interface,get_edges)
+       REGISTER_CLASS_METHOD(polyhedron_interface,get_face_adjacency)
+       REGISTER_CLASS_METHOD(polyhedron_interface,is_manifold)
        REGISTER_CLASS_METHOD(polyhedron_interface,csgunion)
        REGISTER_CLASS_METHOD(polyhedron_interface,csgdifference)
        REGISTER_CLASS_METHOD(polyhedron_interface,csgsymmdifference)
@@ -629,11 +1968,68 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
        REGISTER_CLASS_METHOD(polyhedron_interface,makecone)
        REGISTER_CLASS_METHOD(polyhedron_interface,maketorus)
        REGISTER_CLASS_METHOD(polyhedron_interface,makecylinder)
+       REGISTER_CLASS_METHOD(polyhedron_interface,makesphere_tol)
+       REGISTER_CLASS_METHOD(polyhedron_interface,makecone_tol)
+       REGISTER_CLASS_METHOD(polyhedron_interface,maketorus_tol)
+       REGISTER_CLASS_METHOD(polyhedron_interface,makecylinder_tol)
        REGISTER_CLASS_METHOD(polyhedron_interface,extrusion)
        REGISTER_CLASS_METHOD(polyhedron_interface,extrude_rotate)
+       REGISTER_CLASS_METHOD(polyhedron_interface,extrude_loops)
+       REGISTER_CLASS_METHOD(polyhedron_interface,sweep)
+       REGISTER_CLASS_METHOD(polyhedron_interface,convex_hull)
        REGISTER_CLASS_METHOD(polyhedron_interface,surface_of_revolution)
+       REGISTER_CLASS_METHOD(polyhedron_interface,surface_of_revolution_tol)
        REGISTER_CLASS_METHOD(polyhedron_interface,triangulate)
+       REGISTER_CLASS_METHOD(polyhedron_interface,simplify)
+       REGISTER_CLASS_METHOD(polyhedron_interface,offset)
+       REGISTER_CLASS_METHOD(polyhedron_interface,shell)
+       REGISTER_CLASS_METHOD(polyhedron_interface,num_components)
+       REGISTER_CLASS_METHOD(polyhedron_interface,split_components)
+       REGISTER_CLASS_METHOD(polyhedron_interface,voxelize)
+       REGISTER_CLASS_METHOD(polyhedron_interface,hausdorff)
+       REGISTER_CLASS_METHOD(polyhedron_interface,approx_equal)
+       REGISTER_CLASS_METHOD(polyhedron_interface,quality_report)
+       REGISTER_CLASS_METHOD(polyhedron_interface,serialize)
+       REGISTER_CLASS_METHOD(polyhedron_interface,deserialize)
+       REGISTER_CLASS_METHOD(polyhedron_interface,save_binary)
+       REGISTER_CLASS_METHOD(polyhedron_interface,load_binary)
+       REGISTER_CLASS_METHOD(polyhedron_interface,export_bodies)
+       REGISTER_CLASS_METHOD(polyhedron_interface,interference)
+       REGISTER_CLASS_METHOD(polyhedron_interface,boolean_batch)
+       REGISTER_CLASS_METHOD(polyhedron_interface,set_workers)
+       REGISTER_CLASS_METHOD(polyhedron_interface,stats)
+       REGISTER_CLASS_METHOD(polyhedron_interface,reset_stats)
+       REGISTER_CLASS_METHOD(polyhedron_interface,progress_interval)
+       REGISTER_CLASS_METHOD(polyhedron_interface,set_backend)
+       REGISTER_CLASS_METHOD(polyhedron_interface,trace)
+       REGISTER_CLASS_METHOD(polyhedron_interface,trace_dump)
      END_MEX_CLASS_WRAPPER(polyhedron_interface)
+  }
+  catch (csg_error &e)
+  {
+      mexErrMsgIdAndTxt(e.id ().c_str (), "%s", e.what ());
+  }
+  catch (std::exception &e)
+  {
+      // errors raised by the methods themselves pass through, anything
+      // else, e.g. running out of memory, must not escape the mexfunction
+      if (mex_error_raised ())
+      {
+          throw;
+      }
+      
+      mexErrMsgIdAndTxt("CSG:internal", "Operation failed, exception thrown: %s", e.what ());
+  }
+  catch (...)
+  {
+      // e.g. from the CSG kernel
+      if (mex_error_raised ())
+      {
+          throw;
+      }
+      
+      mexErrMsgIdAndTxt("CSG:internal", "Operation failed, unknown exception thrown.");
+  }
 
 
  }
@@ -0,0 +1,15 @@
+/*
+   mpolycsg_worker.cpp
+   
+   The worker process started by the worker pool, see worker_pool.hpp. It
+   runs boolean operations sent by its parent over the socket on its 
+   standard input until the parent closes it.
+
+*/
+
+#include "worker_pool.hpp"
+
+int main ()
+{
+    return mpolycsg::worker_main (0);
+}
@@ -0,0 +1,548 @@
+/*
+   offset.cpp
+   
+   Offsetting the surface of a mesh, and hollowing it into a shell
+
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "offset.hpp"
+#include "triangulate.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// the largest movement of a vertex, as a multiple of the offset distance
+const double MAX_MITRE = 3.0;
+
+// movements along directions in which the faces around a vertex constrain
+// it less than this, relative to the best constrained direction, are
+// ignored, e.g. along the edge between two faces
+const double MIN_CONSTRAINT = 1e-6;
+
+// untangling stops after this many rounds of smoothing
+const int MAX_UNTANGLE_ROUNDS = 100;
+
+// the planes of the faces must end up within this fraction of the offset
+// distance of where they should be, untangling smooths folds away but
+// leaves the faces short of their offset if the folds were too deep
+const double PLANE_TOLERANCE = 0.25;
+
+inline double dot (const double *a, const double *b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// the normal of a face by Newell's method, its length is twice the area
+void face_normal (const double *coords, const int *verts, int n, double *normal)
+{
+    normal[0] = normal[1] = normal[2] = 0.0;
+    
+    for (int i = 0; i < n; i++)
+    {
+        const double *a = &coords[3*verts[i]];
+        const double *b = &coords[3*verts[(i + 1) % n]];
+        
+        normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+        normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+        normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+    }
+}
+
+// eigenvalues w and eigenvectors, the columns of v, of the symmetric 3x3
+// matrix a, by Jacobi rotations, a is destroyed
+void symmetric_eigen (double a[3][3], double w[3], double v[3][3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            v[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+    
+    for (int sweep = 0; sweep < 50; sweep++)
+    {
+        double off = std::fabs (a[0][1]) + std::fabs (a[0][2]) + std::fabs (a[1][2]);
+        double diag = std::fabs (a[0][0]) + std::fabs (a[1][1]) + std::fabs (a[2][2]);
+        
+        if (off <= 1e-15 * diag)
+        {
+            break;
+        }
+        
+        for (int p = 0; p < 2; p++)
+        {
+            for (int q = p + 1; q < 3; q++)
+            {
+                if (a[p][q] == 0.0)
+                {
+                    continue;
+                }
+                
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = ((theta >= 0.0) ? 1.0 : -1.0) / (std::fabs (theta) + std::sqrt (theta*theta + 1.0));
+                double c = 1.0 / std::sqrt (t*t + 1.0);
+                double s = t * c;
+                
+                // a = J' a J, v = v J
+                for (int k = 0; k < 3; k++)
+                {
+                    double akp = a[k][p];
+                    double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                
+                for (int k = 0; k < 3; k++)
+                {
+                    double apk = a[p][k];
+                    double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                
+                for (int k = 0; k < 3; k++)
+                {
+                    double vkp = v[k][p];
+                    double vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    
+    for (int i = 0; i < 3; i++)
+    {
+        w[i] = a[i][i];
+    }
+}
+
+// the movement of each vertex, the least squares solution d of
+// n_f . d = distance for the unit normals n_f of the faces around it,
+// flagging in clamped those limited to MAX_MITRE
+void mitred_displacements (const mesh_data &mesh, double distance, std::vector<double> &disp,
+                           std::vector<char> &clamped)
+{
+    int nverts = mesh.num_vertices ();
+    
+    // the normal equations of each vertex, the upper triangle of the
+    // matrix and the right hand side
+    std::vector<double> normal_eqs (9 * nverts, 0.0);
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        const int *verts = mesh.face (f);
+        int n = mesh.face_size (f);
+        
+        double normal[3];
+        face_normal (&mesh.coords[0], verts, n, normal);
+        
+        double len = std::sqrt (dot (normal, normal));
+        
+        if (len == 0.0)
+        {
+            continue;
+        }
+        
+        for (int d = 0; d < 3; d++)
+        {
+            normal[d] /= len;
+        }
+        
+        for (int k = 0; k < n; k++)
+        {
+            const double *p = mesh.vertex (verts[k]);
+            const double *prev = mesh.vertex (verts[(k + n - 1) % n]);
+            const double *next = mesh.vertex (verts[(k + 1) % n]);
+            
+            double u[3] = { prev[0] - p[0], prev[1] - p[1], prev[2] - p[2] };
+            double v[3] = { next[0] - p[0], next[1] - p[1], next[2] - p[2] };
+            double uv = std::sqrt (dot (u, u) * dot (v, v));
+            
+            if (uv == 0.0)
+            {
+                continue;
+            }
+            
+            // the angle of the face at the vertex
+            double w = std::acos (std::max (-1.0, std::min (1.0, dot (u, v) / uv)));
+            double *eq = &normal_eqs[9*verts[k]];
+            
+            eq[0] += w * normal[0] * normal[0];
+            eq[1] += w * normal[0] * normal[1];
+            eq[2] += w * normal[0] * normal[2];
+            eq[3] += w * normal[1] * normal[1];
+            eq[4] += w * normal[1] * normal[2];
+            eq[5] += w * normal[2] * normal[2];
+            eq[6] += w * normal[0];
+            eq[7] += w * normal[1];
+            eq[8] += w * normal[2];
+        }
+    }
+    
+    disp.assign (3 * nverts, 0.0);
+    clamped.assign (nverts, 0);
+    
+    for (int i = 0; i < nverts; i++)
+    {
+        const double *eq = &normal_eqs[9*i];
+        
+        double a[3][3] = { { eq[0], eq[1], eq[2] },
+                           { eq[1], eq[3], eq[4] },
+                           { eq[2], eq[4], eq[5] } };
+        double b[3] = { distance * eq[6], distance * eq[7], distance * eq[8] };
+        double w[3], v[3][3];
+        
+        symmetric_eigen (a, w, v);
+        
+        double wmax = std::max (w[0], std::max (w[1], w[2]));
+        double *d = &disp[3*i];
+        
+        if (wmax <= 0.0)
+        {
+            continue;
+        }
+        
+        // the pseudo-inverse, ignoring poorly constrained directions
+        for (int e = 0; e < 3; e++)
+        {
+            if (w[e] > MIN_CONSTRAINT * wmax)
+            {
+                double s = (v[0][e] * b[0] + v[1][e] * b[1] + v[2][e] * b[2]) / w[e];
+                
+                d[0] += s * v[0][e];
+                d[1] += s * v[1][e];
+                d[2] += s * v[2][e];
+            }
+        }
+        
+        double len = std::sqrt (dot (d, d));
+        double max_len = MAX_MITRE * std::fabs (distance);
+        
+        if (len > max_len)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                d[k] *= max_len / len;
+            }
+            
+            clamped[i] = 1;
+        }
+    }
+}
+
+// six times the volume enclosed by a surface
+double enclosed_volume (const mesh_data &mesh, const std::vector<double> &coords)
+{
+    double volume = 0.0;
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        const int *verts = mesh.face (f);
+        const double *a = &coords[3*verts[0]];
+        
+        for (int k = 1; k + 1 < mesh.face_size (f); k++)
+        {
+            const double *b = &coords[3*verts[k]];
+            const double *c = &coords[3*verts[k+1]];
+            
+            volume += a[0] * (b[1]*c[2] - b[2]*c[1]) 
+                    - a[1] * (b[0]*c[2] - b[2]*c[0]) 
+                    + a[2] * (b[0]*c[1] - b[1]*c[0]);
+        }
+    }
+    
+    return volume;
+}
+
+// flag the vertices of the faces whose normals have turned over, returning
+// the number of such faces
+int find_folds (const mesh_data &mesh, const std::vector<double> &moved, std::vector<char> &folded)
+{
+    int nfolded = 0;
+    
+    folded.assign (mesh.num_vertices (), 0);
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        const int *verts = mesh.face (f);
+        int n = mesh.face_size (f);
+        
+        double before[3], after[3];
+        face_normal (&mesh.coords[0], verts, n, before);
+        face_normal (&moved[0], verts, n, after);
+        
+        if (dot (before, after) <= 0.0 && dot (before, before) > 0.0)
+        {
+            nfolded++;
+            
+            for (int k = 0; k < n; k++)
+            {
+                folded[verts[k]] = 1;
+            }
+        }
+    }
+    
+    return nfolded;
+}
+
+// the number of faces whose planes have not moved the offset distance,
+// within PLANE_TOLERANCE, measured as the mean movement along their normal
+// of their vertices, leaving out those clamped at sharp corners
+int count_misplaced (const mesh_data &mesh, const std::vector<double> &disp,
+                     const std::vector<char> &clamped, double distance)
+{
+    int nmisplaced = 0;
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        const int *verts = mesh.face (f);
+        int n = mesh.face_size (f);
+        
+        double normal[3];
+        face_normal (&mesh.coords[0], verts, n, normal);
+        
+        double len = std::sqrt (dot (normal, normal));
+        double moved = 0.0;
+        int count = 0;
+        
+        for (int k = 0; k < n; k++)
+        {
+            if (!clamped[verts[k]])
+            {
+                moved += dot (normal, &disp[3*verts[k]]);
+                count++;
+            }
+        }
+        
+        if (len > 0.0 && count > 0
+            && std::fabs (moved / (count * len) - distance) > PLANE_TOLERANCE * std::fabs (distance))
+        {
+            nmisplaced++;
+        }
+    }
+    
+    return nmisplaced;
+}
+
+} // anonymous namespace
+
+int offset_mesh (const mesh_data &mesh, const mesh_adjacency &adjacency, double distance, mesh_data &out)
+{
+    int nverts = mesh.num_vertices ();
+    
+    std::vector<double> disp;
+    std::vector<char> clamped;
+    mitred_displacements (mesh, distance, disp, clamped);
+    
+    std::vector<double> moved (mesh.coords);
+    
+    for (size_t i = 0; i < moved.size (); i++)
+    {
+        moved[i] += disp[i];
+    }
+    
+    // untangle folds by replacing the movement of each vertex of a turned
+    // over face with the mean movement of the vertices of its faces
+    std::vector<char> folded;
+    std::vector<double> sum (3 * nverts);
+    std::vector<int> count (nverts);
+    
+    int nfolded = find_folds (mesh, moved, folded);
+    
+    for (int round = 0; round < MAX_UNTANGLE_ROUNDS && nfolded > 0; round++)
+    {
+        std::fill (sum.begin (), sum.end (), 0.0);
+        std::fill (count.begin (), count.end (), 0);
+        
+        for (int f = 0; f < mesh.num_faces (); f++)
+        {
+            const int *verts = mesh.face (f);
+            int n = mesh.face_size (f);
+            
+            for (int k = 0; k < n; k++)
+            {
+                int v = verts[k];
+                
+                if (!folded[v])
+                {
+                    continue;
+                }
+                
+                for (int j = 0; j < n; j++)
+                {
+                    sum[3*v] += disp[3*verts[j]];
+                    sum[3*v+1] += disp[3*verts[j]+1];
+                    sum[3*v+2] += disp[3*verts[j]+2];
+                }
+                
+                count[v] += n;
+            }
+        }
+        
+        for (int v = 0; v < nverts; v++)
+        {
+            if (folded[v])
+            {
+                for (int d = 0; d < 3; d++)
+                {
+                    disp[3*v+d] = sum[3*v+d] / count[v];
+                    moved[3*v+d] = mesh.coords[3*v+d] + disp[3*v+d];
+                }
+            }
+        }
+        
+        nfolded = find_folds (mesh, moved, folded);
+    }
+    
+    // folds smoothed away may leave faces well short of their offset
+    if (nfolded == 0)
+    {
+        nfolded = count_misplaced (mesh, disp, clamped, distance);
+    }
+    
+    // turned inside out as a whole, which leaves the faces facing the same
+    // way, so is only seen in the enclosed volume
+    if (adjacency.is_closed () && enclosed_volume (mesh, mesh.coords) * enclosed_volume (mesh, moved) <= 0.0)
+    {
+        nfolded = mesh.num_faces ();
+    }
+    
+    // copy the faces, triangulating those which are no longer planar
+    double scale = std::fabs (distance);
+    
+    for (size_t i = 0; i < mesh.coords.size (); i++)
+    {
+        scale = std::max (scale, std::fabs (mesh.coords[i]));
+    }
+    
+    double tol = 1e-10 * scale;
+    
+    out.clear ();
+    out.coords.swap (moved);
+    
+    std::vector<int> tris;
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        const int *verts = mesh.face (f);
+        int n = mesh.face_size (f);
+        
+        bool planar = true;
+        
+        if (n > 3)
+        {
+            double normal[3];
+            face_normal (&out.coords[0], verts, n, normal);
+            
+            double len = std::sqrt (dot (normal, normal));
+            double origin = dot (normal, out.vertex (verts[0]));
+            
+            for (int k = 1; k < n && planar; k++)
+            {
+                planar = std::fabs (dot (normal, out.vertex (verts[k])) - origin) <= tol * len;
+            }
+        }
+        
+        if (planar)
+        {
+            out.add_face (verts, n);
+        }
+        else
+        {
+            // triangulated as the original, planar, face
+            tris.clear ();
+            triangulate_polygon (&mesh.coords[0], verts, n, tris);
+            
+            for (size_t t = 0; t < tris.size (); t += 3)
+            {
+                out.add_face (&tris[t], 3);
+            }
+        }
+    }
+    
+    return nfolded;
+}
+
+int shell_mesh (const mesh_data &mesh, const mesh_adjacency &adjacency, double thickness, mesh_data &out)
+{
+    mesh_data inner;
+    int nfolded = offset_mesh (mesh, adjacency, -thickness, inner);
+    
+    int nverts = mesh.num_vertices ();
+    
+    // the surface which ends up inside faces inwards, which is the offset
+    // unless the walls are outside the surface
+    bool reverse_offset = (thickness >= 0.0);
+    
+    out.clear ();
+    out.coords = mesh.coords;
+    out.coords.insert (out.coords.end (), inner.coords.begin (), inner.coords.end ());
+    
+    std::vector<int> face;
+    
+    for (int f = 0; f < mesh.num_faces (); f++)
+    {
+        face.assign (mesh.face (f), mesh.face (f) + mesh.face_size (f));
+        
+        if (!reverse_offset)
+        {
+            std::reverse (face.begin (), face.end ());
+        }
+        
+        out.add_face (&face[0], (int)face.size ());
+    }
+    
+    for (int f = 0; f < inner.num_faces (); f++)
+    {
+        face.assign (inner.face (f), inner.face (f) + inner.face_size (f));
+        
+        for (size_t k = 0; k < face.size (); k++)
+        {
+            face[k] += nverts;
+        }
+        
+        if (reverse_offset)
+        {
+            std::reverse (face.begin (), face.end ());
+        }
+        
+        out.add_face (&face[0], (int)face.size ());
+    }
+    
+    // join each boundary edge, from a to b in its face, to its offset,
+    // running the other way along both
+    for (int h = 0; h < adjacency.num_half_edges (); h++)
+    {
+        if (adjacency.half_twin[h] >= 0
+            || adjacency.edge_face_start[adjacency.half_edge[h]+1] - adjacency.edge_face_start[adjacency.half_edge[h]] != 1)
+        {
+            continue;
+        }
+        
+        int f = adjacency.half_face[h];
+        int k = h - mesh.face_start[f];
+        int n = mesh.face_size (f);
+        
+        int a = mesh.face (f)[k];
+        int b = mesh.face (f)[(k + 1) % n];
+        
+        int wall[4] = { b, a, a + nverts, b + nverts };
+        
+        if (!reverse_offset)
+        {
+            std::reverse (wall, wall + 4);
+        }
+        
+        out.add_face (wall, 4);
+    }
+    
+    return nfolded;
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,49 @@
+/*
+   offset.hpp
+   
+   Offsetting the surface of a mesh, and hollowing it into a shell
+
+*/
+
+#ifndef __OFFSET_HPP__
+#define __OFFSET_HPP__
+
+#include <vector>
+
+#include "adjacency.hpp"
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// Move the surface of a mesh, with its faces facing outwards, a distance
+// along its normals, outwards if the distance is positive. Each vertex is
+// moved to the least squares fit of the faces around it moved along their
+// normals, weighted by the angles of the faces at the vertex, so flat faces
+// stay flat and edges and corners are mitred, with the movement limited to
+// three times the distance at very sharp corners. Where the distance is
+// larger than the features of the surface, faces turn over, these are
+// untangled by repeatedly smoothing the movement of their vertices. Faces
+// with more than three vertices which no longer lie in a plane are
+// triangulated. The result has the same vertices as the mesh, in the same
+// order. Returns the number of faces which could not be untangled, zero
+// if the result is free of folds. Smoothing can leave the surface free of
+// folds but short of the offset, e.g. a slab offset inwards by more than
+// half its thickness, so if no folds are left the number of faces whose
+// planes have not moved the distance, to within a quarter of it, is
+// returned instead. A closed surface which is turned inside out as a
+// whole, e.g. a sphere offset inwards by more than its radius, counts as
+// every face folded.
+int offset_mesh (const mesh_data &mesh, const mesh_adjacency &adjacency, double distance, mesh_data &out);
+
+// Hollow out the solid bounded by a mesh, leaving walls of the given
+// thickness inside the surface, or outside for a negative thickness. The
+// result contains the surface and its offset, the inner of the two facing
+// inwards, so it is closed if the surface is. The boundary edges of an
+// open surface are joined to their offsets by
+// quadrilaterals, closing the result. Returns the number of faces of the
+// offset which could not be untangled, see offset_mesh.
+int shell_mesh (const mesh_data &mesh, const mesh_adjacency &adjacency, double thickness, mesh_data &out);
+
+} // namespace mpolycsg
+
+#endif // __OFFSET_HPP__
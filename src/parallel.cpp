@@ -0,0 +1,95 @@
+/*
+   parallel.cpp
+   
+   Minimal helpers for splitting work across threads
+
+*/
+
+#include <algorithm>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace mpolycsg {
+
+int default_num_threads ()
+{
+    // looked up once, on Linux each query reads the list of online cpus
+    static const int num_threads = std::max (1, (int)std::thread::hardware_concurrency ());
+    
+    return num_threads;
+}
+
+int num_work_chunks (long nitems, long min_chunk_items, int num_threads)
+{
+    if (num_threads <= 0)
+    {
+        num_threads = default_num_threads ();
+    }
+    
+    long nchunks = nitems / std::max (min_chunk_items, 1L);
+    
+    return (int)std::max (1L, std::min (nchunks, (long)num_threads));
+}
+
+void parallel_for_chunks (int nchunks, const std::function<void (int chunk)> &fcn)
+{
+    if (nchunks <= 1)
+    {
+        if (nchunks == 1)
+        {
+            fcn (0);
+        }
+        return;
+    }
+    
+    std::vector<std::exception_ptr> errors (nchunks);
+    std::vector<std::thread> threads;
+    
+    std::function<void (int)> run = [&fcn, &errors] (int chunk)
+    {
+        try
+        {
+            fcn (chunk);
+        }
+        catch (...)
+        {
+            errors[chunk] = std::current_exception ();
+        }
+    };
+    
+    threads.reserve (nchunks - 1);
+    
+    for (int chunk = 0; chunk < nchunks - 1; chunk++)
+    {
+        try
+        {
+            threads.push_back (std::thread (run, chunk));
+        }
+        catch (std::system_error&)
+        {
+            // out of threads, do the work here instead
+            run (chunk);
+        }
+    }
+    
+    run (nchunks - 1);
+    
+    for (size_t i = 0; i < threads.size (); i++)
+    {
+        threads[i].join ();
+    }
+    
+    for (int chunk = 0; chunk < nchunks; chunk++)
+    {
+        if (errors[chunk])
+        {
+            std::rethrow_exception (errors[chunk]);
+        }
+    }
+}
+
+} // namespace mpolycsg
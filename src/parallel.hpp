@@ -0,0 +1,31 @@
+/*
+   parallel.hpp
+   
+   Minimal helpers for splitting work across threads
+
+*/
+
+#ifndef __PARALLEL_HPP__
+#define __PARALLEL_HPP__
+
+#include <functional>
+
+namespace mpolycsg {
+
+// number of threads to use when none is specified, the number of hardware
+// threads, at least one
+int default_num_threads ();
+
+// number of chunks to split nitems items of work into, using at most 
+// num_threads threads (the default if zero or negative) and at least 
+// min_chunk_items items per chunk
+int num_work_chunks (long nitems, long min_chunk_items, int num_threads);
+
+// call fcn (chunk) for chunk = 0 .. nchunks-1, each on its own thread (the
+// last on the calling thread), and wait for them all. If any call throws,
+// the first exception (by chunk number) is rethrown after all have finished
+void parallel_for_chunks (int nchunks, const std::function<void (int chunk)> &fcn);
+
+} // namespace mpolycsg
+
+#endif // __PARALLEL_HPP__
@@ -0,0 +1,1020 @@
+/*
+   polyhedron_engine.cpp
+   
+   The mpolycsg engine
+
+*/
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "polyhcsg/polyhedron_binary_op.h"
+
+#include "adjacency.hpp"
+#include "backend.hpp"
+#include "components.hpp"
+#include "distance.hpp"
+#include "extrude.hpp"
+#include "hull.hpp"
+#include "mesh_export.hpp"
+#include "offset.hpp"
+#include "polyhedron_engine.hpp"
+#include "progress.hpp"
+#include "serialize.hpp"
+#include "simplify.hpp"
+#include "stats.hpp"
+#include "sweep.hpp"
+#include "tessellation.hpp"
+#include "triangulate.hpp"
+#include "voxelize.hpp"
+#include "worker_pool.hpp"
+
+using namespace polyhcsg;
+
+namespace mpolycsg {
+
+namespace {
+
+// times an engine operation, the faces going out are those of the geometry
+// when the operation completes
+class engine_timer : public scoped_timer
+{
+public:
+    
+    engine_timer (const char *name, const polyhedron_engine &engine, long faces_in) 
+        : scoped_timer (name), engine_m(engine)
+    {
+        set_faces_in (faces_in);
+    }
+    
+    ~engine_timer ()
+    {
+        set_faces_out (engine_m.num_faces ());
+    }
+    
+private:
+    
+    const polyhedron_engine &engine_m;
+    
+};
+
+// run a boolean operation of the kernel on two geometries, interruptible 
+// if a progress token is supplied. The operation holds its own references
+// to the inputs and the output in case it is abandoned
+template <class binary_op>
+std::shared_ptr<polyhedron> run_kernel_op (const char *operation, const geometry_buffer &a, 
+                                           const geometry_buffer &b, progress_token *progress)
+{
+    std::shared_ptr<const polyhedron> pa = a.shared ();
+    std::shared_ptr<const polyhedron> pb = b.shared ();
+    std::shared_ptr<polyhedron> result = std::make_shared<polyhedron> ();
+    
+    run_interruptible (operation, progress, [pa, pb, result] ()
+    {
+        binary_op op;
+        *result = op (*pa, *pb);
+    });
+    
+    return result;
+}
+
+// run a boolean operation in a worker process, interruptible if a progress
+// token is supplied. Only the copies to and from the kernel's geometry run
+// under run_interruptible, the worker is waited for by run_worker_jobs, so
+// a cancelled operation stops the worker rather than leaving it running. A
+// failure of the kernel or of the worker is reported as a csg_error with 
+// errid and message followed by the reason
+std::shared_ptr<polyhedron> run_isolated_op (const char *operation, boolean_op op, const geometry_buffer &a, 
+                                             const geometry_buffer &b, progress_token *progress,
+                                             const char *errid, const char *message)
+{
+    std::shared_ptr<const polyhedron> pa = a.shared ();
+    std::shared_ptr<const polyhedron> pb = b.shared ();
+    std::shared_ptr<mesh_data> ma = std::make_shared<mesh_data> ();
+    std::shared_ptr<mesh_data> mb = std::make_shared<mesh_data> ();
+    
+    run_interruptible (operation, progress, [pa, pb, ma, mb] ()
+    {
+        polyhedron_to_mesh (*pa, *ma);
+        polyhedron_to_mesh (*pb, *mb);
+    });
+    
+    std::vector<worker_job> jobs (1);
+    jobs[0].op = op;
+    jobs[0].a = ma.get ();
+    jobs[0].b = mb.get ();
+    
+    try
+    {
+        run_worker_jobs (jobs, progress, operation);
+    }
+    catch (csg_error&)
+    {
+        // cancelled
+        throw;
+    }
+    catch (std::exception &e)
+    {
+        throw csg_error ("CSG:worker", e.what ());
+    }
+    
+    if (jobs[0].failed)
+    {
+        throw csg_error (errid, std::string (message) + " " + jobs[0].error);
+    }
+    
+    std::shared_ptr<mesh_data> mr = std::make_shared<mesh_data> ();
+    std::shared_ptr<polyhedron> result = std::make_shared<polyhedron> ();
+    *mr = std::move (jobs[0].result);
+    
+    run_interruptible (operation, progress, [mr, result] ()
+    {
+        mesh_to_polyhedron (*mr, *result);
+    });
+    
+    return result;
+}
+
+// a boolean operation replacing geometry, with the kernel used as chosen by
+// backend. Each attempt is timed as kernel.<backend>.<key>, so the stats 
+// show which backend computed each operation. Failures of the kernel are 
+// reported as a csg_error with errid and message
+template <class binary_op>
+void run_boolean (const char *operation, const char *key, boolean_op op, geometry_buffer &geometry, 
+                  const geometry_buffer &other, progress_token *progress, csg_backend backend,
+                  const char *errid, const char *message)
+{
+    if (backend == backend_default)
+    {
+        backend = default_backend ();
+    }
+    
+    long faces_in = geometry.get ().num_faces () + other.get ().num_faces ();
+    
+    if (backend == backend_isolated)
+    {
+        scoped_timer timer (std::string ("kernel.isolated.") + key);
+        timer.set_faces_in (faces_in);
+        
+        geometry.adopt (run_isolated_op (operation, op, geometry, other, progress, errid, message));
+        
+        timer.set_faces_out (geometry.get ().num_faces ());
+        return;
+    }
+    
+    if (backend != backend_robust)
+    {
+        try
+        {
+            scoped_timer timer (std::string ("kernel.fast.") + key);
+            timer.set_faces_in (faces_in);
+            
+            geometry.adopt (run_kernel_op<binary_op> (operation, geometry, other, progress));
+            
+            timer.set_faces_out (geometry.get ().num_faces ());
+            return;
+        }
+        catch (csg_error&)
+        {
+            // cancelled, not a failure of the kernel
+            throw;
+        }
+        catch (...)
+        {
+            if (backend == backend_fast)
+            {
+                throw csg_error (errid, message);
+            }
+        }
+    }
+    
+    try
+    {
+        scoped_timer timer (std::string ("kernel.robust.") + key);
+        timer.set_faces_in (faces_in);
+        
+        geometry_buffer a, b;
+        condition_for_kernel (geometry.get (), other.get (), a.reset (), b.reset ());
+        
+        geometry.adopt (run_kernel_op<binary_op> (operation, a, b, progress));
+        
+        timer.set_faces_out (geometry.get ().num_faces ());
+    }
+    catch (csg_error&)
+    {
+        throw;
+    }
+    catch (...)
+    {
+        throw csg_error (errid, message);
+    }
+}
+
+int tolerance_segments (double radius, double angle, double tol)
+{
+    if (!(tol > 0))
+    {
+        throw csg_error ("CSG:tolerance", "Chordal tolerance must be greater than zero.");
+    }
+    
+    return segments_for_tolerance (radius, angle, tol);
+}
+
+} // anonymous namespace
+
+void polyhedron_engine::share (const polyhedron_engine &other)
+{
+    geometry_m.share (other.geometry_m);
+}
+
+//////////////////////////   construction   //////////////////////////
+
+void polyhedron_engine::make_box (double size_x, double size_y, double size_z, bool is_centered)
+{
+    engine_timer timer ("engine.make_box", *this, 0);
+    
+    geometry_m.reset ().initialize_create_box( size_x, size_y, size_z, is_centered );
+}
+
+void polyhedron_engine::make_sphere (double radius, bool is_centered, int hsegments, int vsegments)
+{
+    engine_timer timer ("engine.make_sphere", *this, 0);
+    
+    geometry_m.reset ().initialize_create_sphere( radius, is_centered, hsegments, vsegments );
+}
+
+void polyhedron_engine::make_cylinder (double radius, double height, bool is_centered, int segments)
+{
+    engine_timer timer ("engine.make_cylinder", *this, 0);
+    
+    geometry_m.reset ().initialize_create_cylinder( radius, height, is_centered, segments );
+}
+
+void polyhedron_engine::make_cone (double radius, double height, bool is_centered, int segments)
+{
+    engine_timer timer ("engine.make_cone", *this, 0);
+    
+    geometry_m.reset ().initialize_create_cone( radius, height, is_centered, segments );
+}
+
+void polyhedron_engine::make_torus (double radius_major, double radius_minor, bool is_centered, int major_segments, int minor_segments)
+{
+    engine_timer timer ("engine.make_torus", *this, 0);
+    
+    geometry_m.reset ().initialize_create_torus( radius_major, radius_minor, is_centered, major_segments, minor_segments );
+}
+
+void polyhedron_engine::make_extrusion (const std::vector<double> &coords, const std::vector<int> &lines, double distance)
+{
+    engine_timer timer ("engine.make_extrusion", *this, 0);
+    
+    geometry_m.reset ().initialize_create_extrusion ( coords, lines, distance );
+}
+
+void polyhedron_engine::make_extrusion (const std::vector<double> &coords, const std::vector<int> &lines, double distance, int segments, double dtheta)
+{
+    engine_timer timer ("engine.make_extrusion", *this, 0);
+    
+    geometry_m.reset ().initialize_create_extrusion ( coords, lines, distance, segments, dtheta );
+}
+
+void polyhedron_engine::make_extrusion_region (const std::vector< std::vector<double> > &loops, double distance)
+{
+    engine_timer timer ("engine.make_extrusion_region", *this, 0);
+    
+    mesh_data mesh;
+    
+    try
+    {
+        extrude_region (loops, distance, mesh);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:extrusion", e.what ());
+    }
+    
+    set_mesh (mesh);
+}
+
+void polyhedron_engine::make_sweep (const std::vector< std::vector<double> > &loops, const std::vector<double> &path, const double *normal)
+{
+    engine_timer timer ("engine.make_sweep", *this, 0);
+    
+    mesh_data mesh;
+    
+    try
+    {
+        sweep_region (loops, path, normal, mesh);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:sweep", e.what ());
+    }
+    
+    set_mesh (mesh);
+}
+
+void polyhedron_engine::make_convex_hull (const std::vector<double> &points, int num_threads)
+{
+    engine_timer timer ("engine.make_convex_hull", *this, 0);
+    
+    mesh_data mesh;
+    
+    try
+    {
+        convex_hull (points, mesh, num_threads);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:convex_hull", e.what ());
+    }
+    
+    set_mesh (mesh);
+}
+
+void polyhedron_engine::make_surface_of_revolution (const std::vector<double> &coords, const std::vector<int> &lines, double angle, int segments)
+{
+    engine_timer timer ("engine.make_surface_of_revolution", *this, 0);
+    
+    geometry_m.reset ().initialize_create_surface_of_revolution ( coords, lines, angle, segments );
+}
+
+void polyhedron_engine::make_sphere_tol (double radius, bool is_centered, double tol)
+{
+    engine_timer timer ("engine.make_sphere_tol", *this, 0);
+    
+    int hsegments = tolerance_segments (radius, 2.0 * M_PI, tol);
+    int vsegments = tolerance_segments (radius, M_PI, tol);
+    
+    make_sphere (radius, is_centered, hsegments, vsegments);
+}
+
+void polyhedron_engine::make_cylinder_tol (double radius, double height, bool is_centered, double tol)
+{
+    engine_timer timer ("engine.make_cylinder_tol", *this, 0);
+    
+    make_cylinder (radius, height, is_centered, tolerance_segments (radius, 2.0 * M_PI, tol));
+}
+
+void polyhedron_engine::make_cone_tol (double radius, double height, bool is_centered, double tol)
+{
+    engine_timer timer ("engine.make_cone_tol", *this, 0);
+    
+    make_cone (radius, height, is_centered, tolerance_segments (radius, 2.0 * M_PI, tol));
+}
+
+void polyhedron_engine::make_torus_tol (double radius_major, double radius_minor, bool is_centered, double tol)
+{
+    engine_timer timer ("engine.make_torus_tol", *this, 0);
+    
+    // the outer equator of the torus sweeps the largest radius
+    int major_segments = tolerance_segments (radius_major + radius_minor, 2.0 * M_PI, tol);
+    int minor_segments = tolerance_segments (radius_minor, 2.0 * M_PI, tol);
+    
+    make_torus (radius_major, radius_minor, is_centered, major_segments, minor_segments);
+}
+
+void polyhedron_engine::make_surface_of_revolution_tol (const std::vector<double> &coords, const std::vector<int> &lines, double angle, double tol)
+{
+    engine_timer timer ("engine.make_surface_of_revolution_tol", *this, 0);
+    
+    // the angle is supplied in degrees
+    int segments = tolerance_segments (profile_radius (coords), angle * M_PI / 180.0, tol);
+    
+    make_surface_of_revolution (coords, lines, angle, segments);
+}
+
+void polyhedron_engine::set_mesh (const mesh_data &mesh)
+{
+    engine_timer timer ("engine.set_mesh", *this, 0);
+    
+    mesh_to_polyhedron (mesh, geometry_m.reset ());
+}
+
+void polyhedron_engine::get_mesh (mesh_data &mesh) const
+{
+    engine_timer timer ("engine.get_mesh", *this, num_faces ());
+    
+    polyhedron_to_mesh (geometry_m.get (), mesh);
+}
+
+//////////////////////////   queries   //////////////////////////
+
+int polyhedron_engine::num_vertices () const
+{
+    return geometry_m.get ().num_vertices ();
+}
+
+int polyhedron_engine::num_faces () const
+{
+    return geometry_m.get ().num_faces ();
+}
+
+int polyhedron_engine::num_face_vertices (int face_id) const
+{
+    return geometry_m.get ().num_face_vertices (face_id);
+}
+
+void polyhedron_engine::get_vertex (int id, double &x, double &y, double &z) const
+{
+    geometry_m.get ().get_vertex( id, x, y, z );
+}
+
+void polyhedron_engine::get_face_vertices (int face_id, std::vector<int> &vertex_ids) const
+{
+    vertex_ids.resize (num_face_vertices (face_id));
+    
+    if (!vertex_ids.empty ())
+    {
+        geometry_m.get ().get_face_vertices( face_id, &vertex_ids[0] );
+    }
+}
+
+std::shared_ptr<const mesh_adjacency> polyhedron_engine::adjacency () const
+{
+    std::shared_ptr<const mesh_adjacency> cached = geometry_m.adjacency ();
+    
+    if (cached)
+    {
+        return cached;
+    }
+    
+    engine_timer timer ("engine.adjacency", *this, num_faces ());
+    
+    mesh_data mesh;
+    get_mesh (mesh);
+    
+    // two threads asking at once may both build it, either result will do
+    std::shared_ptr<mesh_adjacency> built = std::make_shared<mesh_adjacency> ();
+    build_adjacency (mesh, *built);
+    
+    geometry_m.set_adjacency (built);
+    
+    return built;
+}
+
+bool polyhedron_engine::is_manifold () const
+{
+    return adjacency ()->is_manifold ();
+}
+
+//////////////////////////   boolean operations   //////////////////////////
+
+void polyhedron_engine::csg_union (const polyhedron_engine &other, progress_token *progress, csg_backend backend)
+{
+    engine_timer timer ("engine.csg_union", *this, num_faces () + other.num_faces ());
+    
+    run_boolean<polyhedron_union> ("union", "union", boolean_union, geometry_m, other.geometry_m, progress, backend,
+                                   "CSG:union", "Union operation failed, exception thrown.");
+}
+
+void polyhedron_engine::csg_difference (const polyhedron_engine &other, progress_token *progress, csg_backend backend)
+{
+    engine_timer timer ("engine.csg_difference", *this, num_faces () + other.num_faces ());
+    
+    run_boolean<polyhedron_difference> ("difference", "difference", boolean_difference, geometry_m, other.geometry_m, progress, backend,
+                                        "CSG:difference", "Difference operation failed, exception thrown.");
+}
+
+void polyhedron_engine::csg_symmetric_difference (const polyhedron_engine &other, progress_token *progress, csg_backend backend)
+{
+    engine_timer timer ("engine.csg_symmetric_difference", *this, num_faces () + other.num_faces ());
+    
+    run_boolean<polyhedron_symmetric_difference> ("symmetric difference", "symmetric_difference", boolean_symmetric_difference, geometry_m, other.geometry_m, progress, backend,
+                                                  "CSG:symmdifference", "Symmetric difference operation failed, exception thrown.");
+}
+
+//////////////////////////   transformations   //////////////////////////
+
+void polyhedron_engine::translate (double x, double y, double z)
+{
+    engine_timer timer ("engine.translate", *this, num_faces ());
+    
+    geometry_m.assign (geometry_m.get ().translate( x, y, z ));
+}
+
+void polyhedron_engine::rotate (double theta_x, double theta_y, double theta_z)
+{
+    engine_timer timer ("engine.rotate", *this, num_faces ());
+    
+    geometry_m.assign (geometry_m.get ().rotate( theta_x, theta_y, theta_z ));
+}
+
+void polyhedron_engine::scale (double x, double y, double z)
+{
+    engine_timer timer ("engine.scale", *this, num_faces ());
+    
+    geometry_m.assign (geometry_m.get ().scale( x, y, z ));
+}
+
+void polyhedron_engine::mult_matrix_3 (const double *m)
+{
+    engine_timer timer ("engine.mult_matrix_3", *this, num_faces ());
+    
+    geometry_m.assign (geometry_m.get ().mult_matrix_3( m[0], m[1], m[2],
+                                                        m[3], m[4], m[5],
+                                                        m[6], m[7], m[8] ));
+}
+
+void polyhedron_engine::mult_matrix_4 (const double *m)
+{
+    engine_timer timer ("engine.mult_matrix_4", *this, num_faces ());
+    
+    geometry_m.assign (geometry_m.get ().mult_matrix_4( m[0],  m[1],  m[2],  m[3],
+                                                        m[4],  m[5],  m[6],  m[7],
+                                                        m[8],  m[9],  m[10], m[11],
+                                                        m[12], m[13], m[14], m[15] ));
+}
+
+//////////////////////////   processing   //////////////////////////
+
+void polyhedron_engine::triangulate (int num_threads)
+{
+    engine_timer timer ("engine.triangulate", *this, num_faces ());
+    
+    mesh_data mesh;
+    get_mesh (mesh);
+    
+    if (mesh.is_triangulated ())
+    {
+        return;
+    }
+    
+    mesh_data tris;
+    triangulate_mesh (mesh, tris, num_threads);
+    
+    set_mesh (tris);
+}
+
+void polyhedron_engine::simplify (int target_faces, double max_error, progress_token *progress)
+{
+    engine_timer timer ("engine.simplify", *this, num_faces ());
+    
+    try
+    {
+        // the decimation works on triangles only
+        mesh_data polys, mesh;
+        get_mesh (polys);
+        triangulate_mesh (polys, mesh);
+        
+        simplify_mesh (mesh, target_faces, max_error, progress);
+        
+        set_mesh (mesh);
+    }
+    catch (csg_error&)
+    {
+        throw;
+    }
+    catch (...)
+    {
+        throw csg_error ("CSG:simplify", "Simplification failed, exception thrown.");
+    }
+}
+
+void polyhedron_engine::offset (double distance)
+{
+    engine_timer timer ("engine.offset", *this, num_faces ());
+    
+    mesh_data mesh, moved;
+    get_mesh (mesh);
+    
+    if (offset_mesh (mesh, *adjacency (), distance, moved) > 0)
+    {
+        throw csg_error ("CSG:offset", 
+            "The offset distance is too large for the features of the polyhedron, the surface folds over itself.");
+    }
+    
+    set_mesh (moved);
+}
+
+void polyhedron_engine::shell (double thickness)
+{
+    engine_timer timer ("engine.shell", *this, num_faces ());
+    
+    mesh_data mesh, hollow;
+    get_mesh (mesh);
+    
+    if (shell_mesh (mesh, *adjacency (), thickness, hollow) > 0)
+    {
+        throw csg_error ("CSG:shell", 
+            "The shell thickness is too large for the features of the polyhedron, the offset surface folds over itself.");
+    }
+    
+    set_mesh (hollow);
+}
+
+int polyhedron_engine::num_components () const
+{
+    engine_timer timer ("engine.num_components", *this, num_faces ());
+    
+    std::vector<int> component;
+    
+    return face_components (*adjacency (), num_faces (), component);
+}
+
+void polyhedron_engine::split_components (std::vector<polyhedron_engine> &parts) const
+{
+    engine_timer timer ("engine.split_components", *this, num_faces ());
+    
+    mesh_data mesh;
+    get_mesh (mesh);
+    
+    std::vector<mesh_data> meshes;
+    mpolycsg::split_components (mesh, meshes);
+    
+    parts.assign (meshes.size (), polyhedron_engine ());
+    
+    if (meshes.size () == 1)
+    {
+        parts[0].share (*this);
+        return;
+    }
+    
+    for (size_t i = 0; i < meshes.size (); i++)
+    {
+        parts[i].set_mesh (meshes[i]);
+    }
+}
+
+//////////////////////////   voxels   //////////////////////////
+
+namespace {
+
+// the geometry as a triangle mesh
+void get_triangles (const polyhedron_engine &engine, mesh_data &tris)
+{
+    mesh_data mesh;
+    engine.get_mesh (mesh);
+    
+    if (mesh.is_triangulated ())
+    {
+        std::swap (mesh, tris);
+    }
+    else
+    {
+        triangulate_mesh (mesh, tris);
+    }
+}
+
+} // anonymous namespace
+
+void polyhedron_engine::voxelize (const voxel_grid &grid, float *fractions, int num_threads) const
+{
+    engine_timer timer ("engine.voxelize", *this, num_faces ());
+    
+    mesh_data tris;
+    get_triangles (*this, tris);
+    
+    try
+    {
+        mpolycsg::voxelize (tris, grid, fractions, num_threads);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:voxelize", e.what ());
+    }
+}
+
+void polyhedron_engine::voxelize (const voxel_grid &grid, bool *occupied, int num_threads) const
+{
+    engine_timer timer ("engine.voxelize", *this, num_faces ());
+    
+    mesh_data tris;
+    get_triangles (*this, tris);
+    
+    try
+    {
+        mpolycsg::voxelize (tris, grid, occupied, num_threads);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:voxelize", e.what ());
+    }
+}
+
+void polyhedron_engine::voxelize_sparse (const voxel_grid &grid, int block_size, sparse_voxels &voxels, int num_threads) const
+{
+    engine_timer timer ("engine.voxelize_sparse", *this, num_faces ());
+    
+    mesh_data tris;
+    get_triangles (*this, tris);
+    
+    try
+    {
+        mpolycsg::voxelize_sparse (tris, grid, block_size, voxels, num_threads);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:voxelize", e.what ());
+    }
+}
+
+//////////////////////////   comparison   //////////////////////////
+
+deviation_stats polyhedron_engine::hausdorff (const polyhedron_engine &other, long samples, int num_threads) const
+{
+    engine_timer timer ("engine.hausdorff", *this, num_faces () + other.num_faces ());
+    
+    mesh_data a, b;
+    get_triangles (*this, a);
+    get_triangles (other, b);
+    
+    deviation_stats stats;
+    
+    try
+    {
+        hausdorff_distance (a, b, samples, stats, num_threads);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:hausdorff", e.what ());
+    }
+    
+    return stats;
+}
+
+bool polyhedron_engine::approx_equal (const polyhedron_engine &other, double tol, long samples, int num_threads) const
+{
+    engine_timer timer ("engine.approx_equal", *this, num_faces () + other.num_faces ());
+    
+    mesh_data a, b;
+    get_triangles (*this, a);
+    get_triangles (other, b);
+    
+    try
+    {
+        return mpolycsg::approx_equal (a, b, tol, samples, num_threads);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:approx_equal", e.what ());
+    }
+}
+
+//////////////////////////   quality   //////////////////////////
+
+quality_report polyhedron_engine::quality (int nbins, double sliver_angle, int num_threads) const
+{
+    engine_timer timer ("engine.quality", *this, num_faces ());
+    
+    mesh_data mesh, tris;
+    get_mesh (mesh);
+    
+    // the cached adjacency serves when the faces are already triangles,
+    // otherwise that of the triangles is needed for their diagonals
+    std::shared_ptr<const mesh_adjacency> adj;
+    
+    if (mesh.is_triangulated ())
+    {
+        adj = adjacency ();
+        std::swap (mesh, tris);
+    }
+    else
+    {
+        triangulate_mesh (mesh, tris);
+        
+        std::shared_ptr<mesh_adjacency> built = std::make_shared<mesh_adjacency> ();
+        build_adjacency (tris, *built);
+        adj = built;
+    }
+    
+    quality_report report;
+    
+    try
+    {
+        mesh_quality (tris, *adj, nbins, sliver_angle, report, num_threads);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:quality_report", e.what ());
+    }
+    
+    return report;
+}
+
+//////////////////////////   persistence   //////////////////////////
+
+void polyhedron_engine::serialize (std::vector<unsigned char> &blob, bool compress) const
+{
+    engine_timer timer ("engine.serialize", *this, num_faces ());
+    
+    try
+    {
+        mesh_data mesh;
+        get_mesh (mesh);
+        serialize_mesh (mesh, blob, compress);
+    }
+    catch (std::exception &e)
+    {
+        throw csg_error ("CSG:serialize", e.what ());
+    }
+}
+
+void polyhedron_engine::deserialize (const unsigned char *data, size_t size)
+{
+    engine_timer timer ("engine.deserialize", *this, 0);
+    
+    try
+    {
+        mesh_data mesh;
+        deserialize_mesh (data, size, mesh);
+        set_mesh (mesh);
+    }
+    catch (std::exception &e)
+    {
+        throw csg_error ("CSG:deserialize", e.what ());
+    }
+}
+
+void polyhedron_engine::save_binary (const std::string &filename, bool compress) const
+{
+    engine_timer timer ("engine.save_binary", *this, num_faces ());
+    
+    try
+    {
+        mesh_data mesh;
+        get_mesh (mesh);
+        save_mesh_file (mesh, filename, compress);
+    }
+    catch (std::exception &e)
+    {
+        throw csg_error ("CSG:save_binary", e.what ());
+    }
+}
+
+void polyhedron_engine::load_binary (const std::string &filename)
+{
+    engine_timer timer ("engine.load_binary", *this, 0);
+    
+    try
+    {
+        mesh_data mesh;
+        load_mesh_file (filename, mesh);
+        set_mesh (mesh);
+    }
+    catch (std::exception &e)
+    {
+        throw csg_error ("CSG:load_binary", e.what ());
+    }
+}
+
+//////////////////////////   export   //////////////////////////
+
+void export_bodies (const std::string &filename, export_format format,
+                    const std::vector<const polyhedron_engine*> &bodies,
+                    const std::vector<const double*> &transforms,
+                    const std::vector<std::string> &names)
+{
+    scoped_timer timer ("engine.export_bodies");
+    
+    if ((!transforms.empty () && transforms.size () != bodies.size ())
+        || (!names.empty () && names.size () != bodies.size ()))
+    {
+        throw csg_error ("CSG:export_bodies", 
+            "A transform and a name must be given for every body, or none.");
+    }
+    
+    // the totals for the PLY header
+    long total_vertices = 0;
+    long total_faces = 0;
+    
+    for (size_t i = 0; i < bodies.size (); i++)
+    {
+        total_vertices += bodies[i]->num_vertices ();
+        total_faces += bodies[i]->num_faces ();
+    }
+    
+    timer.set_faces_in (total_faces);
+    
+    try
+    {
+        mesh_exporter exporter (filename, format, total_vertices, total_faces);
+        
+        // only one body is copied out of its polyhedron at a time
+        mesh_data mesh;
+        
+        for (size_t i = 0; i < bodies.size (); i++)
+        {
+            bodies[i]->get_mesh (mesh);
+            
+            std::string name = names.empty () ? "body" + std::to_string (i + 1) : names[i];
+            
+            exporter.add_body (mesh, transforms.empty () ? NULL : transforms[i], name);
+        }
+        
+        exporter.finish ();
+    }
+    catch (std::exception &e)
+    {
+        throw csg_error ("CSG:export_bodies", e.what ());
+    }
+    
+    timer.set_faces_out (total_faces);
+}
+
+//////////////////////////   interference   //////////////////////////
+
+void interference (const std::vector<const polyhedron_engine*> &parts,
+                   std::vector<interference_pair> &pairs,
+                   int volume_resolution, int num_threads)
+{
+    scoped_timer timer ("engine.interference");
+    
+    std::vector<mesh_data> meshes (parts.size ());
+    std::vector<const mesh_data*> tris (parts.size ());
+    long faces_in = 0;
+    
+    for (size_t i = 0; i < parts.size (); i++)
+    {
+        get_triangles (*parts[i], meshes[i]);
+        tris[i] = &meshes[i];
+        
+        faces_in += parts[i]->num_faces ();
+    }
+    
+    timer.set_faces_in (faces_in);
+    
+    try
+    {
+        find_interference (tris, pairs, volume_resolution, num_threads);
+    }
+    catch (std::invalid_argument &e)
+    {
+        throw csg_error ("CSG:interference", e.what ());
+    }
+}
+
+//////////////////////////   worker processes   //////////////////////////
+
+void isolated_booleans (boolean_op op, const std::vector<const polyhedron_engine*> &a,
+                        const std::vector<const polyhedron_engine*> &b,
+                        std::vector<polyhedron_engine> &results, csg_backend backend,
+                        progress_token *progress)
+{
+    scoped_timer timer ("engine.isolated_booleans");
+    
+    if (a.size () != b.size ())
+    {
+        throw csg_error ("CSG:boolean_batch", "The same number of first and second operands must be given.");
+    }
+    
+    if (backend == backend_default)
+    {
+        backend = default_backend ();
+    }
+    
+    // the operands are all copied out before any job starts, the workers 
+    // only read them
+    std::vector<mesh_data> meshes (2 * a.size ());
+    std::vector<worker_job> jobs (a.size ());
+    long faces_in = 0;
+    
+    for (size_t i = 0; i < a.size (); i++)
+    {
+        a[i]->get_mesh (meshes[2*i]);
+        b[i]->get_mesh (meshes[2*i+1]);
+        
+        jobs[i].op = op;
+        jobs[i].backend = (backend == backend_isolated) ? backend_auto : backend;
+        jobs[i].a = &meshes[2*i];
+        jobs[i].b = &meshes[2*i+1];
+        
+        faces_in += a[i]->num_faces () + b[i]->num_faces ();
+    }
+    
+    timer.set_faces_in (faces_in);
+    
+    try
+    {
+        run_worker_jobs (jobs, progress, "Boolean batch");
+    }
+    catch (csg_error&)
+    {
+        // cancelled
+        throw;
+    }
+    catch (std::exception &e)
+    {
+        throw csg_error ("CSG:worker", e.what ());
+    }
+    
+    results.resize (jobs.size ());
+    long faces_out = 0;
+    
+    for (size_t i = 0; i < jobs.size (); i++)
+    {
+        if (jobs[i].failed)
+        {
+            throw csg_error ("CSG:boolean_batch", 
+                "Operation " + std::to_string (i + 1) + " failed. " + jobs[i].error);
+        }
+        
+        results[i].set_mesh (jobs[i].result);
+        faces_out += results[i].num_faces ();
+    }
+    
+    timer.set_faces_out (faces_out);
+}
+
+} // namespace mpolycsg
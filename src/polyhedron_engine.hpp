@@ -0,0 +1,184 @@
+/*
+   polyhedron_engine.hpp
+   
+   The mpolycsg engine, a polyhedron with the construction, boolean, 
+   transformation, processing and export operations used by the 
+   Matlab/Octave interface, usable from plain C++ without Matlab or Octave.
+   
+   Errors are reported by throwing mpolycsg::csg_error. Every operation
+   is timed in the stats_registry (see stats.hpp).
+
+*/
+
+#ifndef __POLYHEDRON_ENGINE_HPP__
+#define __POLYHEDRON_ENGINE_HPP__
+
+#include <string>
+#include <vector>
+
+#include "polyhcsg/polyhedron.h"
+
+#include "adjacency.hpp"
+#include "backend.hpp"
+#include "csg_error.hpp"
+#include "distance.hpp"
+#include "geometry_buffer.hpp"
+#include "interference.hpp"
+#include "mesh_data.hpp"
+#include "mesh_export.hpp"
+#include "progress.hpp"
+#include "quality.hpp"
+#include "voxelize.hpp"
+#include "worker_pool.hpp"
+
+namespace mpolycsg {
+
+class polyhedron_engine
+{
+public:
+    
+    polyhedron_engine () {}
+    
+    // copying an engine, or calling share, is O(1), the geometry is shared 
+    // until one of the copies is modified
+    void share (const polyhedron_engine &other);
+    
+    // construction, these replace any existing geometry. Polygons are 
+    // supplied as x, y coordinate pairs and the list of vertex indices 
+    // forming the boundary
+    void make_box (double size_x, double size_y, double size_z, bool is_centered);
+    void make_sphere (double radius, bool is_centered, int hsegments, int vsegments);
+    void make_cylinder (double radius, double height, bool is_centered, int segments);
+    void make_cone (double radius, double height, bool is_centered, int segments);
+    void make_torus (double radius_major, double radius_minor, bool is_centered, int major_segments, int minor_segments);
+    void make_extrusion (const std::vector<double> &coords, const std::vector<int> &lines, double distance);
+    void make_extrusion (const std::vector<double> &coords, const std::vector<int> &lines, double distance, int segments, double dtheta);
+    // a region bounded by any number of loops of x, y coordinate pairs, 
+    // outer boundaries, holes and islands, see extrude_region
+    void make_extrusion_region (const std::vector< std::vector<double> > &loops, double distance);
+    // a profile, bounded by loops as for make_extrusion_region, swept along
+    // a path of x, y, z points, normal is NULL or the initial direction of
+    // the profile x axis, see sweep_region
+    void make_sweep (const std::vector< std::vector<double> > &loops, const std::vector<double> &path, const double *normal);
+    // the convex hull of points given as x, y, z triplets, see convex_hull
+    void make_convex_hull (const std::vector<double> &points, int num_threads=0);
+    // angle is in degrees
+    void make_surface_of_revolution (const std::vector<double> &coords, const std::vector<int> &lines, double angle, int segments);
+    
+    // construction with the number of segments chosen from a maximum 
+    // chordal deviation, see segments_for_tolerance
+    void make_sphere_tol (double radius, bool is_centered, double tol);
+    void make_cylinder_tol (double radius, double height, bool is_centered, double tol);
+    void make_cone_tol (double radius, double height, bool is_centered, double tol);
+    void make_torus_tol (double radius_major, double radius_minor, bool is_centered, double tol);
+    void make_surface_of_revolution_tol (const std::vector<double> &coords, const std::vector<int> &lines, double angle, double tol);
+    
+    // replace the geometry with a mesh, or get the geometry as a mesh
+    void set_mesh (const mesh_data &mesh);
+    void get_mesh (mesh_data &mesh) const;
+    
+    // queries
+    int num_vertices () const;
+    int num_faces () const;
+    int num_face_vertices (int face_id) const;
+    void get_vertex (int id, double &x, double &y, double &z) const;
+    void get_face_vertices (int face_id, std::vector<int> &vertex_ids) const;
+    
+    // the edge and face adjacency, built when first needed and cached with
+    // the geometry until it is modified, copies share the cache
+    std::shared_ptr<const mesh_adjacency> adjacency () const;
+    bool is_manifold () const;
+    
+    // boolean operations, the result replaces the geometry of this engine.
+    // With a progress token they can be cancelled, which throws csg_error
+    // with the id "CSG:cancelled" and leaves the geometry unchanged. The 
+    // backend chooses how the kernel is used, see backend.hpp
+    void csg_union (const polyhedron_engine &other, progress_token *progress=NULL, csg_backend backend=backend_default);
+    void csg_difference (const polyhedron_engine &other, progress_token *progress=NULL, csg_backend backend=backend_default);
+    void csg_symmetric_difference (const polyhedron_engine &other, progress_token *progress=NULL, csg_backend backend=backend_default);
+    
+    // transformations, angles are in degrees, matrices are row major
+    void translate (double x, double y, double z);
+    void rotate (double theta_x, double theta_y, double theta_z);
+    void scale (double x, double y, double z);
+    void mult_matrix_3 (const double *m);
+    void mult_matrix_4 (const double *m);
+    
+    // processing
+    // faces are triangulated in parallel, see triangulate_mesh, num_threads
+    // of zero uses all hardware threads
+    void triangulate (int num_threads=0);
+    void simplify (int target_faces, double max_error=-1.0, progress_token *progress=NULL);
+    // move the surface a distance along its normals, outwards if positive,
+    // or hollow the polyhedron leaving walls of the given thickness inside
+    // the surface, see offset_mesh and shell_mesh
+    void offset (double distance);
+    void shell (double thickness);
+    
+    // connected components, faces are connected through shared edges, see
+    // face_components. split_components fills parts with one engine per 
+    // component, a single component shares the geometry of this one
+    int num_components () const;
+    void split_components (std::vector<polyhedron_engine> &parts) const;
+    
+    // rasterisation onto a grid of voxels, see voxelize. fractions and 
+    // occupied must have room for grid.num_voxels () values
+    void voxelize (const voxel_grid &grid, float *fractions, int num_threads=0) const;
+    void voxelize (const voxel_grid &grid, bool *occupied, int num_threads=0) const;
+    void voxelize_sparse (const voxel_grid &grid, int block_size, sparse_voxels &voxels, int num_threads=0) const;
+    
+    // comparison with another polyhedron, sampling samples points on each
+    // surface, see hausdorff_distance and approx_equal
+    deviation_stats hausdorff (const polyhedron_engine &other, long samples, int num_threads=0) const;
+    bool approx_equal (const polyhedron_engine &other, double tol, long samples, int num_threads=0) const;
+    
+    // the shapes of the triangles of the triangulated surface, the lengths
+    // of its edges and its manifold defects, see mesh_quality
+    quality_report quality (int nbins, double sliver_angle, int num_threads=0) const;
+    
+    // persistence, see serialize.hpp for the format
+    void serialize (std::vector<unsigned char> &blob, bool compress=false) const;
+    void deserialize (const unsigned char *data, size_t size);
+    void save_binary (const std::string &filename, bool compress=false) const;
+    void load_binary (const std::string &filename);
+    
+    // the underlying pyPolyCSG polyhedron
+    const polyhcsg::polyhedron& polyhedron () const { return geometry_m.get (); }
+    
+private:
+    
+    // the wrapped polyhedron, shared with any copies until modified
+    geometry_buffer geometry_m;
+    
+};
+
+// Write several polyhedra to one file, one after another with no boolean
+// operations, see mesh_exporter. transforms is empty or holds a row-major 
+// 4 x 4 matrix for each body, NULL to leave it untransformed, and names is
+// empty or holds a name for each body, otherwise they are named body1, 
+// body2, ...
+void export_bodies (const std::string &filename, export_format format,
+                    const std::vector<const polyhedron_engine*> &bodies,
+                    const std::vector<const double*> &transforms,
+                    const std::vector<std::string> &names);
+
+// The pairs of polyhedra in an assembly which interfere, without boolean
+// operations, see find_interference. The volume of each overlap is
+// estimated if volume_resolution is positive.
+void interference (const std::vector<const polyhedron_engine*> &parts,
+                   std::vector<interference_pair> &pairs,
+                   int volume_resolution=0, int num_threads=0);
+
+// Boolean operations on pairs of polyhedra, results[i] = op (a[i], b[i]),
+// run in parallel in worker processes, see run_worker_jobs, with the kernel
+// used in each as chosen by backend. Throws csg_error for the first 
+// operation which failed, once all have finished. Interruptible if a 
+// progress token is supplied.
+void isolated_booleans (boolean_op op, const std::vector<const polyhedron_engine*> &a,
+                        const std::vector<const polyhedron_engine*> &b,
+                        std::vector<polyhedron_engine> &results, csg_backend backend=backend_default,
+                        progress_token *progress=NULL);
+
+} // namespace mpolycsg
+
+#endif // __POLYHEDRON_ENGINE_HPP__
@@ -0,0 +1,247 @@
+/*
+   progress.cpp
+   
+   Progress reporting and cooperative cancellation of long running 
+   operations
+
+*/
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "csg_error.hpp"
+#include "progress.hpp"
+#include "stats.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+double now ()
+{
+    return stats_registry::instance ().now ();
+}
+
+// state shared between the calling thread and the worker running an 
+// interruptible operation, it outlives both if the worker is abandoned
+struct operation_state
+{
+    operation_state () : done(false) {}
+    
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done;
+    std::exception_ptr error;
+};
+
+// serialises kernel operations, which are not known to be thread safe
+std::mutex& kernel_mutex ()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+// workers of cancelled operations, still running or not yet joined
+class abandoned_operations
+{
+public:
+    
+    static abandoned_operations& instance ()
+    {
+        static abandoned_operations ops;
+        return ops;
+    }
+    
+    void add (std::thread &worker, const std::shared_ptr<operation_state> &state)
+    {
+        std::lock_guard<std::mutex> lock (mutex_m);
+        
+        reap ();
+        
+        workers_m.push_back (entry ());
+        workers_m.back ().worker.swap (worker);
+        workers_m.back ().state = state;
+    }
+    
+    void join_all ()
+    {
+        std::vector<entry> workers;
+        
+        {
+            std::lock_guard<std::mutex> lock (mutex_m);
+            workers.swap (workers_m);
+        }
+        
+        for (size_t i = 0; i < workers.size (); i++)
+        {
+            workers[i].worker.join ();
+        }
+    }
+    
+    ~abandoned_operations ()
+    {
+        // a joinable thread must not be destroyed
+        join_all ();
+    }
+    
+private:
+    
+    struct entry
+    {
+        std::thread worker;
+        std::shared_ptr<operation_state> state;
+    };
+    
+    // join the workers which have finished, must hold mutex_m
+    void reap ()
+    {
+        for (size_t i = 0; i < workers_m.size (); )
+        {
+            bool done;
+            {
+                std::lock_guard<std::mutex> lock (workers_m[i].state->mutex);
+                done = workers_m[i].state->done;
+            }
+            
+            if (done)
+            {
+                workers_m[i].worker.join ();
+                workers_m.erase (workers_m.begin () + i);
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+    
+    std::mutex mutex_m;
+    std::vector<entry> workers_m;
+    
+};
+
+} // anonymous namespace
+
+progress_token::progress_token () 
+    : cancelled_m(false), interval_m(1.0), delay_m(1.0), poll_interval_m(0.05)
+{
+    start ();
+}
+
+void progress_token::set_progress_callback (const progress_callback &callback, double interval, double delay)
+{
+    callback_m = callback;
+    interval_m = interval;
+    delay_m = delay;
+}
+
+void progress_token::start ()
+{
+    cancelled_m = false;
+    start_m = now ();
+    last_report_m = start_m + delay_m - interval_m;
+}
+
+void progress_token::poll (const char *operation, double fraction)
+{
+    if (!cancelled_m && check_m && check_m ())
+    {
+        cancelled_m = true;
+    }
+    
+    if (cancelled_m)
+    {
+        throw csg_error ("CSG:cancelled", std::string (operation) + " cancelled.");
+    }
+    
+    if (callback_m)
+    {
+        double t = now ();
+        
+        if (t - last_report_m >= interval_m)
+        {
+            last_report_m = t;
+            callback_m (operation, fraction, t - start_m);
+        }
+    }
+}
+
+void run_interruptible (const char *operation, progress_token *progress, const std::function<void ()> &op)
+{
+    if (progress == NULL)
+    {
+        std::lock_guard<std::mutex> lock (kernel_mutex ());
+        op ();
+        return;
+    }
+    
+    std::shared_ptr<operation_state> state = std::make_shared<operation_state> ();
+    
+    // the worker owns copies of the state and the operation
+    std::function<void ()> worker_op = op;
+    
+    std::thread worker ([state, worker_op] ()
+    {
+        std::exception_ptr error;
+        
+        try
+        {
+            std::lock_guard<std::mutex> lock (kernel_mutex ());
+            worker_op ();
+        }
+        catch (...)
+        {
+            error = std::current_exception ();
+        }
+        
+        std::lock_guard<std::mutex> lock (state->mutex);
+        state->error = error;
+        state->done = true;
+        state->finished.notify_all ();
+    });
+    
+    std::chrono::duration<double> poll_interval (progress->poll_interval ());
+    
+    try
+    {
+        std::unique_lock<std::mutex> lock (state->mutex);
+        
+        while (!state->done)
+        {
+            state->finished.wait_for (lock, poll_interval);
+            
+            if (!state->done)
+            {
+                // the token may call back into Matlab, so don't hold the 
+                // lock the worker needs to finish
+                lock.unlock ();
+                progress->poll (operation);
+                lock.lock ();
+            }
+        }
+    }
+    catch (...)
+    {
+        abandoned_operations::instance ().add (worker, state);
+        throw;
+    }
+    
+    worker.join ();
+    
+    if (state->error)
+    {
+        std::rethrow_exception (state->error);
+    }
+}
+
+void join_abandoned_operations ()
+{
+    abandoned_operations::instance ().join_all ();
+}
+
+} // namespace mpolycsg
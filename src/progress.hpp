@@ -0,0 +1,99 @@
+/*
+   progress.hpp
+   
+   Progress reporting and cooperative cancellation of long running 
+   operations. 
+   
+   A progress_token is passed to an operation, which polls it periodically
+   from the thread which started it. Polling checks for an interrupt 
+   (e.g. Ctrl-C in Matlab), reports progress through a rate limited 
+   callback and throws csg_error ("CSG:cancelled", ...) when the operation 
+   should stop. Operations which are cancelled leave their geometry 
+   unchanged.
+
+*/
+
+#ifndef __PROGRESS_HPP__
+#define __PROGRESS_HPP__
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+namespace mpolycsg {
+
+class progress_token
+{
+public:
+    
+    // returns true if the operation should be cancelled
+    typedef std::function<bool ()> interrupt_check;
+    
+    // operation name, fraction complete (negative if unknown) and seconds
+    // since the operation started
+    typedef std::function<void (const std::string &operation, double fraction, double elapsed)> progress_callback;
+    
+    progress_token ();
+    
+    void set_interrupt_check (const interrupt_check &check) { check_m = check; }
+    
+    // the callback is first called delay seconds after the operation 
+    // started, then at most once every interval seconds
+    void set_progress_callback (const progress_callback &callback, double interval = 1.0, double delay = 1.0);
+    
+    // seconds between polls while waiting for an operation running on 
+    // another thread
+    double poll_interval () const { return poll_interval_m; }
+    
+    void set_poll_interval (double interval) { poll_interval_m = interval; }
+    
+    // reset the timer and any cancellation for a new operation
+    void start ();
+    
+    // request cancellation, may be called from any thread
+    void cancel () { cancelled_m = true; }
+    
+    bool cancelled () const { return cancelled_m; }
+    
+    // check for cancellation and report progress, fraction is between 0
+    // and 1, or negative if unknown. Throws csg_error if cancelled. Must be
+    // called from the thread which started the operation
+    void poll (const char *operation, double fraction = -1.0);
+    
+private:
+    
+    // tokens are shared by reference, never copied
+    progress_token (const progress_token&);
+    progress_token& operator= (const progress_token&);
+    
+    std::atomic<bool> cancelled_m;
+    interrupt_check check_m;
+    progress_callback callback_m;
+    double interval_m;
+    double delay_m;
+    double poll_interval_m;
+    double start_m;
+    double last_report_m;
+    
+};
+
+// Run an operation which cannot itself be interrupted (e.g. a boolean
+// operation in the CSG kernel). With no token the operation runs on the
+// calling thread. Otherwise it runs on a worker thread while the calling 
+// thread polls the token. If the token is cancelled the worker is 
+// abandoned: it runs to completion in the background and anything it 
+// produces is discarded, so the operation must only capture data it owns
+// (e.g. shared pointers to its inputs and output). Exceptions thrown by 
+// the operation are rethrown on the calling thread.
+//
+// Kernel operations are run one at a time, so an operation started while
+// an abandoned one is still running waits for it to finish.
+void run_interruptible (const char *operation, progress_token *progress, const std::function<void ()> &op);
+
+// wait for any abandoned operations to finish, this also happens 
+// automatically when the library is unloaded
+void join_abandoned_operations ();
+
+} // namespace mpolycsg
+
+#endif // __PROGRESS_HPP__
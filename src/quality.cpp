@@ -0,0 +1,260 @@
+/*
+   quality.cpp
+   
+   Quality measures of a triangulated surface, the shapes of its triangles,
+   the lengths of its edges and its manifold defects, as needed to judge
+   whether it is fit to be meshed into tetrahedra
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "parallel.hpp"
+#include "quality.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// below this many triangles or edges per thread, threads cost more than
+// they save
+const long MIN_CHUNK_ITEMS = 4096;
+
+const double RAD_TO_DEG = 180.0 / 3.14159265358979323846;
+
+inline double dot (const double *a, const double *b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// the totals over the triangles of one chunk
+class triangle_totals
+{
+public:
+    
+    triangle_totals ()
+        : min_angle(std::numeric_limits<double>::infinity ()), max_angle(0.0),
+          max_aspect(0.0), sum_aspect(0.0), num_degenerate(0), num_slivers(0) {}
+    
+    double min_angle;
+    double max_angle;
+    double max_aspect;
+    double sum_aspect;
+    long num_degenerate;
+    long num_slivers;
+    
+};
+
+// the angles and aspect ratios of triangles first to last - 1
+void measure_triangles (const mesh_data &tris, long first, long last, double sliver_angle,
+                        triangle_totals &totals)
+{
+    const double *coords = tris.coords.data ();
+    const int *verts = tris.face_verts.data ();
+    
+    for (long t = first; t < last; t++)
+    {
+        const double *p = coords + 3 * verts[3*t];
+        const double *q = coords + 3 * verts[3*t+1];
+        const double *r = coords + 3 * verts[3*t+2];
+        
+        double pq[3] = { q[0] - p[0], q[1] - p[1], q[2] - p[2] };
+        double pr[3] = { r[0] - p[0], r[1] - p[1], r[2] - p[2] };
+        double qr[3] = { r[0] - q[0], r[1] - q[1], r[2] - q[2] };
+        
+        double n[3] = { pq[1] * pr[2] - pq[2] * pr[1],
+                        pq[2] * pr[0] - pq[0] * pr[2],
+                        pq[0] * pr[1] - pq[1] * pr[0] };
+        
+        // twice the area, and the squared edge lengths
+        double area2 = std::sqrt (dot (n, n));
+        double lpq2 = dot (pq, pq);
+        double lpr2 = dot (pr, pr);
+        double lqr2 = dot (qr, qr);
+        
+        // a triangle whose area is lost in the rounding of its edges is
+        // degenerate, it has no meaningful angles
+        if (area2 <= std::numeric_limits<double>::epsilon () * (lpq2 + lpr2 + lqr2))
+        {
+            totals.min_angle = 0.0;
+            totals.max_angle = 180.0;
+            totals.max_aspect = std::numeric_limits<double>::infinity ();
+            totals.num_degenerate++;
+            totals.num_slivers++;
+            continue;
+        }
+        
+        // the angles at p and q from their sines and cosines, which stays
+        // accurate for angles near 0 and 180 degrees where acos does not
+        double angle_p = std::atan2 (area2, dot (pq, pr)) * RAD_TO_DEG;
+        double angle_q = std::atan2 (area2, -dot (pq, qr)) * RAD_TO_DEG;
+        double angle_r = 180.0 - angle_p - angle_q;
+        
+        double smallest = std::min (angle_p, std::min (angle_q, angle_r));
+        double largest = std::max (angle_p, std::max (angle_q, angle_r));
+        
+        // circumradius R = abc / 4A and inradius r = A / s, so R / 2r is
+        // abc s / 8 A^2, with area2 = 2A
+        double lpq = std::sqrt (lpq2), lpr = std::sqrt (lpr2), lqr = std::sqrt (lqr2);
+        double s = 0.5 * (lpq + lpr + lqr);
+        double aspect = lpq * lpr * lqr * s / (2.0 * area2 * area2);
+        
+        totals.min_angle = std::min (totals.min_angle, smallest);
+        totals.max_angle = std::max (totals.max_angle, largest);
+        totals.max_aspect = std::max (totals.max_aspect, aspect);
+        totals.sum_aspect += aspect;
+        
+        if (smallest < sliver_angle)
+        {
+            totals.num_slivers++;
+        }
+    }
+}
+
+} // anonymous namespace
+
+void mesh_quality (const mesh_data &tris, const mesh_adjacency &adjacency, int nbins,
+                   double sliver_angle, quality_report &report, int num_threads)
+{
+    if (!tris.is_triangulated ())
+    {
+        throw std::invalid_argument ("The mesh must be triangulated to measure its quality.");
+    }
+    
+    if (nbins < 1)
+    {
+        throw std::invalid_argument ("The edge length histogram must have at least one bin.");
+    }
+    
+    report = quality_report ();
+    
+    report.sliver_angle = sliver_angle;
+    report.num_boundary_edges = adjacency.num_boundary_edges;
+    report.num_nonmanifold_edges = adjacency.num_nonmanifold_edges;
+    report.num_nonmanifold_vertices = adjacency.num_nonmanifold_vertices;
+    
+    // the triangles
+    long ntris = tris.num_faces ();
+    
+    int nchunks = num_work_chunks (ntris, MIN_CHUNK_ITEMS, num_threads);
+    
+    std::vector<triangle_totals> tri_totals (nchunks);
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        measure_triangles (tris, ntris * c / nchunks, ntris * (c + 1) / nchunks,
+                           sliver_angle, tri_totals[c]);
+    });
+    
+    triangle_totals totals;
+    
+    for (int c = 0; c < nchunks; c++)
+    {
+        totals.min_angle = std::min (totals.min_angle, tri_totals[c].min_angle);
+        totals.max_angle = std::max (totals.max_angle, tri_totals[c].max_angle);
+        totals.max_aspect = std::max (totals.max_aspect, tri_totals[c].max_aspect);
+        totals.sum_aspect += tri_totals[c].sum_aspect;
+        totals.num_degenerate += tri_totals[c].num_degenerate;
+        totals.num_slivers += tri_totals[c].num_slivers;
+    }
+    
+    report.num_triangles = ntris;
+    report.num_degenerate = totals.num_degenerate;
+    report.num_slivers = totals.num_slivers;
+    
+    if (ntris > 0)
+    {
+        report.min_angle = totals.min_angle;
+        report.max_angle = totals.max_angle;
+        report.max_aspect_ratio = totals.max_aspect;
+    }
+    
+    if (ntris > totals.num_degenerate)
+    {
+        report.mean_aspect_ratio = totals.sum_aspect / (ntris - totals.num_degenerate);
+    }
+    
+    // the edges, first their lengths and range, then the histogram once
+    // the range of the bins is known
+    long nedges = adjacency.num_edges ();
+    
+    report.num_edges = nedges;
+    report.edge_counts.assign (nbins, 0);
+    
+    std::vector<double> lengths (nedges);
+    
+    nchunks = num_work_chunks (nedges, MIN_CHUNK_ITEMS, num_threads);
+    
+    std::vector<double> chunk_min (nchunks, std::numeric_limits<double>::infinity ());
+    std::vector<double> chunk_max (nchunks, 0.0);
+    std::vector<double> chunk_sum (nchunks, 0.0);
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        for (long e = nedges * c / nchunks; e < nedges * (c + 1) / nchunks; e++)
+        {
+            const double *a = &tris.coords[3 * adjacency.edge_verts[2*e]];
+            const double *b = &tris.coords[3 * adjacency.edge_verts[2*e+1]];
+            double d[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            
+            lengths[e] = std::sqrt (dot (d, d));
+            
+            chunk_min[c] = std::min (chunk_min[c], lengths[e]);
+            chunk_max[c] = std::max (chunk_max[c], lengths[e]);
+            chunk_sum[c] += lengths[e];
+        }
+    });
+    
+    if (nedges > 0)
+    {
+        report.min_edge = *std::min_element (chunk_min.begin (), chunk_min.end ());
+        report.max_edge = *std::max_element (chunk_max.begin (), chunk_max.end ());
+        
+        double sum = 0.0;
+        
+        for (int c = 0; c < nchunks; c++)
+        {
+            sum += chunk_sum[c];
+        }
+        
+        report.mean_edge = sum / nedges;
+    }
+    
+    report.edge_bins.resize (nbins + 1);
+    
+    for (int i = 0; i <= nbins; i++)
+    {
+        report.edge_bins[i] = report.min_edge + (report.max_edge - report.min_edge) * i / nbins;
+    }
+    
+    // edges all the same length fall in the first bin
+    double range = report.max_edge - report.min_edge;
+    double scale = (range > 0.0) ? nbins / range : 0.0;
+    
+    std::vector< std::vector<long> > chunk_counts (nchunks, std::vector<long> (nbins, 0));
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        std::vector<long> &counts = chunk_counts[c];
+        
+        for (long e = nedges * c / nchunks; e < nedges * (c + 1) / nchunks; e++)
+        {
+            int bin = (int)((lengths[e] - report.min_edge) * scale);
+            
+            counts[std::min (bin, nbins - 1)]++;
+        }
+    });
+    
+    for (int c = 0; c < nchunks; c++)
+    {
+        for (int i = 0; i < nbins; i++)
+        {
+            report.edge_counts[i] += chunk_counts[c][i];
+        }
+    }
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,76 @@
+/*
+   quality.hpp
+   
+   Quality measures of a triangulated surface, the shapes of its triangles,
+   the lengths of its edges and its manifold defects, as needed to judge
+   whether it is fit to be meshed into tetrahedra
+
+*/
+
+#ifndef __QUALITY_HPP__
+#define __QUALITY_HPP__
+
+#include <vector>
+
+#include "adjacency.hpp"
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// The quality of a triangle mesh. Angles are in degrees. The aspect ratio
+// of a triangle is its circumradius over twice its inradius, one for an
+// equilateral triangle and growing without limit as the triangle
+// flattens. Degenerate triangles, of zero area, have an aspect ratio of
+// infinity and are left out of the mean.
+class quality_report
+{
+public:
+    
+    quality_report ()
+        : num_triangles(0), num_degenerate(0), min_angle(0.0), max_angle(0.0),
+          max_aspect_ratio(0.0), mean_aspect_ratio(0.0), sliver_angle(0.0), num_slivers(0),
+          num_edges(0), min_edge(0.0), max_edge(0.0), mean_edge(0.0),
+          num_boundary_edges(0), num_nonmanifold_edges(0), num_nonmanifold_vertices(0) {}
+    
+    long num_triangles;
+    long num_degenerate;
+    
+    double min_angle;
+    double max_angle;
+    double max_aspect_ratio;
+    double mean_aspect_ratio;
+    
+    // triangles with a smallest angle below sliver_angle, including the
+    // degenerate ones
+    double sliver_angle;
+    long num_slivers;
+    
+    // the lengths of the edges, each counted once however many triangles
+    // share it. The histogram has equal bins from the shortest to the
+    // longest edge, edge_bins holds the bin limits, one more than there
+    // are bins in edge_counts.
+    long num_edges;
+    double min_edge;
+    double max_edge;
+    double mean_edge;
+    std::vector<double> edge_bins;
+    std::vector<long> edge_counts;
+    
+    // see mesh_adjacency
+    long num_boundary_edges;
+    long num_nonmanifold_edges;
+    long num_nonmanifold_vertices;
+    
+};
+
+// Measure a triangle mesh, given its adjacency, with nbins bins in the edge
+// length histogram. The triangles and then the edges are split between up
+// to num_threads threads, zero for the default, each keeping its own
+// totals which are combined at the end. Throws std::invalid_argument if
+// the mesh is not triangulated or nbins is less than one.
+void mesh_quality (const mesh_data &tris, const mesh_adjacency &adjacency, int nbins,
+                   double sliver_angle, quality_report &report, int num_threads=0);
+
+} // namespace mpolycsg
+
+#endif // __QUALITY_HPP__
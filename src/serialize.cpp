@@ -0,0 +1,422 @@
+/*
+   serialize.cpp
+   
+   Compact binary encoding of polyhedron geometry for saving and loading
+
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef MPOLYCSG_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "serialize.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+const unsigned char SERIAL_MAGIC[4] = { 'M', 'P', 'C', 'S' };
+
+const unsigned char SERIAL_FLAG_ZSTD = 1;
+
+void put_uint (std::vector<unsigned char> &out, uint64_t value, int nbytes)
+{
+    for (int i = 0; i < nbytes; i++)
+    {
+        out.push_back ((unsigned char)(value >> (8*i)));
+    }
+}
+
+uint64_t get_uint (const unsigned char *in, int nbytes)
+{
+    uint64_t value = 0;
+    
+    for (int i = 0; i < nbytes; i++)
+    {
+        value |= ((uint64_t)in[i]) << (8*i);
+    }
+    
+    return value;
+}
+
+void put_double (std::vector<unsigned char> &out, double value)
+{
+    uint64_t bits;
+    std::memcpy (&bits, &value, sizeof (bits));
+    put_uint (out, bits, 8);
+}
+
+double get_double (const unsigned char *in)
+{
+    uint64_t bits = get_uint (in, 8);
+    double value;
+    std::memcpy (&value, &bits, sizeof (value));
+    return value;
+}
+
+void put_varint (std::vector<unsigned char> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back ((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back ((unsigned char)value);
+}
+
+// reads a varint, advancing pos, throws if the end of the buffer is reached
+uint64_t get_varint (const unsigned char *in, size_t size, size_t &pos)
+{
+    uint64_t value = 0;
+    
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (pos >= size)
+        {
+            throw serialize_error ("Truncated polyhedron data.");
+        }
+        
+        unsigned char byte = in[pos++];
+        value |= ((uint64_t)(byte & 0x7F)) << shift;
+        
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+    
+    throw serialize_error ("Invalid polyhedron data, malformed integer.");
+}
+
+uint64_t zigzag (int64_t value)
+{
+    return (((uint64_t)value) << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t unzigzag (uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+void encode_payload (const mesh_data &mesh, std::vector<unsigned char> &out)
+{
+    out.reserve (out.size () + 8 * mesh.coords.size () + 2 * mesh.face_verts.size ());
+    
+    for (size_t i = 0; i < mesh.coords.size (); i++)
+    {
+        put_double (out, mesh.coords[i]);
+    }
+    
+    for (int i = 0; i < mesh.num_faces (); i++)
+    {
+        put_varint (out, mesh.face_size (i));
+    }
+    
+    // neighbouring indices in a face are usually close together, so the 
+    // differences are small and encode in one or two bytes
+    int64_t previous = 0;
+    
+    for (size_t i = 0; i < mesh.face_verts.size (); i++)
+    {
+        put_varint (out, zigzag ((int64_t)mesh.face_verts[i] - previous));
+        previous = mesh.face_verts[i];
+    }
+}
+
+void decode_payload (const unsigned char *in, size_t size, uint64_t nverts, uint64_t nfaces, mesh_data &mesh)
+{
+    mesh.clear ();
+    
+    if (nverts > size / 24 || nfaces > size || nverts > (uint64_t)INT_MAX || nfaces > (uint64_t)INT_MAX)
+    {
+        throw serialize_error ("Invalid polyhedron data, sizes do not match contents.");
+    }
+    
+    mesh.coords.resize (3 * nverts);
+    
+    size_t pos = 0;
+    
+    for (size_t i = 0; i < mesh.coords.size (); i++, pos += 8)
+    {
+        mesh.coords[i] = get_double (in + pos);
+    }
+    
+    mesh.face_start.resize (nfaces + 1);
+    
+    // each vertex index takes at least one byte, so the total must fit in
+    // what remains after the face sizes, and in an int
+    uint64_t total = 0;
+    
+    for (uint64_t i = 0; i < nfaces; i++)
+    {
+        uint64_t n = get_varint (in, size, pos);
+        
+        if (n > size || total + n > size - pos || total + n > (uint64_t)INT_MAX)
+        {
+            throw serialize_error ("Invalid polyhedron data, bad face size.");
+        }
+        
+        total += n;
+        mesh.face_start[i+1] = (int)total;
+    }
+    
+    mesh.face_verts.resize (mesh.face_start[nfaces]);
+    
+    int64_t previous = 0;
+    
+    for (size_t i = 0; i < mesh.face_verts.size (); i++)
+    {
+        previous += unzigzag (get_varint (in, size, pos));
+        
+        if (previous < 0 || (uint64_t)previous >= nverts)
+        {
+            throw serialize_error ("Invalid polyhedron data, vertex index out of range.");
+        }
+        
+        mesh.face_verts[i] = (int)previous;
+    }
+    
+    if (pos != size)
+    {
+        throw serialize_error ("Invalid polyhedron data, trailing bytes.");
+    }
+}
+
+#ifdef MPOLYCSG_WITH_ZSTD
+
+// a zstd frame is made of blocks of at most 128 KiB, each taking at least
+// three bytes, so it cannot expand by more than this
+const uint64_t ZSTD_MAX_EXPANSION = (128 * 1024) / 3;
+
+// the largest payload which can hold nverts vertices and nfaces faces: the
+// coordinates, a face size of at most five bytes for each face, and at most
+// five bytes for each vertex of each face
+uint64_t max_payload_size (uint64_t nverts, uint64_t nfaces)
+{
+    if (nverts > (uint64_t)INT_MAX || nfaces > (uint64_t)INT_MAX)
+    {
+        return 0;
+    }
+    
+    uint64_t nrefs = std::min (nverts * nfaces, (uint64_t)INT_MAX);
+    
+    return 24 * nverts + 5 * nfaces + 5 * nrefs;
+}
+
+#endif
+
+} // anonymous namespace
+
+bool serialize_compression_available ()
+{
+#ifdef MPOLYCSG_WITH_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+void serialize_mesh (const mesh_data &mesh, std::vector<unsigned char> &blob, bool compress)
+{
+    std::vector<unsigned char> payload;
+    
+    encode_payload (mesh, payload);
+    
+    unsigned char flags = 0;
+
+#ifdef MPOLYCSG_WITH_ZSTD
+    std::vector<unsigned char> compressed;
+    
+    if (compress)
+    {
+        compressed.resize (ZSTD_compressBound (payload.size ()));
+        
+        size_t csize = ZSTD_compress (&compressed[0], compressed.size (), 
+                                      payload.empty () ? NULL : &payload[0], 
+                                      payload.size (), 3);
+        
+        if (ZSTD_isError (csize))
+        {
+            throw serialize_error (ZSTD_getErrorName (csize));
+        }
+        
+        compressed.resize (csize);
+        flags |= SERIAL_FLAG_ZSTD;
+    }
+    
+    const std::vector<unsigned char> &stored = compress ? compressed : payload;
+#else
+    const std::vector<unsigned char> &stored = payload;
+#endif
+    
+    blob.clear ();
+    blob.reserve (SERIAL_HEADER_SIZE + stored.size ());
+    
+    blob.insert (blob.end (), SERIAL_MAGIC, SERIAL_MAGIC + 4);
+    put_uint (blob, SERIAL_FORMAT_VERSION, 2);
+    put_uint (blob, flags, 1);
+    put_uint (blob, 0, 1);
+    put_uint (blob, mesh.num_vertices (), 8);
+    put_uint (blob, mesh.num_faces (), 8);
+    put_uint (blob, payload.size (), 8);
+    put_uint (blob, stored.size (), 8);
+    
+    blob.insert (blob.end (), stored.begin (), stored.end ());
+}
+
+void deserialize_mesh (const unsigned char *data, size_t size, mesh_data &mesh)
+{
+    if (size < SERIAL_HEADER_SIZE || std::memcmp (data, SERIAL_MAGIC, 4) != 0)
+    {
+        throw serialize_error ("Data is not a serialized polyhedron.");
+    }
+    
+    uint64_t version = get_uint (data + 4, 2);
+    
+    if (version > SERIAL_FORMAT_VERSION)
+    {
+        throw serialize_error ("Serialized polyhedron is from a newer format version.");
+    }
+    
+    unsigned char flags = data[6];
+    uint64_t nverts = get_uint (data + 8, 8);
+    uint64_t nfaces = get_uint (data + 16, 8);
+    uint64_t payload_size = get_uint (data + 24, 8);
+    uint64_t stored_size = get_uint (data + 32, 8);
+    
+    if (stored_size != size - SERIAL_HEADER_SIZE)
+    {
+        throw serialize_error ("Serialized polyhedron is truncated.");
+    }
+    
+    const unsigned char *stored = data + SERIAL_HEADER_SIZE;
+    
+    if (flags & SERIAL_FLAG_ZSTD)
+    {
+#ifdef MPOLYCSG_WITH_ZSTD
+        // the header is not trusted with the size of the buffer, it must
+        // agree with the frame and be possible for the mesh and the frame
+        if (payload_size > max_payload_size (nverts, nfaces)
+            || ZSTD_getFrameContentSize (stored, stored_size) != payload_size
+            || payload_size / ZSTD_MAX_EXPANSION > stored_size)
+        {
+            throw serialize_error ("Invalid polyhedron data, sizes do not match contents.");
+        }
+        
+        std::vector<unsigned char> payload (payload_size);
+        
+        size_t dsize = ZSTD_decompress (payload.empty () ? NULL : &payload[0], payload.size (), 
+                                        stored, stored_size);
+        
+        if (ZSTD_isError (dsize) || dsize != payload_size)
+        {
+            throw serialize_error ("Serialized polyhedron could not be decompressed.");
+        }
+        
+        decode_payload (payload.empty () ? NULL : &payload[0], payload.size (), nverts, nfaces, mesh);
+#else
+        throw serialize_error ("Serialized polyhedron is compressed, but compression support was not compiled in.");
+#endif
+    }
+    else
+    {
+        if (payload_size != stored_size)
+        {
+            throw serialize_error ("Invalid polyhedron data, sizes do not match contents.");
+        }
+        
+        decode_payload (stored, stored_size, nverts, nfaces, mesh);
+    }
+}
+
+void save_mesh_file (const mesh_data &mesh, const std::string &filename, bool compress)
+{
+    std::vector<unsigned char> blob;
+    
+    serialize_mesh (mesh, blob, compress);
+    
+    FILE *fid = std::fopen (filename.c_str (), "wb");
+    
+    if (fid == NULL)
+    {
+        throw serialize_error ("Could not open " + filename + " for writing.");
+    }
+    
+    size_t nwritten = std::fwrite (&blob[0], 1, blob.size (), fid);
+    
+    if (std::fclose (fid) != 0 || nwritten != blob.size ())
+    {
+        throw serialize_error ("Error writing to " + filename + ".");
+    }
+}
+
+void load_mesh_file (const std::string &filename, mesh_data &mesh)
+{
+#ifdef _WIN32
+    std::ifstream file (filename.c_str (), std::ios::binary);
+    
+    if (!file)
+    {
+        throw serialize_error ("Could not open " + filename + " for reading.");
+    }
+    
+    std::vector<unsigned char> blob ((std::istreambuf_iterator<char> (file)), 
+                                     std::istreambuf_iterator<char> ());
+    
+    deserialize_mesh (blob.empty () ? NULL : &blob[0], blob.size (), mesh);
+#else
+    int fd = open (filename.c_str (), O_RDONLY);
+    
+    if (fd < 0)
+    {
+        throw serialize_error ("Could not open " + filename + " for reading.");
+    }
+    
+    struct stat st;
+    
+    if (fstat (fd, &st) != 0 || st.st_size < (off_t)SERIAL_HEADER_SIZE)
+    {
+        close (fd);
+        throw serialize_error (filename + " is not a serialized polyhedron.");
+    }
+    
+    void *map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    
+    close (fd);
+    
+    if (map == MAP_FAILED)
+    {
+        throw serialize_error ("Could not map " + filename + " into memory.");
+    }
+    
+    try
+    {
+        deserialize_mesh ((const unsigned char *)map, st.st_size, mesh);
+    }
+    catch (...)
+    {
+        munmap (map, st.st_size);
+        throw;
+    }
+    
+    munmap (map, st.st_size);
+#endif
+}
+
+} // namespace mpolycsg
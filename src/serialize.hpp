@@ -0,0 +1,68 @@
+/*
+   serialize.hpp
+   
+   Compact binary encoding of polyhedron geometry for saving and loading
+
+   The layout is versioned and little-endian regardless of the host. All 
+   integers in the header are unsigned:
+   
+     offset  size  contents
+          0     4  magic "MPCS"
+          4     2  format version
+          6     1  flags, bit 0 set if the payload is zstd compressed
+          7     1  reserved, zero
+          8     8  number of vertices
+         16     8  number of faces
+         24     8  size of the payload before compression
+         32     8  size of the payload as stored after the header
+   
+   The (uncompressed) payload contains the vertex coordinates as x, y, z
+   IEEE 754 doubles, followed by the number of vertices in each face as 
+   LEB128 varints, followed by the vertex indices of all faces, each stored
+   as the zigzag encoded varint of the difference from the preceding index.
+
+*/
+
+#ifndef __SERIALIZE_HPP__
+#define __SERIALIZE_HPP__
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+const unsigned int SERIAL_FORMAT_VERSION = 1;
+
+const size_t SERIAL_HEADER_SIZE = 40;
+
+class serialize_error : public std::runtime_error
+{
+public:
+    serialize_error (const std::string &msg) : std::runtime_error (msg) {}
+};
+
+// true if the library was built with compression support 
+// (MPOLYCSG_WITH_ZSTD defined and libzstd linked)
+bool serialize_compression_available ();
+
+// encode a mesh, if compress is true and compression is not available the 
+// mesh is stored uncompressed
+void serialize_mesh (const mesh_data &mesh, std::vector<unsigned char> &blob, bool compress=false);
+
+// decode a mesh from a buffer, throws serialize_error if the buffer is not
+// a valid encoding
+void deserialize_mesh (const unsigned char *data, size_t size, mesh_data &mesh);
+
+// encode a mesh and write it to a file
+void save_mesh_file (const mesh_data &mesh, const std::string &filename, bool compress=false);
+
+// decode a mesh from a file, the file is memory mapped where the platform
+// supports it so it is decoded without an intermediate copy
+void load_mesh_file (const std::string &filename, mesh_data &mesh);
+
+} // namespace mpolycsg
+
+#endif // __SERIALIZE_HPP__
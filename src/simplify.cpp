@@ -0,0 +1,541 @@
+/*
+   simplify.cpp
+   
+   Mesh decimation by edge collapse using quadric error metrics
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "simplify.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// collapses between polls of the progress token
+const unsigned int PROGRESS_POLL_ITERATIONS = 1024;
+
+// symmetric 4x4 matrix, stored as the upper triangle
+struct quadric
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+    
+    quadric () : a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0) {}
+    
+    // the fundamental error quadric of the plane ax + by + cz + d = 0
+    void add_plane (double a, double b, double c, double d)
+    {
+        a2 += a*a; ab += a*b; ac += a*c; ad += a*d;
+        b2 += b*b; bc += b*c; bd += b*d;
+        c2 += c*c; cd += c*d;
+        d2 += d*d;
+    }
+    
+    quadric& operator+= (const quadric &q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        return *this;
+    }
+    
+    double error (const double *p) const
+    {
+        double x = p[0], y = p[1], z = p[2];
+        
+        return a2*x*x + 2*ab*x*y + 2*ac*x*z + 2*ad*x
+                      + b2*y*y   + 2*bc*y*z + 2*bd*y
+                                 + c2*z*z   + 2*cd*z
+                                            + d2;
+    }
+    
+    // find the position minimising the error, returns false if the 
+    // system is too badly conditioned to trust the solution
+    bool optimal (double *p) const
+    {
+        double det = a2 * (b2*c2 - bc*bc) 
+                   - ab * (ab*c2 - bc*ac) 
+                   + ac * (ab*bc - b2*ac);
+        
+        double scale = a2 + b2 + c2;
+        
+        if (std::fabs (det) <= 1e-12 * scale * scale * scale)
+        {
+            return false;
+        }
+        
+        p[0] = -( ad * (b2*c2 - bc*bc) - ab * (bd*c2 - bc*cd) + ac * (bd*bc - b2*cd) ) / det;
+        p[1] = -( a2 * (bd*c2 - cd*bc) - ad * (ab*c2 - bc*ac) + ac * (ab*cd - bd*ac) ) / det;
+        p[2] = -( a2 * (b2*cd - bc*bd) - ab * (ab*cd - bd*ac) + ad * (ab*bc - b2*ac) ) / det;
+        
+        return true;
+    }
+};
+
+// a candidate edge collapse in the priority queue, the versions of the two
+// vertices at the time the candidate was created are stored so stale 
+// entries can be discarded when they reach the top of the queue
+struct collapse
+{
+    double cost;
+    int u, v;
+    int version_u, version_v;
+    double pos[3];
+    
+    bool operator> (const collapse &other) const { return cost > other.cost; }
+};
+
+inline void sub (const double *a, const double *b, double *r)
+{
+    r[0] = a[0] - b[0]; r[1] = a[1] - b[1]; r[2] = a[2] - b[2];
+}
+
+inline void cross (const double *a, const double *b, double *r)
+{
+    r[0] = a[1]*b[2] - a[2]*b[1];
+    r[1] = a[2]*b[0] - a[0]*b[2];
+    r[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+inline double dot (const double *a, const double *b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+void triangle_normal (const double *p0, const double *p1, const double *p2, double *n)
+{
+    double e1[3], e2[3];
+    sub (p1, p0, e1);
+    sub (p2, p0, e2);
+    cross (e1, e2, n);
+}
+
+class simplifier
+{
+public:
+    
+    simplifier (mesh_data &mesh) : mesh_m(mesh) {}
+    
+    int run (int target_faces, double max_error, progress_token *progress)
+    {
+        setup ();
+        
+        // never go below a tetrahedron
+        target_faces = std::max (target_faces, 4);
+        
+        double max_cost = (max_error < 0) ? -1.0 : max_error * max_error;
+        
+        int ncollapses = 0;
+        int initial_faces = live_faces_m;
+        unsigned int iteration = 0;
+        
+        while (live_faces_m > target_faces && !queue_m.empty ())
+        {
+            if (progress != NULL && (++iteration % PROGRESS_POLL_ITERATIONS) == 0)
+            {
+                progress->poll ("simplify", double (initial_faces - live_faces_m) 
+                                            / double (initial_faces - target_faces));
+            }
+            
+            collapse c = queue_m.top ();
+            queue_m.pop ();
+            
+            if (!alive_m[c.u] || !alive_m[c.v] 
+                || version_m[c.u] != c.version_u 
+                || version_m[c.v] != c.version_v)
+            {
+                // stale entry
+                continue;
+            }
+            
+            if (max_cost >= 0 && c.cost > max_cost)
+            {
+                // all remaining collapses are at least this expensive
+                break;
+            }
+            
+            if (can_collapse (c))
+            {
+                do_collapse (c);
+                ncollapses++;
+            }
+        }
+        
+        compact ();
+        
+        return ncollapses;
+    }
+    
+private:
+    
+    void setup ()
+    {
+        int nverts = mesh_m.num_vertices ();
+        int nfaces = mesh_m.num_faces ();
+        
+        pos_m = mesh_m.coords;
+        tris_m = mesh_m.face_verts;
+        tri_alive_m.assign (nfaces, 1);
+        live_faces_m = nfaces;
+        
+        alive_m.assign (nverts, 1);
+        locked_m.assign (nverts, 0);
+        version_m.assign (nverts, 0);
+        quadrics_m.assign (nverts, quadric ());
+        vert_tris_m.assign (nverts, std::vector<int> ());
+        
+        for (int t = 0; t < nfaces; t++)
+        {
+            const int *tri = &tris_m[3*t];
+            double n[3];
+            
+            triangle_normal (&pos_m[3*tri[0]], &pos_m[3*tri[1]], &pos_m[3*tri[2]], n);
+            
+            double len = std::sqrt (dot (n, n));
+            
+            for (int i = 0; i < 3; i++)
+            {
+                vert_tris_m[tri[i]].push_back (t);
+            }
+            
+            if (len <= 0)
+            {
+                continue;
+            }
+            
+            n[0] /= len; n[1] /= len; n[2] /= len;
+            
+            double d = -dot (n, &pos_m[3*tri[0]]);
+            
+            for (int i = 0; i < 3; i++)
+            {
+                quadrics_m[tri[i]].add_plane (n[0], n[1], n[2], d);
+            }
+        }
+        
+        // gather the unique edges, and lock the vertices of any edge which is
+        // not shared by exactly two faces so the collapses cannot alter the
+        // mesh topology there
+        std::vector< std::pair<int,int> > edges;
+        edges.reserve (3 * nfaces);
+        
+        for (int t = 0; t < nfaces; t++)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                int a = tris_m[3*t+i];
+                int b = tris_m[3*t+(i+1)%3];
+                edges.push_back (std::make_pair (std::min (a, b), std::max (a, b)));
+            }
+        }
+        
+        std::sort (edges.begin (), edges.end ());
+        
+        std::vector<collapse> candidates;
+        candidates.reserve (edges.size () / 2);
+        
+        for (size_t i = 0; i < edges.size (); )
+        {
+            size_t j = i + 1;
+            while (j < edges.size () && edges[j] == edges[i]) { j++; }
+            
+            if (j - i != 2)
+            {
+                locked_m[edges[i].first] = 1;
+                locked_m[edges[i].second] = 1;
+            }
+            else
+            {
+                candidates.push_back (make_collapse (edges[i].first, edges[i].second));
+            }
+            
+            i = j;
+        }
+        
+        queue_m = queue_type (std::greater<collapse> (), candidates);
+    }
+    
+    collapse make_collapse (int u, int v)
+    {
+        collapse c;
+        
+        c.u = u;
+        c.v = v;
+        c.version_u = version_m[u];
+        c.version_v = version_m[v];
+        
+        quadric q = quadrics_m[u];
+        q += quadrics_m[v];
+        
+        if (q.optimal (c.pos))
+        {
+            c.cost = q.error (c.pos);
+        }
+        else
+        {
+            // fall back to the best of the end points and the mid point
+            const double *pu = &pos_m[3*u];
+            const double *pv = &pos_m[3*v];
+            double mid[3] = { 0.5*(pu[0]+pv[0]), 0.5*(pu[1]+pv[1]), 0.5*(pu[2]+pv[2]) };
+            const double *choices[3] = { pu, pv, mid };
+            
+            c.cost = -1;
+            
+            for (int i = 0; i < 3; i++)
+            {
+                double e = q.error (choices[i]);
+                
+                if (c.cost < 0 || e < c.cost)
+                {
+                    c.cost = e;
+                    std::copy (choices[i], choices[i] + 3, c.pos);
+                }
+            }
+        }
+        
+        // the quadric error can go very slightly negative due to rounding
+        c.cost = std::max (c.cost, 0.0);
+        
+        return c;
+    }
+    
+    bool tri_has (int t, int vert) const
+    {
+        const int *tri = &tris_m[3*t];
+        return tri[0] == vert || tri[1] == vert || tri[2] == vert;
+    }
+    
+    void neighbours (int vert, std::vector<int> &out) const
+    {
+        out.clear ();
+        
+        for (size_t i = 0; i < vert_tris_m[vert].size (); i++)
+        {
+            int t = vert_tris_m[vert][i];
+            
+            if (!tri_alive_m[t]) { continue; }
+            
+            for (int k = 0; k < 3; k++)
+            {
+                int w = tris_m[3*t+k];
+                
+                if (w != vert) { out.push_back (w); }
+            }
+        }
+        
+        std::sort (out.begin (), out.end ());
+        out.erase (std::unique (out.begin (), out.end ()), out.end ());
+    }
+    
+    bool can_collapse (const collapse &c)
+    {
+        if (locked_m[c.u] || locked_m[c.v]) { return false; }
+        
+        // the edge must be shared by exactly two faces
+        int opposite[2];
+        int nshared = 0;
+        
+        for (size_t i = 0; i < vert_tris_m[c.u].size (); i++)
+        {
+            int t = vert_tris_m[c.u][i];
+            
+            if (tri_alive_m[t] && tri_has (t, c.v))
+            {
+                if (nshared == 2) { return false; }
+                
+                for (int k = 0; k < 3; k++)
+                {
+                    int w = tris_m[3*t+k];
+                    if (w != c.u && w != c.v) { opposite[nshared] = w; }
+                }
+                
+                nshared++;
+            }
+        }
+        
+        if (nshared != 2) { return false; }
+        
+        // link condition, the only vertices adjacent to both end points may 
+        // be the two opposite the edge
+        neighbours (c.u, nbrs_u_m);
+        neighbours (c.v, nbrs_v_m);
+        
+        int ncommon = 0;
+        
+        for (size_t i = 0; i < nbrs_v_m.size (); i++)
+        {
+            if (std::binary_search (nbrs_u_m.begin (), nbrs_u_m.end (), nbrs_v_m[i]))
+            {
+                if (nbrs_v_m[i] != opposite[0] && nbrs_v_m[i] != opposite[1])
+                {
+                    return false;
+                }
+                ncommon++;
+            }
+        }
+        
+        if (ncommon != 2) { return false; }
+        
+        // reject collapses which would flip or degenerate a remaining face
+        return !flips (c.u, c.v, c.pos) && !flips (c.v, c.u, c.pos);
+    }
+    
+    // check the faces around vert which do not contain other after moving 
+    // vert to pos
+    bool flips (int vert, int other, const double *pos) const
+    {
+        for (size_t i = 0; i < vert_tris_m[vert].size (); i++)
+        {
+            int t = vert_tris_m[vert][i];
+            
+            if (!tri_alive_m[t] || tri_has (t, other)) { continue; }
+            
+            const int *tri = &tris_m[3*t];
+            const double *p[3];
+            
+            for (int k = 0; k < 3; k++) { p[k] = &pos_m[3*tri[k]]; }
+            
+            double nold[3], nnew[3];
+            triangle_normal (p[0], p[1], p[2], nold);
+            
+            for (int k = 0; k < 3; k++) { if (tri[k] == vert) { p[k] = pos; } }
+            
+            triangle_normal (p[0], p[1], p[2], nnew);
+            
+            double lold = std::sqrt (dot (nold, nold));
+            double lnew = std::sqrt (dot (nnew, nnew));
+            
+            if (lnew <= 1e-12 * lold || dot (nold, nnew) <= 0.1 * lold * lnew)
+            {
+                return true;
+            }
+        }
+        
+        return false;
+    }
+    
+    void do_collapse (const collapse &c)
+    {
+        int u = c.u;
+        int v = c.v;
+        
+        std::copy (c.pos, c.pos + 3, &pos_m[3*u]);
+        quadrics_m[u] += quadrics_m[v];
+        
+        // move the faces of v over to u, removing the two faces which 
+        // contained the edge
+        for (size_t i = 0; i < vert_tris_m[v].size (); i++)
+        {
+            int t = vert_tris_m[v][i];
+            
+            if (!tri_alive_m[t]) { continue; }
+            
+            if (tri_has (t, u))
+            {
+                tri_alive_m[t] = 0;
+                live_faces_m--;
+            }
+            else
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    if (tris_m[3*t+k] == v) { tris_m[3*t+k] = u; }
+                }
+                vert_tris_m[u].push_back (t);
+            }
+        }
+        
+        // drop dead faces from the face list of u
+        std::vector<int> &ut = vert_tris_m[u];
+        size_t n = 0;
+        for (size_t i = 0; i < ut.size (); i++)
+        {
+            if (tri_alive_m[ut[i]]) { ut[n++] = ut[i]; }
+        }
+        ut.resize (n);
+        
+        std::vector<int>().swap (vert_tris_m[v]);
+        alive_m[v] = 0;
+        version_m[u]++;
+        version_m[v]++;
+        
+        // queue new candidates for all the edges now meeting at u
+        neighbours (u, nbrs_u_m);
+        
+        for (size_t i = 0; i < nbrs_u_m.size (); i++)
+        {
+            queue_m.push (make_collapse (u, nbrs_u_m[i]));
+        }
+    }
+    
+    void compact ()
+    {
+        std::vector<int> newid (alive_m.size (), -1);
+        
+        mesh_m.clear ();
+        
+        for (size_t i = 0; i < alive_m.size (); i++)
+        {
+            if (alive_m[i] && !vert_tris_m[i].empty ())
+            {
+                newid[i] = mesh_m.add_vertex (pos_m[3*i], pos_m[3*i+1], pos_m[3*i+2]);
+            }
+        }
+        
+        mesh_m.face_verts.reserve (3 * live_faces_m);
+        mesh_m.face_start.reserve (live_faces_m + 1);
+        
+        for (size_t t = 0; t < tri_alive_m.size (); t++)
+        {
+            if (tri_alive_m[t])
+            {
+                mesh_m.add_triangle (newid[tris_m[3*t]], newid[tris_m[3*t+1]], newid[tris_m[3*t+2]]);
+            }
+        }
+    }
+    
+    typedef std::priority_queue< collapse, std::vector<collapse>, std::greater<collapse> > queue_type;
+    
+    mesh_data &mesh_m;
+    std::vector<double> pos_m;
+    std::vector<int> tris_m;
+    std::vector<char> tri_alive_m;
+    int live_faces_m;
+    std::vector<char> alive_m;
+    std::vector<char> locked_m;
+    std::vector<int> version_m;
+    std::vector<quadric> quadrics_m;
+    std::vector< std::vector<int> > vert_tris_m;
+    queue_type queue_m;
+    // scratch space for neighbour queries
+    std::vector<int> nbrs_u_m;
+    std::vector<int> nbrs_v_m;
+};
+
+} // anonymous namespace
+
+int simplify_mesh (mesh_data &mesh, int target_faces, double max_error, progress_token *progress)
+{
+    if (!mesh.is_triangulated ())
+    {
+        throw std::invalid_argument ("Mesh must be triangulated before simplification.");
+    }
+    
+    if (mesh.num_faces () <= target_faces)
+    {
+        return 0;
+    }
+    
+    simplifier s (mesh);
+    
+    return s.run (target_faces, max_error, progress);
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,33 @@
+/*
+   simplify.hpp
+   
+   Mesh decimation by edge collapse using quadric error metrics 
+   (Garland & Heckbert, 1997)
+
+*/
+
+#ifndef __SIMPLIFY_HPP__
+#define __SIMPLIFY_HPP__
+
+#include "mesh_data.hpp"
+#include "progress.hpp"
+
+namespace mpolycsg {
+
+// Reduce the number of faces of a closed triangle mesh by repeatedly 
+// collapsing the edge with the lowest quadric error until the mesh has
+// target_faces faces or the next collapse would introduce an error larger
+// than max_error (a distance, any negative value means no limit).
+//
+// Collapses which would change the topology of the mesh (i.e. violate the 
+// link condition), flip a face or touch a non-manifold edge are rejected, 
+// so a closed 2-manifold input produces a closed 2-manifold output. The 
+// input must be triangulated. Returns the number of collapses performed.
+//
+// If a progress token is supplied it is polled during the decimation, the
+// mesh is left unchanged if it is cancelled.
+int simplify_mesh (mesh_data &mesh, int target_faces, double max_error, progress_token *progress=NULL);
+
+} // namespace mpolycsg
+
+#endif // __SIMPLIFY_HPP__
@@ -0,0 +1,277 @@
+/*
+   stats.cpp
+   
+   Per-operation timing and memory instrumentation
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "stats.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// upper limit on the number of trace events kept, about 100MB
+const size_t MAX_TRACE_EVENTS = 1000000;
+
+typedef std::chrono::steady_clock clock_type;
+
+const clock_type::time_point& epoch ()
+{
+    static const clock_type::time_point t0 = clock_type::now ();
+    return t0;
+}
+
+#ifdef MPOLYCSG_TRACK_ALLOCATIONS
+thread_local unsigned long long allocated_bytes = 0;
+#endif
+
+// small sequential id of the calling thread for the trace output
+unsigned long thread_number ()
+{
+    static std::atomic<unsigned long> next_thread (1);
+    static thread_local unsigned long number = next_thread++;
+    return number;
+}
+
+// escape a string for inclusion in JSON output
+std::string json_escape (const std::string &str)
+{
+    std::string out;
+    
+    for (size_t i = 0; i < str.size (); i++)
+    {
+        char c = str[i];
+        
+        if (c == '"' || c == '\\')
+        {
+            out.push_back ('\\');
+            out.push_back (c);
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            char buf[8];
+            std::snprintf (buf, sizeof (buf), "\\u%04x", c);
+            out += buf;
+        }
+        else
+        {
+            out.push_back (c);
+        }
+    }
+    
+    return out;
+}
+
+} // anonymous namespace
+
+unsigned long long thread_allocated_bytes ()
+{
+#ifdef MPOLYCSG_TRACK_ALLOCATIONS
+    return allocated_bytes;
+#else
+    return 0;
+#endif
+}
+
+stats_registry& stats_registry::instance ()
+{
+    static stats_registry registry;
+    return registry;
+}
+
+stats_registry::stats_registry () : tracing_m(false)
+{
+    epoch ();
+    
+    const char *trace_file = std::getenv ("MPOLYCSG_TRACE");
+    
+    if (trace_file != NULL && trace_file[0] != '\0')
+    {
+        session_trace_file_m = trace_file;
+        tracing_m = true;
+    }
+}
+
+stats_registry::~stats_registry ()
+{
+    if (!session_trace_file_m.empty ())
+    {
+        write_trace (session_trace_file_m);
+    }
+}
+
+double stats_registry::now () const
+{
+    return std::chrono::duration<double> (clock_type::now () - epoch ()).count ();
+}
+
+void stats_registry::record (const std::string &name, double start, double duration, 
+                             unsigned long long bytes, long faces_in, long faces_out)
+{
+    std::lock_guard<std::mutex> lock (mutex_m);
+    
+    op_stats &s = stats_m[name];
+    
+    s.calls++;
+    s.total_time += duration;
+    s.max_time = std::max (s.max_time, duration);
+    s.bytes_allocated += bytes;
+    s.faces_in += std::max (faces_in, 0L);
+    s.faces_out += std::max (faces_out, 0L);
+    
+    if (tracing_m && events_m.size () < MAX_TRACE_EVENTS)
+    {
+        trace_event e;
+        
+        e.name = name;
+        e.start = start;
+        e.duration = duration;
+        e.thread = thread_number ();
+        e.faces_in = faces_in;
+        e.faces_out = faces_out;
+        
+        events_m.push_back (e);
+    }
+}
+
+std::map<std::string, op_stats> stats_registry::snapshot () const
+{
+    std::lock_guard<std::mutex> lock (mutex_m);
+    
+    return stats_m;
+}
+
+void stats_registry::reset ()
+{
+    std::lock_guard<std::mutex> lock (mutex_m);
+    
+    stats_m.clear ();
+}
+
+void stats_registry::set_tracing (bool on)
+{
+    std::lock_guard<std::mutex> lock (mutex_m);
+    
+    if (on && !tracing_m)
+    {
+        events_m.clear ();
+    }
+    
+    tracing_m = on;
+}
+
+bool stats_registry::tracing () const
+{
+    std::lock_guard<std::mutex> lock (mutex_m);
+    
+    return tracing_m;
+}
+
+bool stats_registry::write_trace (const std::string &filename) const
+{
+    std::lock_guard<std::mutex> lock (mutex_m);
+    
+    FILE *fid = std::fopen (filename.c_str (), "w");
+    
+    if (fid == NULL)
+    {
+        return false;
+    }
+    
+    std::fprintf (fid, "{\"traceEvents\":[\n");
+    
+    for (size_t i = 0; i < events_m.size (); i++)
+    {
+        const trace_event &e = events_m[i];
+        
+        // complete events, times are in microseconds
+        std::fprintf (fid, "{\"name\":\"%s\",\"cat\":\"mpolycsg\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                           "\"pid\":1,\"tid\":%lu,\"args\":{",
+                      json_escape (e.name).c_str (), e.start * 1e6, e.duration * 1e6, e.thread);
+        
+        // face counts are only known for the engine operations
+        if (e.faces_in >= 0 && e.faces_out >= 0)
+        {
+            std::fprintf (fid, "\"faces_in\":%ld,\"faces_out\":%ld", e.faces_in, e.faces_out);
+        }
+        
+        std::fprintf (fid, "}}%s\n", (i + 1 < events_m.size ()) ? "," : "");
+    }
+    
+    std::fprintf (fid, "],\"displayTimeUnit\":\"ms\"}\n");
+    
+    return std::fclose (fid) == 0;
+}
+
+scoped_timer::scoped_timer (const std::string &name) 
+    : name_m(name), faces_in_m(-1), faces_out_m(-1)
+{
+    start_bytes_m = thread_allocated_bytes ();
+    start_m = stats_registry::instance ().now ();
+}
+
+scoped_timer::~scoped_timer ()
+{
+    stats_registry &registry = stats_registry::instance ();
+    
+    double duration = registry.now () - start_m;
+    
+    registry.record (name_m, start_m, duration, 
+                     thread_allocated_bytes () - start_bytes_m, 
+                     faces_in_m, faces_out_m);
+}
+
+} // namespace mpolycsg
+
+#ifdef MPOLYCSG_TRACK_ALLOCATIONS
+
+// count every allocation made through operator new, only allocations are
+// counted so delete is a plain free
+void* operator new (std::size_t size)
+{
+    mpolycsg::allocated_bytes += size;
+    
+    void *p = std::malloc (size ? size : 1);
+    
+    if (p == NULL)
+    {
+        throw std::bad_alloc ();
+    }
+    
+    return p;
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    mpolycsg::allocated_bytes += size;
+    
+    return std::malloc (size ? size : 1);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new (size, std::nothrow);
+}
+
+void operator delete (void *p) noexcept { std::free (p); }
+
+void operator delete[] (void *p) noexcept { std::free (p); }
+
+void operator delete (void *p, std::size_t) noexcept { std::free (p); }
+
+void operator delete[] (void *p, std::size_t) noexcept { std::free (p); }
+
+#endif // MPOLYCSG_TRACK_ALLOCATIONS
@@ -0,0 +1,129 @@
+/*
+   stats.hpp
+   
+   Per-operation timing and memory instrumentation. Every engine operation
+   and every mexfunction command is timed with a scoped_timer, which adds 
+   its call to a process wide registry recording the number of calls, 
+   total and maximum wall time, bytes allocated and the number of faces 
+   going in and out of the operation.
+   
+   Bytes allocated are only counted when the library is compiled with
+   MPOLYCSG_TRACK_ALLOCATIONS defined, which replaces the global operator
+   new, otherwise they are reported as zero.
+   
+   The registry can also record every call as a Chrome trace event (view
+   the output in chrome://tracing or https://ui.perfetto.dev). Tracing for
+   a whole session is enabled by setting the environment variable
+   MPOLYCSG_TRACE to the output file name before the library is loaded,
+   the trace is then written when the library is unloaded.
+
+*/
+
+#ifndef __STATS_HPP__
+#define __STATS_HPP__
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mpolycsg {
+
+struct op_stats
+{
+    op_stats () : calls(0), total_time(0), max_time(0), bytes_allocated(0), faces_in(0), faces_out(0) {}
+    
+    unsigned long long calls;
+    // wall time in seconds
+    double total_time;
+    double max_time;
+    unsigned long long bytes_allocated;
+    unsigned long long faces_in;
+    unsigned long long faces_out;
+};
+
+class stats_registry
+{
+public:
+    
+    // the process wide registry
+    static stats_registry& instance ();
+    
+    // add a call to the statistics, start is the time of the call in 
+    // seconds since the registry was created
+    void record (const std::string &name, double start, double duration, 
+                 unsigned long long bytes, long faces_in, long faces_out);
+    
+    // copy of the statistics of all operations called so far
+    std::map<std::string, op_stats> snapshot () const;
+    
+    void reset ();
+    
+    // seconds since the registry was created
+    double now () const;
+    
+    // start or stop recording trace events, starting clears any events
+    // already recorded
+    void set_tracing (bool on);
+    
+    bool tracing () const;
+    
+    // write the recorded events in the Chrome trace event JSON format, 
+    // returns false if the file could not be written
+    bool write_trace (const std::string &filename) const;
+    
+    ~stats_registry ();
+    
+private:
+    
+    stats_registry ();
+    
+    struct trace_event
+    {
+        std::string name;
+        double start;
+        double duration;
+        unsigned long thread;
+        long faces_in;
+        long faces_out;
+    };
+    
+    mutable std::mutex mutex_m;
+    std::map<std::string, op_stats> stats_m;
+    bool tracing_m;
+    std::vector<trace_event> events_m;
+    // file to write the trace to on exit, from MPOLYCSG_TRACE
+    std::string session_trace_file_m;
+    
+};
+
+// bytes allocated by the calling thread so far, always zero unless 
+// compiled with MPOLYCSG_TRACK_ALLOCATIONS
+unsigned long long thread_allocated_bytes ();
+
+// times the enclosing scope and records it in the stats_registry
+class scoped_timer
+{
+public:
+    
+    scoped_timer (const std::string &name);
+    
+    ~scoped_timer ();
+    
+    void set_faces_in (long faces) { faces_in_m = faces; }
+    
+    void set_faces_out (long faces) { faces_out_m = faces; }
+    
+private:
+    
+    std::string name_m;
+    double start_m;
+    unsigned long long start_bytes_m;
+    long faces_in_m;
+    long faces_out_m;
+    
+};
+
+} // namespace mpolycsg
+
+#endif // __STATS_HPP__
@@ -0,0 +1,336 @@
+/*
+   sweep.cpp
+   
+   Sweeping of a planar profile along a 3D polyline path
+
+*/
+
+#include <cmath>
+#include <stdexcept>
+
+#include "extrude.hpp"
+#include "sweep.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+inline double dot (const double *a, const double *b)
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+inline void cross (const double *a, const double *b, double *r)
+{
+    r[0] = a[1]*b[2] - a[2]*b[1];
+    r[1] = a[2]*b[0] - a[0]*b[2];
+    r[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+// normalise in place, returns the original length
+inline double normalise (double *a)
+{
+    double len = std::sqrt (dot (a, a));
+    
+    if (len > 0)
+    {
+        a[0] /= len;
+        a[1] /= len;
+        a[2] /= len;
+    }
+    
+    return len;
+}
+
+// reflect a in the plane through the origin with normal v, where c = v.v
+inline void reflect (double *a, const double *v, double c)
+{
+    double f = 2.0 * dot (v, a) / c;
+    
+    a[0] -= f * v[0];
+    a[1] -= f * v[1];
+    a[2] -= f * v[2];
+}
+
+// rotate x by the smallest rotation taking the unit vector a to the unit 
+// vector b, as two reflections, in the planes normal to a + b and to b
+inline void rotate_between (double *x, const double *a, const double *b)
+{
+    double h[3] = { a[0] + b[0], a[1] + b[1], a[2] + b[2] };
+    
+    reflect (x, h, dot (h, h));
+    reflect (x, b, 1.0);
+}
+
+} // anonymous namespace
+
+void sweep_region (const std::vector< std::vector<double> > &loops, const std::vector<double> &path, 
+                   const double *normal, mesh_data &mesh)
+{
+    mesh_data cap;
+    std::vector< std::vector<int> > boundaries;
+    
+    region_cap (loops, cap, boundaries);
+    
+    int npath = (int)(path.size () / 3);
+    
+    if (npath < 2)
+    {
+        throw std::invalid_argument ("Sweep path must have at least two points.");
+    }
+    
+    const double *first = &path[0];
+    const double *last = &path[3*(npath-1)];
+    
+    bool closed = (npath > 3 && first[0] == last[0] && first[1] == last[1] && first[2] == last[2]);
+    
+    // number of copies of the profile, and of segments joining them
+    int nrings = closed ? npath - 1 : npath;
+    int nsegs = closed ? nrings : nrings - 1;
+    
+    // segment directions
+    std::vector<double> dir (3 * nsegs);
+    std::vector<double> seglen (nsegs);
+    
+    for (int i = 0; i < nsegs; i++)
+    {
+        const double *a = &path[3*i];
+        const double *b = &path[3*((i + 1) % nrings)];
+        
+        double *d = &dir[3*i];
+        d[0] = b[0] - a[0];
+        d[1] = b[1] - a[1];
+        d[2] = b[2] - a[2];
+        
+        seglen[i] = normalise (d);
+        
+        if (seglen[i] == 0.0)
+        {
+            throw std::invalid_argument ("Sweep path has a segment of zero length.");
+        }
+    }
+    
+    // the frame of each segment, the first from the normal, the rest 
+    // transported from one segment to the next by the smallest rotation 
+    // between them, so they don't twist about the path
+    std::vector<double> frame_r (3 * nsegs);
+    std::vector<double> frame_s (3 * nsegs);
+    
+    double *r0 = &frame_r[0];
+    const double *t0 = &dir[0];
+    
+    r0[0] = r0[1] = r0[2] = 0.0;
+    
+    if (normal != NULL)
+    {
+        // the component perpendicular to the path
+        double nt = dot (normal, t0);
+        
+        r0[0] = normal[0] - nt * t0[0];
+        r0[1] = normal[1] - nt * t0[1];
+        r0[2] = normal[2] - nt * t0[2];
+    }
+    
+    if (normalise (r0) < 1e-8)
+    {
+        // the axis least aligned with the path
+        int axis = 0;
+        for (int k = 1; k < 3; k++)
+        {
+            if (std::fabs (t0[k]) < std::fabs (t0[axis])) { axis = k; }
+        }
+        
+        double e[3] = { 0.0, 0.0, 0.0 };
+        e[axis] = 1.0;
+        
+        double tmp[3];
+        cross (t0, e, tmp);
+        cross (tmp, t0, r0);
+        normalise (r0);
+    }
+    
+    for (int i = 0; i < nsegs; i++)
+    {
+        const double *din = &dir[3*i];
+        const double *dout = &dir[3*((i + 1) % nsegs)];
+        
+        if (dot (din, dout) < -1.0 + 1e-12)
+        {
+            throw std::invalid_argument ("Sweep path reverses direction.");
+        }
+        
+        if (i + 1 < nsegs)
+        {
+            double *r = &frame_r[3*(i+1)];
+            r[0] = frame_r[3*i]; r[1] = frame_r[3*i+1]; r[2] = frame_r[3*i+2];
+            rotate_between (r, din, dout);
+            normalise (r);
+        }
+    }
+    
+    if (closed)
+    {
+        // going round, the frame comes back rotated about the path, spread
+        // the angle evenly along the path so it meets itself
+        double r_end[3] = { frame_r[3*(nsegs-1)], frame_r[3*(nsegs-1)+1], frame_r[3*(nsegs-1)+2] };
+        rotate_between (r_end, &dir[3*(nsegs-1)], t0);
+        
+        double c[3];
+        cross (r_end, r0, c);
+        double angle = std::atan2 (dot (c, t0), dot (r_end, r0));
+        
+        double total = 0.0;
+        for (int i = 0; i < nsegs; i++) { total += seglen[i]; }
+        
+        // the frame of segment i turns from that of segment i - 1 by
+        // its share of the angle, in proportion to its length
+        double along = 0.0;
+        
+        for (int i = 1; i < nsegs; i++)
+        {
+            along += seglen[i];
+            
+            double *r = &frame_r[3*i];
+            const double *t = &dir[3*i];
+            double a = angle * along / total;
+            double tr[3];
+            cross (t, r, tr);
+            
+            r[0] = std::cos (a) * r[0] + std::sin (a) * tr[0];
+            r[1] = std::cos (a) * r[1] + std::sin (a) * tr[1];
+            r[2] = std::cos (a) * r[2] + std::sin (a) * tr[2];
+        }
+    }
+    
+    for (int i = 0; i < nsegs; i++)
+    {
+        cross (&dir[3*i], &frame_r[3*i], &frame_s[3*i]);
+    }
+    
+    // size the mesh in one go
+    int nprofile = cap.num_vertices ();
+    
+    size_t nedges = 0;
+    for (size_t l = 0; l < boundaries.size (); l++)
+    {
+        nedges += boundaries[l].size ();
+    }
+    
+    size_t nsides = nedges * nsegs;
+    size_t ncaps = closed ? 0 : cap.num_faces ();
+    size_t ncapverts = closed ? 0 : cap.face_verts.size ();
+    
+    mesh.clear ();
+    mesh.coords.resize (3 * (size_t)nprofile * nrings);
+    mesh.face_start.resize (nsides + 2 * ncaps + 1);
+    mesh.face_verts.resize (4 * nsides + 2 * ncapverts);
+    
+    // the copies of the profile, at the joints the cross section of the 
+    // incoming segment is projected along it onto the plane bisecting the 
+    // joint, which is also where the outgoing cross section projects to
+    double *x = &mesh.coords[0];
+    
+    for (int i = 0; i < nrings; i++)
+    {
+        const double *p = &path[3*i];
+        
+        // the segment whose frame places this copy
+        int seg = (i > 0) ? i - 1 : (closed ? nsegs - 1 : 0);
+        
+        const double *d = &dir[3*seg];
+        const double *r = &frame_r[3*seg];
+        const double *sv = &frame_s[3*seg];
+        
+        bool mitre = closed || (i > 0 && i < nrings - 1);
+        
+        double t[3] = { 0.0, 0.0, 0.0 };
+        double cos_half = 1.0;
+        
+        if (mitre)
+        {
+            const double *dout = &dir[3*(i % nsegs)];
+            
+            t[0] = d[0] + dout[0];
+            t[1] = d[1] + dout[1];
+            t[2] = d[2] + dout[2];
+            normalise (t);
+            
+            cos_half = dot (t, d);
+        }
+        
+        for (int j = 0; j < nprofile; j++, x += 3)
+        {
+            double u = cap.coords[3*j];
+            double v = cap.coords[3*j+1];
+            
+            double w[3] = { u * r[0] + v * sv[0], 
+                            u * r[1] + v * sv[1], 
+                            u * r[2] + v * sv[2] };
+            
+            double lambda = mitre ? -dot (w, t) / cos_half : 0.0;
+            
+            x[0] = p[0] + w[0] + lambda * d[0];
+            x[1] = p[1] + w[1] + lambda * d[1];
+            x[2] = p[2] + w[2] + lambda * d[2];
+        }
+    }
+    
+    // the sides, the profile is counter-clockwise about the path so these
+    // face outwards as for an extrusion
+    int *start = &mesh.face_start[0];
+    int *fv = mesh.face_verts.empty () ? NULL : &mesh.face_verts[0];
+    int nfv = 0;
+    
+    *start++ = 0;
+    
+    for (int i = 0; i < nsegs; i++)
+    {
+        int ring0 = i * nprofile;
+        int ring1 = ((i + 1) % nrings) * nprofile;
+        
+        for (size_t l = 0; l < boundaries.size (); l++)
+        {
+            const std::vector<int> &loop = boundaries[l];
+            size_t n = loop.size ();
+            
+            for (size_t e = 0; e < n; e++)
+            {
+                int a = loop[e];
+                int b = loop[(e + 1) % n];
+                
+                fv[nfv++] = ring0 + a;
+                fv[nfv++] = ring0 + b;
+                fv[nfv++] = ring1 + b;
+                fv[nfv++] = ring1 + a;
+                
+                *start++ = nfv;
+            }
+        }
+    }
+    
+    // the caps of an open path, the first facing backwards
+    if (!closed)
+    {
+        int ring1 = (nrings - 1) * nprofile;
+        
+        for (int c = 0; c < cap.num_faces (); c++)
+        {
+            int n = cap.face_size (c);
+            const int *verts = cap.face (c);
+            
+            for (int k = n - 1; k >= 0; k--)
+            {
+                fv[nfv++] = verts[k];
+            }
+            *start++ = nfv;
+            
+            for (int k = 0; k < n; k++)
+            {
+                fv[nfv++] = ring1 + verts[k];
+            }
+            *start++ = nfv;
+        }
+    }
+}
+
+} // namespace mpolycsg
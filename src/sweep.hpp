@@ -0,0 +1,44 @@
+/*
+   sweep.hpp
+   
+   Sweeping of a planar profile along a 3D polyline path
+
+*/
+
+#ifndef __SWEEP_HPP__
+#define __SWEEP_HPP__
+
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// Sweep a profile along a polyline path of x, y, z points, producing a 
+// single closed mesh. The profile is a region of the plane bounded by 
+// loops of u, v coordinate pairs, nested as described for extrude_region,
+// so hollow profiles such as tubes are supported.
+//
+// A copy of the profile is placed at each point of the path, in the plane
+// perpendicular to the path, or at the joints between segments the plane 
+// bisecting them, stretched so the cross section of each segment is the 
+// profile (a mitre joint). The u axis of the profile follows a rotation 
+// minimising frame, carried from each segment to the next by the smallest
+// rotation between their directions, so the profile does not twist about
+// the path. It starts along normal projected perpendicular to the start of
+// the path, or along an arbitrary perpendicular if normal is NULL or 
+// parallel to the path.
+//
+// If the last point of the path is the same as the first the path is 
+// closed, the ends are joined without caps and the twist needed for the 
+// frame to meet itself is spread evenly along the path.
+//
+// The mesh is sized once and filled in a single pass. Throws 
+// std::invalid_argument for degenerate profiles or paths, e.g. with zero 
+// length segments or complete reversals of direction.
+void sweep_region (const std::vector< std::vector<double> > &loops, const std::vector<double> &path, 
+                   const double *normal, mesh_data &mesh);
+
+} // namespace mpolycsg
+
+#endif // __SWEEP_HPP__
@@ -0,0 +1,58 @@
+/*
+   tessellation.cpp
+   
+   Selection of the number of segments used to approximate curved 
+   primitives from a maximum chordal deviation
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "tessellation.hpp"
+
+namespace mpolycsg {
+
+int segments_for_tolerance (double radius, double angle, double tol, int min_segments)
+{
+    if (!(tol > 0))
+    {
+        throw std::invalid_argument ("Chordal tolerance must be greater than zero.");
+    }
+    
+    radius = std::fabs (radius);
+    angle = std::fabs (angle);
+    
+    if (tol >= radius)
+    {
+        // any chord is within tolerance
+        return min_segments;
+    }
+    
+    // largest angle subtended by a single segment
+    double theta = 2.0 * std::acos (1.0 - tol / radius);
+    
+    double nsegments = std::ceil (angle / theta);
+    
+    if (nsegments > MAX_TOLERANCE_SEGMENTS)
+    {
+        return std::max (MAX_TOLERANCE_SEGMENTS, min_segments);
+    }
+    
+    return std::max ((int)nsegments, min_segments);
+}
+
+double profile_radius (const std::vector<double> &coords)
+{
+    double r2 = 0;
+    
+    for (size_t i = 0; i + 1 < coords.size (); i += 2)
+    {
+        r2 = std::max (r2, coords[i]*coords[i] + coords[i+1]*coords[i+1]);
+    }
+    
+    return std::sqrt (r2);
+}
+
+} // namespace mpolycsg
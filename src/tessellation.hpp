@@ -0,0 +1,33 @@
+/*
+   tessellation.hpp
+   
+   Selection of the number of segments used to approximate curved 
+   primitives from a maximum chordal deviation
+
+*/
+
+#ifndef __TESSELLATION_HPP__
+#define __TESSELLATION_HPP__
+
+#include <vector>
+
+namespace mpolycsg {
+
+// upper limit on the number of segments chosen from a tolerance
+const int MAX_TOLERANCE_SEGMENTS = 4096;
+
+// Get the number of segments required to approximate an arc of the given
+// radius spanning angle (radians) such that the maximum distance between
+// any chord and the arc, the sagitta r (1 - cos (theta/2)), does not exceed 
+// tol. The result is clamped to the range [min_segments, 
+// MAX_TOLERANCE_SEGMENTS].
+int segments_for_tolerance (double radius, double angle, double tol, int min_segments=3);
+
+// Get the largest distance of any point of a 2D profile, supplied as 
+// x, y pairs, from the origin. This bounds the radius swept by any point of
+// the profile when it is revolved about either coordinate axis.
+double profile_radius (const std::vector<double> &coords);
+
+} // namespace mpolycsg
+
+#endif // __TESSELLATION_HPP__
@@ -0,0 +1,303 @@
+/*
+   triangulate.cpp
+   
+   Triangulation of the polygonal faces of a mesh by ear clipping
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "parallel.hpp"
+#include "triangulate.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// minimum number of face vertices worth handing to a thread
+const long MIN_CHUNK_FACE_VERTICES = 8192;
+
+// twice the signed area of the 2D triangle a, b, c
+inline double area2 (const double *a, const double *b, const double *c)
+{
+    return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+// true if p lies in or on the counter-clockwise 2D triangle a, b, c
+inline bool in_triangle (const double *a, const double *b, const double *c, const double *p)
+{
+    return area2 (a, b, p) >= 0 && area2 (b, c, p) >= 0 && area2 (c, a, p) >= 0;
+}
+
+inline bool same_point (const double *a, const double *b)
+{
+    return a[0] == b[0] && a[1] == b[1];
+}
+
+// ear clipping of one polygon at a time, the scratch space is reused 
+// between polygons
+class ear_clipper
+{
+public:
+    
+    int run (const double *coords, const int *verts, int n, std::vector<int> &tris)
+    {
+        if (n < 3)
+        {
+            return 0;
+        }
+        
+        if (n == 3 || !project (coords, verts, n))
+        {
+            // triangles, and degenerate polygons with no defined plane, 
+            // are fanned
+            for (int i = 1; i < n - 1; i++)
+            {
+                emit (verts, 0, i, i + 1, tris);
+            }
+            return n - 2;
+        }
+        
+        prev_m.resize (n);
+        next_m.resize (n);
+        
+        for (int i = 0; i < n; i++)
+        {
+            prev_m[i] = (i + n - 1) % n;
+            next_m[i] = (i + 1) % n;
+        }
+        
+        int remaining = n;
+        int i = 0;
+        int tested = 0;
+        
+        while (remaining > 3)
+        {
+            int p = prev_m[i];
+            int q = next_m[i];
+            
+            // if no ear is found after going all the way round, the polygon
+            // is degenerate or self-intersecting, clip the vertex anyway so
+            // every vertex remains connected
+            if (is_ear (p, i, q) || tested >= remaining)
+            {
+                emit (verts, p, i, q, tris);
+                
+                next_m[p] = q;
+                prev_m[q] = p;
+                remaining--;
+                tested = 0;
+                
+                i = q;
+            }
+            else
+            {
+                i = q;
+                tested++;
+            }
+        }
+        
+        emit (verts, prev_m[i], i, next_m[i], tris);
+        
+        return n - 2;
+    }
+    
+private:
+    
+    // project the polygon onto the coordinate plane most nearly parallel 
+    // to it, oriented so the polygon is counter-clockwise. Returns false if
+    // the polygon has no area
+    bool project (const double *coords, const int *verts, int n)
+    {
+        // Newell's method for the polygon normal
+        double normal[3] = { 0.0, 0.0, 0.0 };
+        
+        for (int i = 0; i < n; i++)
+        {
+            const double *a = &coords[3*verts[i]];
+            const double *b = &coords[3*verts[(i + 1) % n]];
+            
+            normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+            normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+            normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+        }
+        
+        int axis = 0;
+        for (int k = 1; k < 3; k++)
+        {
+            if (std::fabs (normal[k]) > std::fabs (normal[axis]))
+            {
+                axis = k;
+            }
+        }
+        
+        if (normal[axis] == 0.0)
+        {
+            return false;
+        }
+        
+        // the two remaining axes in cyclic order keep the orientation
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
+        double flip = (normal[axis] > 0) ? 1.0 : -1.0;
+        
+        xy_m.resize (2 * n);
+        
+        for (int i = 0; i < n; i++)
+        {
+            const double *a = &coords[3*verts[i]];
+            
+            xy_m[2*i] = flip * a[u];
+            xy_m[2*i+1] = a[v];
+        }
+        
+        return true;
+    }
+    
+    const double* point (int i) const { return &xy_m[2*i]; }
+    
+    // the triangle p, i, q is an ear if it is convex at i and no other 
+    // remaining vertex lies within it
+    bool is_ear (int p, int i, int q) const
+    {
+        const double *a = point (p);
+        const double *b = point (i);
+        const double *c = point (q);
+        
+        if (area2 (a, b, c) <= 0)
+        {
+            return false;
+        }
+        
+        for (int r = next_m[q]; r != p; r = next_m[r])
+        {
+            const double *x = point (r);
+            
+            // vertices repeated in the polygon (e.g. where a hole is 
+            // bridged) don't block the ear
+            if (same_point (x, a) || same_point (x, b) || same_point (x, c))
+            {
+                continue;
+            }
+            
+            if (in_triangle (a, b, c, x))
+            {
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    static void emit (const int *verts, int a, int b, int c, std::vector<int> &tris)
+    {
+        tris.push_back (verts[a]);
+        tris.push_back (verts[b]);
+        tris.push_back (verts[c]);
+    }
+    
+    std::vector<double> xy_m;
+    std::vector<int> prev_m;
+    std::vector<int> next_m;
+    
+};
+
+// triangulate the faces first_face to last_face - 1
+void triangulate_faces (const mesh_data &in, int first_face, int last_face, std::vector<int> &tris)
+{
+    ear_clipper clipper;
+    
+    for (int f = first_face; f < last_face; f++)
+    {
+        clipper.run (&in.coords[0], in.face (f), in.face_size (f), tris);
+    }
+}
+
+} // anonymous namespace
+
+int triangulate_polygon (const double *coords, const int *verts, int n, std::vector<int> &tris)
+{
+    ear_clipper clipper;
+    
+    return clipper.run (coords, verts, n, tris);
+}
+
+void triangulate_mesh (const mesh_data &in, mesh_data &out, int num_threads)
+{
+    out.clear ();
+    out.coords = in.coords;
+    
+    int nfaces = in.num_faces ();
+    
+    if (nfaces == 0)
+    {
+        return;
+    }
+    
+    if (in.is_triangulated ())
+    {
+        out.face_start = in.face_start;
+        out.face_verts = in.face_verts;
+        return;
+    }
+    
+    long total = in.face_start[nfaces];
+    
+    int nchunks = num_work_chunks (total, MIN_CHUNK_FACE_VERTICES, num_threads);
+    
+    // split the faces into blocks with roughly the same number of vertices
+    std::vector<int> chunk_start (nchunks + 1, nfaces);
+    chunk_start[0] = 0;
+    
+    for (int c = 1; c < nchunks; c++)
+    {
+        long target = (total * c) / nchunks;
+        chunk_start[c] = (int)(std::lower_bound (in.face_start.begin (), in.face_start.end () - 1, target) 
+                               - in.face_start.begin ());
+    }
+    
+    std::vector< std::vector<int> > chunk_tris (nchunks);
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        // a face of n vertices gives n - 2 triangles
+        long nverts = in.face_start[chunk_start[c+1]] - in.face_start[chunk_start[c]];
+        long nchunk_faces = chunk_start[c+1] - chunk_start[c];
+        chunk_tris[c].reserve (3 * std::max (0L, nverts - 2 * nchunk_faces));
+        
+        triangulate_faces (in, chunk_start[c], chunk_start[c+1], chunk_tris[c]);
+    });
+    
+    // offsets of each block in the output
+    std::vector<size_t> offset (nchunks + 1, 0);
+    
+    for (int c = 0; c < nchunks; c++)
+    {
+        offset[c+1] = offset[c] + chunk_tris[c].size ();
+    }
+    
+    out.face_verts.resize (offset[nchunks]);
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        if (!chunk_tris[c].empty ())
+        {
+            std::memcpy (&out.face_verts[offset[c]], &chunk_tris[c][0], chunk_tris[c].size () * sizeof (int));
+        }
+        
+        std::vector<int>().swap (chunk_tris[c]);
+    });
+    
+    int ntris = (int)(offset[nchunks] / 3);
+    
+    out.face_start.resize (ntris + 1);
+    
+    for (int t = 0; t <= ntris; t++)
+    {
+        out.face_start[t] = 3 * t;
+    }
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,35 @@
+/*
+   triangulate.hpp
+   
+   Triangulation of the polygonal faces of a mesh by ear clipping, with the
+   faces split across threads
+
+*/
+
+#ifndef __TRIANGULATE_HPP__
+#define __TRIANGULATE_HPP__
+
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// Triangulate a single planar polygon given by the indices of its n 
+// vertices in coords (x, y, z triplets), appending the vertex indices of 
+// the triangles to tris. The triangles have the same orientation as the 
+// polygon, which may be concave but should not self-intersect. Returns the
+// number of triangles added, n - 2 for a polygon of n >= 3 vertices.
+int triangulate_polygon (const double *coords, const int *verts, int n, std::vector<int> &tris);
+
+// Triangulate every face of a mesh. The faces are split into contiguous 
+// blocks triangulated on separate threads, using at most num_threads 
+// threads (zero or negative for one per hardware thread), and the results 
+// concatenated in face order, so the output is identical whatever the 
+// number of threads. Faces which are already triangles are copied 
+// unchanged and the vertices are not modified.
+void triangulate_mesh (const mesh_data &in, mesh_data &out, int num_threads=0);
+
+} // namespace mpolycsg
+
+#endif // __TRIANGULATE_HPP__
@@ -0,0 +1,502 @@
+/*
+   voxelize.cpp
+   
+   Rasterisation of a closed mesh onto a regular grid of voxels, as dense
+   arrays or as sparse blocks
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+#include "parallel.hpp"
+#include "stats.hpp"
+#include "voxelize.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+// below this many voxels per thread, threads cost more than they save
+const long MIN_CHUNK_VOXELS = 65536;
+
+// the edge function of the directed edge u to v at the point (py, pz), in
+// the y-z plane, positive if the point is to the left of the edge. It is
+// evaluated from the lower of the two vertices, so the two triangles
+// sharing an edge get exactly opposite values
+inline double edge_function (const double *u, const double *v, double py, double pz)
+{
+    if (u[1] < v[1] || (u[1] == v[1] && u[2] < v[2]))
+    {
+        return (v[1] - u[1]) * (pz - u[2]) - (v[2] - u[2]) * (py - u[1]);
+    }
+    
+    return -((u[1] - v[1]) * (pz - v[2]) - (u[2] - v[2]) * (py - v[1]));
+}
+
+// whether a point exactly on an edge, running in the direction (dy, dz)
+// anticlockwise around its triangle, belongs to the triangle. Of the two
+// triangles sharing an edge exactly one owns it, and of a fan of triangles
+// around a vertex exactly one owns the vertex
+inline bool owns_edge (double dy, double dz)
+{
+    return dz > 0.0 || (dz == 0.0 && dy < 0.0);
+}
+
+class layer_rasteriser
+{
+public:
+    
+    layer_rasteriser (const mesh_data &mesh, const voxel_grid &grid)
+        : mesh_m(mesh), grid_m(grid)
+    {
+        int nsub = std::max (1, grid.supersample);
+        
+        // positions of the rows within a voxel, as a fraction of its size
+        for (int r = 0; r < nsub; r++)
+        {
+            offset_m.push_back ((grid.supersample == 0) ? 0.5 : (r + 0.5) / nsub);
+        }
+        
+        // bin the triangles by the layers of rows they might cross,
+        // counting then filling, erring on the side of too many layers
+        int nz = grid.dims[2];
+        int ntris = mesh.num_faces ();
+        
+        std::vector<int> first (ntris);
+        std::vector<int> last (ntris);
+        
+        bin_start_m.assign (nz + 1, 0);
+        
+        for (int t = 0; t < ntris; t++)
+        {
+            double zmin, zmax;
+            z_range (t, zmin, zmax);
+            
+            first[t] = std::max (0, row_index (zmin, 2, offset_m.back ()) - 1);
+            last[t] = std::min (nz - 1, row_index (zmax, 2, offset_m.front ()) + 1);
+            
+            for (int k = first[t]; k <= last[t]; k++)
+            {
+                bin_start_m[k+1]++;
+            }
+        }
+        
+        for (int k = 0; k < nz; k++)
+        {
+            bin_start_m[k+1] += bin_start_m[k];
+        }
+        
+        bin_tris_m.resize (bin_start_m[nz]);
+        std::vector<int> fill (bin_start_m.begin (), bin_start_m.end () - 1);
+        
+        for (int t = 0; t < ntris; t++)
+        {
+            for (int k = first[t]; k <= last[t]; k++)
+            {
+                bin_tris_m[fill[k]++] = t;
+            }
+        }
+    }
+    
+    // the values of the voxels in layer k, dims[0] x dims[1] of them with
+    // x fastest, rows is scratch space for the crossings of each row
+    void rasterise (int k, float *values, std::vector< std::vector<double> > &rows) const
+    {
+        int nx = grid_m.dims[0];
+        int ny = grid_m.dims[1];
+        int nsub = (int)offset_m.size ();
+        
+        std::fill (values, values + (long)nx * ny, 0.0f);
+        
+        rows.resize (ny * nsub);
+        
+        for (int r = 0; r < nsub; r++)
+        {
+            double pz = sample (k, 2, offset_m[r]);
+            
+            for (size_t i = 0; i < rows.size (); i++)
+            {
+                rows[i].clear ();
+            }
+            
+            for (int b = bin_start_m[k]; b < bin_start_m[k+1]; b++)
+            {
+                cross_triangle (bin_tris_m[b], pz, rows);
+            }
+            
+            for (int j = 0; j < ny; j++)
+            {
+                for (int q = 0; q < nsub; q++)
+                {
+                    fill_row (rows[j*nsub + q], values + (long)j * nx);
+                }
+            }
+        }
+        
+        // the lengths inside summed over the rows, dividing at the end so
+        // voxels entirely inside are exactly one
+        if (nsub > 1)
+        {
+            float nrows = (float)(nsub * nsub);
+            
+            for (long i = 0; i < (long)nx * ny; i++)
+            {
+                values[i] /= nrows;
+            }
+        }
+    }
+
+private:
+    
+    // the coordinate along axis d of row n at the offset within the voxel
+    double sample (int n, int d, double offset) const
+    {
+        return grid_m.origin[d] + (n + offset) * grid_m.spacing[d];
+    }
+    
+    // the index of the voxel whose row at the offset is nearest below x
+    int row_index (double x, int d, double offset) const
+    {
+        double n = std::floor ((x - grid_m.origin[d]) / grid_m.spacing[d] - offset);
+        
+        return (int)std::max (-1.0, std::min (n, (double)grid_m.dims[d]));
+    }
+    
+    void z_range (int t, double &zmin, double &zmax) const
+    {
+        const int *verts = mesh_m.face (t);
+        
+        zmin = zmax = mesh_m.vertex (verts[0])[2];
+        
+        for (int i = 1; i < 3; i++)
+        {
+            zmin = std::min (zmin, mesh_m.vertex (verts[i])[2]);
+            zmax = std::max (zmax, mesh_m.vertex (verts[i])[2]);
+        }
+    }
+    
+    // add the crossings of triangle t by the rows at height pz
+    void cross_triangle (int t, double pz, std::vector< std::vector<double> > &rows) const
+    {
+        const int *verts = mesh_m.face (t);
+        const double *p[3] = { mesh_m.vertex (verts[0]), mesh_m.vertex (verts[1]), mesh_m.vertex (verts[2]) };
+        
+        double ymin = std::min (p[0][1], std::min (p[1][1], p[2][1]));
+        double ymax = std::max (p[0][1], std::max (p[1][1], p[2][1]));
+        double zmin = std::min (p[0][2], std::min (p[1][2], p[2][2]));
+        double zmax = std::max (p[0][2], std::max (p[1][2], p[2][2]));
+        
+        if (pz < zmin || pz > zmax)
+        {
+            return;
+        }
+        
+        int ny = grid_m.dims[1];
+        int nsub = (int)offset_m.size ();
+        
+        for (int q = 0; q < nsub; q++)
+        {
+            int jfirst = std::max (0, row_index (ymin, 1, offset_m[q]));
+            int jlast = std::min (ny - 1, row_index (ymax, 1, offset_m[q]) + 1);
+            
+            for (int j = jfirst; j <= jlast; j++)
+            {
+                double py = sample (j, 1, offset_m[q]);
+                double x;
+                
+                if (py >= ymin && py <= ymax && crossing (p, py, pz, x))
+                {
+                    rows[j*nsub + q].push_back (x);
+                }
+            }
+        }
+    }
+    
+    // whether the row through (py, pz) crosses the triangle p, and where
+    bool crossing (const double * const *p, double py, double pz, double &x) const
+    {
+        // e[i] is the edge function of the edge opposite vertex i
+        double e[3];
+        int npos = 0;
+        int nneg = 0;
+        
+        for (int i = 0; i < 3; i++)
+        {
+            e[i] = edge_function (p[(i+1)%3], p[(i+2)%3], py, pz);
+            
+            npos += (e[i] > 0.0);
+            nneg += (e[i] < 0.0);
+        }
+        
+        // outside, or a triangle seen edge on
+        if ((npos > 0 && nneg > 0) || npos + nneg == 0)
+        {
+            return false;
+        }
+        
+        double sign = (npos > 0) ? 1.0 : -1.0;
+        
+        for (int i = 0; i < 3; i++)
+        {
+            if (e[i] == 0.0)
+            {
+                const double *u = p[(i+1)%3];
+                const double *v = p[(i+2)%3];
+                
+                if (!owns_edge (sign * (v[1] - u[1]), sign * (v[2] - u[2])))
+                {
+                    return false;
+                }
+            }
+        }
+        
+        x = (e[0] * p[0][0] + e[1] * p[1][0] + e[2] * p[2][0]) / (e[0] + e[1] + e[2]);
+        
+        return true;
+    }
+    
+    // fill the voxels of a row between each pair of crossings
+    void fill_row (std::vector<double> &crossings, float *values) const
+    {
+        int nx = grid_m.dims[0];
+        double ox = grid_m.origin[0];
+        double dx = grid_m.spacing[0];
+        
+        std::sort (crossings.begin (), crossings.end ());
+        
+        for (size_t c = 0; c + 1 < crossings.size (); c += 2)
+        {
+            // the crossings in units of voxels
+            double lo = (crossings[c] - ox) / dx;
+            double hi = (crossings[c+1] - ox) / dx;
+            
+            if (grid_m.supersample == 0)
+            {
+                // the voxels whose centres are in [lo, hi)
+                int first = std::max (0.0, std::ceil (lo - 0.5));
+                int last = std::min ((double)nx, std::ceil (hi - 0.5));
+                
+                for (int i = first; i < last; i++)
+                {
+                    values[i] = 1.0f;
+                }
+            }
+            else
+            {
+                int first = std::max (0.0, std::floor (lo));
+                int last = std::min ((double)nx, std::ceil (hi));
+                
+                for (int i = first; i < last; i++)
+                {
+                    double overlap = std::min (hi, i + 1.0) - std::max (lo, (double)i);
+                    
+                    if (overlap > 0.0)
+                    {
+                        values[i] += (float)overlap;
+                    }
+                }
+            }
+        }
+    }
+    
+    const mesh_data &mesh_m;
+    const voxel_grid &grid_m;
+    
+    std::vector<double> offset_m;
+    // the triangles which may cross the rows of each layer
+    std::vector<int> bin_start_m;
+    std::vector<int> bin_tris_m;
+    
+};
+
+void check_grid (const mesh_data &mesh, const voxel_grid &grid)
+{
+    if (!mesh.is_triangulated ())
+    {
+        throw std::invalid_argument ("The mesh must be triangulated to be voxelized.");
+    }
+    
+    for (int d = 0; d < 3; d++)
+    {
+        if (grid.dims[d] < 0)
+        {
+            throw std::invalid_argument ("The grid dimensions must not be negative.");
+        }
+        
+        if (!(grid.spacing[d] > 0.0) || !std::isfinite (grid.spacing[d]) || !std::isfinite (grid.origin[d]))
+        {
+            throw std::invalid_argument ("The grid spacing must be positive and the origin finite.");
+        }
+    }
+    
+    if (grid.supersample < 0)
+    {
+        throw std::invalid_argument ("The supersampling must not be negative.");
+    }
+}
+
+// rasterise the grid in slabs of slab_layers layers, passing each to fcn
+// (slab, values) on one of the threads, the slabs are shared between the
+// threads in turn so each has some of the dense and sparse regions
+void for_each_slab (const mesh_data &mesh, const voxel_grid &grid, int slab_layers, int num_threads,
+                    const std::function<void (int slab, const float *values)> &fcn)
+{
+    layer_rasteriser rasteriser (mesh, grid);
+    
+    long layer_size = (long)grid.dims[0] * grid.dims[1];
+    int nslabs = (grid.dims[2] + slab_layers - 1) / slab_layers;
+    
+    int nchunks = std::min (nslabs, num_work_chunks (grid.num_voxels (), MIN_CHUNK_VOXELS, num_threads));
+    
+    parallel_for_chunks (nchunks, [&] (int c)
+    {
+        std::vector<float> values (layer_size * slab_layers);
+        std::vector< std::vector<double> > rows;
+        
+        for (int s = c; s < nslabs; s += nchunks)
+        {
+            int first = s * slab_layers;
+            int last = std::min (grid.dims[2], first + slab_layers);
+            
+            std::fill (values.begin () + layer_size * (last - first), values.end (), 0.0f);
+            
+            for (int k = first; k < last; k++)
+            {
+                rasteriser.rasterise (k, &values[layer_size * (k - first)], rows);
+            }
+            
+            fcn (s, &values[0]);
+        }
+    });
+}
+
+} // anonymous namespace
+
+void voxelize (const mesh_data &mesh, const voxel_grid &grid, float *values, int num_threads)
+{
+    check_grid (mesh, grid);
+    
+    scoped_timer timer ("voxelize.dense");
+    timer.set_faces_in (mesh.num_faces ());
+    
+    long layer_size = (long)grid.dims[0] * grid.dims[1];
+    
+    for_each_slab (mesh, grid, 1, num_threads, [&] (int k, const float *layer)
+    {
+        std::copy (layer, layer + layer_size, values + layer_size * k);
+    });
+}
+
+void voxelize (const mesh_data &mesh, const voxel_grid &grid, bool *occupied, int num_threads)
+{
+    check_grid (mesh, grid);
+    
+    scoped_timer timer ("voxelize.dense");
+    timer.set_faces_in (mesh.num_faces ());
+    
+    long layer_size = (long)grid.dims[0] * grid.dims[1];
+    
+    for_each_slab (mesh, grid, 1, num_threads, [&] (int k, const float *layer)
+    {
+        bool *out = occupied + layer_size * k;
+        
+        for (long i = 0; i < layer_size; i++)
+        {
+            out[i] = (layer[i] >= 0.5f);
+        }
+    });
+}
+
+void voxelize_sparse (const mesh_data &mesh, const voxel_grid &grid, int block_size,
+                      sparse_voxels &voxels, int num_threads)
+{
+    check_grid (mesh, grid);
+    
+    if (block_size < 1)
+    {
+        throw std::invalid_argument ("The block size must be positive.");
+    }
+    
+    scoped_timer timer ("voxelize.sparse");
+    timer.set_faces_in (mesh.num_faces ());
+    
+    int bs = block_size;
+    
+    voxels.block_size = bs;
+    
+    for (int d = 0; d < 3; d++)
+    {
+        voxels.block_dims[d] = (grid.dims[d] + bs - 1) / bs;
+    }
+    
+    int nbx = voxels.block_dims[0];
+    int nby = voxels.block_dims[1];
+    int nx = grid.dims[0];
+    int ny = grid.dims[1];
+    
+    // the blocks found in each slab, gathered in order at the end
+    std::vector< std::vector<int> > full (voxels.block_dims[2]);
+    std::vector< std::vector<int> > partial (voxels.block_dims[2]);
+    std::vector< std::vector<float> > values (voxels.block_dims[2]);
+    
+    for_each_slab (mesh, grid, bs, num_threads, [&] (int bz, const float *slab)
+    {
+        std::vector<float> block (bs * bs * bs);
+        
+        for (int by = 0; by < nby; by++)
+        {
+            for (int bx = 0; bx < nbx; bx++)
+            {
+                bool any = false;
+                bool all = true;
+                
+                // copy the block, zero beyond the grid, the slab itself is
+                // zero beyond the last layer
+                for (int k = 0; k < bs; k++)
+                {
+                    for (int j = 0; j < bs; j++)
+                    {
+                        for (int i = 0; i < bs; i++)
+                        {
+                            int x = bx * bs + i;
+                            int y = by * bs + j;
+                            float v = (x < nx && y < ny) ? slab[((long)k * ny + y) * nx + x] : 0.0f;
+                            
+                            block[(k * bs + j) * bs + i] = v;
+                            any = any || (v > 0.0f);
+                            all = all && (v >= 1.0f);
+                        }
+                    }
+                }
+                
+                int index[3] = { bx, by, bz };
+                
+                if (all)
+                {
+                    full[bz].insert (full[bz].end (), index, index + 3);
+                }
+                else if (any)
+                {
+                    partial[bz].insert (partial[bz].end (), index, index + 3);
+                    values[bz].insert (values[bz].end (), block.begin (), block.end ());
+                }
+            }
+        }
+    });
+    
+    voxels.full_blocks.clear ();
+    voxels.partial_blocks.clear ();
+    voxels.values.clear ();
+    
+    for (int bz = 0; bz < voxels.block_dims[2]; bz++)
+    {
+        voxels.full_blocks.insert (voxels.full_blocks.end (), full[bz].begin (), full[bz].end ());
+        voxels.partial_blocks.insert (voxels.partial_blocks.end (), partial[bz].begin (), partial[bz].end ());
+        voxels.values.insert (voxels.values.end (), values[bz].begin (), values[bz].end ());
+    }
+}
+
+} // namespace mpolycsg
@@ -0,0 +1,94 @@
+/*
+   voxelize.hpp
+   
+   Rasterisation of a closed mesh onto a regular grid of voxels, as dense
+   arrays or as sparse blocks
+
+*/
+
+#ifndef __VOXELIZE_HPP__
+#define __VOXELIZE_HPP__
+
+#include <vector>
+
+#include "mesh_data.hpp"
+
+namespace mpolycsg {
+
+// A regular grid of dims[0] x dims[1] x dims[2] voxels, voxel (i, j, k)
+// is the box from origin + (i, j, k) * spacing to origin + (i+1, j+1, k+1)
+// * spacing. Values for the grid are stored with i varying fastest, then j.
+class voxel_grid
+{
+public:
+    
+    voxel_grid () : supersample(0)
+    {
+        for (int d = 0; d < 3; d++)
+        {
+            origin[d] = 0.0;
+            spacing[d] = 1.0;
+            dims[d] = 0;
+        }
+    }
+    
+    long num_voxels () const { return (long)dims[0] * dims[1] * dims[2]; }
+    
+    double origin[3];
+    double spacing[3];
+    int dims[3];
+    // zero to sample only the centre of each voxel, giving an occupancy of
+    // 0 or 1, otherwise the volume fraction of each voxel is estimated from
+    // supersample x supersample rows through it parallel to x, each of
+    // which is measured exactly
+    int supersample;
+    
+};
+
+// The voxels of a grid with any part inside, in blocks of block_size^3
+// voxels. Blocks with every voxel entirely inside are only listed, blocks
+// with no part inside are omitted.
+class sparse_voxels
+{
+public:
+    
+    sparse_voxels () : block_size(0)
+    {
+        block_dims[0] = block_dims[1] = block_dims[2] = 0;
+    }
+    
+    int block_size;
+    // number of blocks along each axis
+    int block_dims[3];
+    // x, y, z block indices of the blocks entirely inside
+    std::vector<int> full_blocks;
+    // x, y, z block indices of the other blocks with any part inside, and
+    // their values, block_size^3 for each, x fastest, zero beyond the grid
+    std::vector<int> partial_blocks;
+    std::vector<float> values;
+    
+};
+
+// Rasterise a triangle mesh onto a grid, by casting rows of rays parallel
+// to x through the voxels and filling between pairs of crossings of the
+// surface, which should be closed. A ray passing exactly through an edge
+// or vertex is counted as crossing exactly one of the triangles there.
+// The layers of voxels in z are split between up to num_threads threads,
+// zero for the default, the results do not depend on the number used.
+// values must have room for grid.num_voxels () values, each set to the
+// fraction of the voxel inside the mesh. Throws std::invalid_argument if
+// the mesh is not triangulated or the grid is invalid.
+void voxelize (const mesh_data &mesh, const voxel_grid &grid, float *values, int num_threads=0);
+
+// As above but sets each voxel to whether it is at least half inside, or
+// when grid.supersample is zero, whether its centre is inside.
+void voxelize (const mesh_data &mesh, const voxel_grid &grid, bool *occupied, int num_threads=0);
+
+// As above but only storing the voxels near the surface, so very fine
+// grids can be used, rasterising a layer of blocks at a time.
+void voxelize_sparse (const mesh_data &mesh, const voxel_grid &grid, int block_size,
+                      sparse_voxels &voxels, int num_threads=0);
+
+} // namespace mpolycsg
+
+#endif // __VOXELIZE_HPP__
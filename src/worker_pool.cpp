@@ -0,0 +1,892 @@
+/*
+   worker_pool.cpp
+   
+   A pool of local worker processes running boolean operations of the CSG
+   kernel
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+#include "csg_error.hpp"
+#include "parallel.hpp"
+#include "polyhedron_engine.hpp"
+#include "progress.hpp"
+#include "serialize.hpp"
+#include "worker_pool.hpp"
+
+namespace mpolycsg {
+
+namespace {
+
+std::mutex pool_mutex;
+
+int the_worker_count = 0;
+
+std::string the_worker_path;
+
+double the_worker_timeout = 3600.0;
+
+} // anonymous namespace
+
+void set_worker_count (int count)
+{
+    {
+        std::lock_guard<std::mutex> lock (pool_mutex);
+        the_worker_count = std::max (1, count);
+    }
+    
+    stop_workers ();
+}
+
+int worker_count ()
+{
+    std::lock_guard<std::mutex> lock (pool_mutex);
+    
+    return (the_worker_count > 0) ? the_worker_count : default_num_threads ();
+}
+
+void set_worker_path (const std::string &path)
+{
+    std::lock_guard<std::mutex> lock (pool_mutex);
+    the_worker_path = path;
+}
+
+void set_worker_timeout (double seconds)
+{
+    if (!(seconds >= 0))
+    {
+        throw std::invalid_argument ("The worker timeout must be zero or a positive number of seconds.");
+    }
+    
+    std::lock_guard<std::mutex> lock (pool_mutex);
+    the_worker_timeout = seconds;
+}
+
+double worker_timeout ()
+{
+    std::lock_guard<std::mutex> lock (pool_mutex);
+    return the_worker_timeout;
+}
+
+#ifdef _WIN32
+
+std::string worker_path ()
+{
+    std::lock_guard<std::mutex> lock (pool_mutex);
+    return the_worker_path;
+}
+
+void run_worker_jobs (std::vector<worker_job> &jobs, progress_token *progress, const char *operation)
+{
+    if (!jobs.empty ())
+    {
+        throw std::runtime_error ("Worker processes are not supported on this platform.");
+    }
+}
+
+void stop_workers ()
+{
+}
+
+int worker_main (int fd)
+{
+    return 1;
+}
+
+#else
+
+namespace {
+
+const uint32_t JOB_MAGIC = 0x4a57504d;   // "MPWJ"
+const uint32_t REPLY_MAGIC = 0x5257504d; // "MPWR"
+
+const uint32_t REPLY_OK = 0;
+const uint32_t REPLY_FAILED = 1;
+
+// the messages are only exchanged between processes on the same machine,
+// so use its own byte order
+struct job_header
+{
+    uint32_t magic;
+    uint32_t op;
+    uint32_t backend;
+    uint32_t reserved;
+    uint64_t size_a;
+    uint64_t size_b;
+    // the parent's snap_tolerance (), for backend_robust
+    double snap_tolerance;
+};
+
+// followed by text_size bytes, the name of the shared memory object holding
+// size bytes of the result, or the error message
+struct reply_header
+{
+    uint32_t magic;
+    uint32_t status;
+    uint64_t size;
+    uint64_t text_size;
+};
+
+// send or receive exactly size bytes, returning false if the other end has
+// gone. Sending never raises SIGPIPE.
+bool send_all (int fd, const void *data, size_t size)
+{
+    const char *p = (const char*)data;
+    
+    while (size > 0)
+    {
+        ssize_t n = send (fd, p, size, MSG_NOSIGNAL);
+        
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        
+        if (n <= 0)
+        {
+            return false;
+        }
+        
+        p += n;
+        size -= n;
+    }
+    
+    return true;
+}
+
+bool recv_all (int fd, void *data, size_t size)
+{
+    char *p = (char*)data;
+    
+    while (size > 0)
+    {
+        ssize_t n = recv (fd, p, size, 0);
+        
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        
+        if (n <= 0)
+        {
+            return false;
+        }
+        
+        p += n;
+        size -= n;
+    }
+    
+    return true;
+}
+
+// the longest the parent waits on a worker's socket before checking again
+// whether the jobs were cancelled
+const int POLL_SLICE_MS = 50;
+
+enum transfer_status
+{
+    transfer_ok,
+    transfer_closed,
+    transfer_cancelled,
+    transfer_timed_out
+};
+
+// when the parent stops waiting for a worker, deadline is in seconds of 
+// the steady clock, or infinite
+struct transfer_limits
+{
+    double deadline;
+    const std::atomic<bool> *cancelled;
+};
+
+double steady_seconds ()
+{
+    return std::chrono::duration<double> (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+// send or receive exactly size bytes in the parent, waiting with poll so
+// that the limits are checked while the worker is busy. done is set to the
+// number of bytes transferred.
+transfer_status transfer (int fd, void *data, size_t size, bool sending, 
+                          const transfer_limits &limits, size_t &done)
+{
+    char *p = (char*)data;
+    done = 0;
+    
+    while (done < size)
+    {
+        if (limits.cancelled->load ())
+        {
+            return transfer_cancelled;
+        }
+        
+        double left = limits.deadline - steady_seconds ();
+        
+        if (left <= 0)
+        {
+            return transfer_timed_out;
+        }
+        
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = sending ? POLLOUT : POLLIN;
+        pfd.revents = 0;
+        
+        int n = poll (&pfd, 1, (int)std::min (left * 1000.0 + 1.0, (double)POLL_SLICE_MS));
+        
+        if (n < 0 && errno != EINTR)
+        {
+            return transfer_closed;
+        }
+        
+        if (n <= 0)
+        {
+            continue;
+        }
+        
+        ssize_t m = sending ? send (fd, p + done, size - done, MSG_NOSIGNAL | MSG_DONTWAIT)
+                            : recv (fd, p + done, size - done, MSG_DONTWAIT);
+        
+        if (m < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            continue;
+        }
+        
+        if (m <= 0)
+        {
+            return transfer_closed;
+        }
+        
+        done += m;
+    }
+    
+    return transfer_ok;
+}
+
+// a running worker process and the parent's end of its socket
+class worker_process
+{
+public:
+    
+    worker_process (pid_t pid, int fd) : pid_m(pid), fd_m(fd) {}
+    
+    // closing the socket tells an idle worker to exit
+    ~worker_process ()
+    {
+        if (fd_m >= 0)
+        {
+            close (fd_m);
+        }
+        
+        if (pid_m > 0)
+        {
+            int status;
+            while (waitpid (pid_m, &status, 0) < 0 && errno == EINTR) {}
+        }
+    }
+    
+    bool alive () const { return pid_m > 0; }
+    
+    int fd () const { return fd_m; }
+    
+    // reap the process after its socket has failed, returning why it died
+    std::string reap ()
+    {
+        close (fd_m);
+        fd_m = -1;
+        
+        int status = 0;
+        pid_t pid = pid_m;
+        pid_m = -1;
+        
+        // the socket may fail just before the process exits
+        if (waitpid (pid, &status, 0) < 0)
+        {
+            return "The worker process was lost.";
+        }
+        
+        if (WIFSIGNALED (status))
+        {
+            return std::string ("The worker process was killed by signal ") + std::to_string (WTERMSIG (status))
+                + " (" + strsignal (WTERMSIG (status)) + ").";
+        }
+        
+        return "The worker process exited unexpectedly with status " + std::to_string (WEXITSTATUS (status)) + ".";
+    }
+    
+    // kill a worker which is no longer wanted, e.g. in the middle of a job
+    // which was cancelled
+    void kill ()
+    {
+        ::kill (pid_m, SIGKILL);
+        reap ();
+    }
+    
+private:
+    
+    worker_process (const worker_process&) = delete;
+    worker_process& operator= (const worker_process&) = delete;
+    
+    pid_t pid_m;
+    int fd_m;
+    
+};
+
+typedef std::unique_ptr<worker_process> worker_ptr;
+
+// the workers waiting for jobs
+std::vector<worker_ptr> idle_workers;
+
+// the directory of the library or executable containing this code
+std::string engine_directory ()
+{
+    Dl_info info;
+    
+    if (dladdr ((void*)&engine_directory, &info) == 0 || info.dli_fname == NULL)
+    {
+        return ".";
+    }
+    
+    std::string file (info.dli_fname);
+    size_t slash = file.find_last_of ('/');
+    
+    return (slash == std::string::npos) ? "." : file.substr (0, slash);
+}
+
+// Workers may be started from several threads at once. A worker which
+// inherited the parent's end of another worker's socket would keep that
+// socket open, so the other worker would never see it closed and never
+// exit. The sockets are created close-on-exec where the system allows,
+// and the workers are started one at a time, so where it does not no
+// other socket is open without the flag while a worker is spawned.
+std::mutex spawn_mutex;
+
+worker_ptr start_worker ()
+{
+    std::string path = worker_path ();
+    
+    std::lock_guard<std::mutex> lock (spawn_mutex);
+    
+    int fds[2];
+
+#ifdef SOCK_CLOEXEC
+    int type = SOCK_STREAM | SOCK_CLOEXEC;
+#else
+    int type = SOCK_STREAM;
+#endif
+    
+    if (socketpair (AF_UNIX, type, 0, fds) != 0)
+    {
+        throw std::runtime_error (std::string ("Could not create a socket for a worker process: ") + strerror (errno));
+    }
+    
+    // only the worker's end is inherited, on its standard input
+    fcntl (fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl (fds[1], F_SETFD, FD_CLOEXEC);
+    
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init (&actions);
+    posix_spawn_file_actions_adddup2 (&actions, fds[1], 0);
+    
+    std::vector<char> arg0 (path.begin (), path.end ());
+    arg0.push_back ('\0');
+    char *argv[] = { &arg0[0], NULL };
+    
+    pid_t pid;
+    int err = posix_spawn (&pid, path.c_str (), &actions, NULL, argv, environ);
+    
+    posix_spawn_file_actions_destroy (&actions);
+    close (fds[1]);
+    
+    if (err != 0)
+    {
+        close (fds[0]);
+        throw std::runtime_error ("Could not start the worker process " + path + ": " + strerror (err));
+    }
+    
+    return worker_ptr (new worker_process (pid, fds[0]));
+}
+
+worker_ptr checkout_worker ()
+{
+    {
+        std::lock_guard<std::mutex> lock (pool_mutex);
+        
+        if (!idle_workers.empty ())
+        {
+            worker_ptr worker (std::move (idle_workers.back ()));
+            idle_workers.pop_back ();
+            
+            return worker;
+        }
+    }
+    
+    return start_worker ();
+}
+
+void checkin_worker (worker_ptr worker)
+{
+    if (!worker || !worker->alive ())
+    {
+        return;
+    }
+    
+    int count = worker_count ();
+    
+    std::lock_guard<std::mutex> lock (pool_mutex);
+    
+    if ((int)idle_workers.size () < count)
+    {
+        idle_workers.push_back (std::move (worker));
+    }
+}
+
+// map the shared memory object holding a result, and decode it in place
+void read_result (const std::string &name, size_t size, mesh_data &result)
+{
+    int fd = shm_open (name.c_str (), O_RDONLY, 0);
+    
+    if (fd < 0)
+    {
+        throw std::runtime_error ("Could not open the result of the worker process.");
+    }
+    
+    // the name is no longer needed, the memory is freed once unmapped
+    shm_unlink (name.c_str ());
+    
+    void *data = mmap (NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error ("Could not map the result of the worker process.");
+    }
+    
+    try
+    {
+        deserialize_mesh ((const unsigned char*)data, size, result);
+    }
+    catch (...)
+    {
+        munmap (data, size);
+        throw;
+    }
+    
+    munmap (data, size);
+}
+
+// write a result to a new shared memory object
+void write_result (const std::string &name, const std::vector<unsigned char> &blob)
+{
+    int fd = shm_open (name.c_str (), O_RDWR | O_CREAT | O_EXCL, 0600);
+    
+    if (fd < 0)
+    {
+        throw std::runtime_error (std::string ("Could not create shared memory for the result: ") + strerror (errno));
+    }
+    
+    void *data = MAP_FAILED;
+    
+    if (ftruncate (fd, blob.size ()) == 0)
+    {
+        data = mmap (NULL, blob.size (), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    
+    close (fd);
+    
+    if (data == MAP_FAILED)
+    {
+        shm_unlink (name.c_str ());
+        throw std::runtime_error ("Could not map shared memory for the result.");
+    }
+    
+    std::memcpy (data, &blob[0], blob.size ());
+    munmap (data, blob.size ());
+}
+
+// send a job to a worker and wait for the reply. Returns transfer_closed
+// with nothing received if the worker died before replying.
+transfer_status exchange (worker_process &worker, const job_header &header, 
+                          const std::vector<unsigned char> &blob_a, const std::vector<unsigned char> &blob_b, 
+                          const transfer_limits &limits, reply_header &reply, std::string &text, size_t &received)
+{
+    size_t done;
+    received = 0;
+    
+    transfer_status status = transfer (worker.fd (), (void*)&header, sizeof (header), true, limits, done);
+    
+    if (status == transfer_ok)
+    {
+        status = transfer (worker.fd (), (void*)blob_a.data (), blob_a.size (), true, limits, done);
+    }
+    
+    if (status == transfer_ok)
+    {
+        status = transfer (worker.fd (), (void*)blob_b.data (), blob_b.size (), true, limits, done);
+    }
+    
+    if (status != transfer_ok)
+    {
+        return status;
+    }
+    
+    status = transfer (worker.fd (), &reply, sizeof (reply), false, limits, received);
+    
+    if (status != transfer_ok)
+    {
+        return status;
+    }
+    
+    if (reply.magic != REPLY_MAGIC)
+    {
+        return transfer_closed;
+    }
+    
+    text.resize (reply.text_size);
+    
+    return transfer (worker.fd (), &text[0], text.size (), false, limits, done);
+}
+
+// run one job on a worker. A worker which died before replying, e.g. one 
+// which was idle and has since been killed, is replaced and the job sent 
+// again, once. A worker which dies after that, or which is stopped because
+// the job was cancelled or took too long, is left dead.
+void run_job (worker_ptr &worker, worker_job &job, const std::atomic<bool> &cancelled)
+{
+    std::vector<unsigned char> blob_a, blob_b;
+    serialize_mesh (*job.a, blob_a);
+    serialize_mesh (*job.b, blob_b);
+    
+    job_header header;
+    header.magic = JOB_MAGIC;
+    header.op = job.op;
+    header.backend = job.backend;
+    header.reserved = 0;
+    header.size_a = blob_a.size ();
+    header.size_b = blob_b.size ();
+    header.snap_tolerance = snap_tolerance ();
+    
+    double timeout = worker_timeout ();
+    
+    transfer_limits limits;
+    limits.deadline = (timeout > 0) ? steady_seconds () + timeout : HUGE_VAL;
+    limits.cancelled = &cancelled;
+    
+    reply_header reply;
+    std::string text;
+    size_t received = 0;
+    transfer_status status = transfer_closed;
+    
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (!worker->alive ())
+        {
+            worker = start_worker ();
+        }
+        
+        status = exchange (*worker, header, blob_a, blob_b, limits, reply, text, received);
+        
+        if (status != transfer_closed || received > 0)
+        {
+            break;
+        }
+        
+        job.error = worker->reap ();
+    }
+    
+    job.failed = true;
+    
+    switch (status)
+    {
+        case transfer_ok:
+            break;
+        
+        case transfer_closed:
+            if (worker->alive ())
+            {
+                job.error = worker->reap ();
+            }
+            return;
+        
+        case transfer_cancelled:
+            worker->kill ();
+            job.error = "The job was cancelled.";
+            return;
+        
+        case transfer_timed_out:
+            worker->kill ();
+            char seconds[32];
+            snprintf (seconds, sizeof (seconds), "%g", timeout);
+            job.error = std::string ("The worker process did not finish within ") + seconds + " seconds and was stopped.";
+            return;
+    }
+    
+    if (reply.status != REPLY_OK)
+    {
+        job.error = text;
+        return;
+    }
+    
+    try
+    {
+        read_result (text, reply.size, job.result);
+        job.failed = false;
+    }
+    catch (std::exception &e)
+    {
+        job.error = e.what ();
+    }
+}
+
+} // anonymous namespace
+
+std::string worker_path ()
+{
+    {
+        std::lock_guard<std::mutex> lock (pool_mutex);
+        
+        if (!the_worker_path.empty ())
+        {
+            return the_worker_path;
+        }
+    }
+    
+    const char *env = getenv ("MPOLYCSG_WORKER");
+    
+    if (env != NULL && env[0] != '\0')
+    {
+        return env;
+    }
+    
+    return engine_directory () + "/mpolycsg_worker";
+}
+
+void run_worker_jobs (std::vector<worker_job> &jobs, progress_token *progress, const char *operation)
+{
+    int nworkers = std::min ((int)jobs.size (), worker_count ());
+    
+    if (nworkers == 0)
+    {
+        return;
+    }
+    
+    std::vector<worker_ptr> workers (nworkers);
+    
+    // each worker takes the next job as soon as it is free, until there are
+    // none left or the jobs are cancelled
+    std::atomic<size_t> next (0);
+    std::atomic<bool> cancelled (false);
+    
+    std::mutex mutex;
+    std::condition_variable finished;
+    int nfinished = 0;
+    
+    // with a token the calling thread polls it while the others run the 
+    // jobs
+    int nchunks = (progress != NULL) ? nworkers + 1 : nworkers;
+    
+    try
+    {
+        parallel_for_chunks (nchunks, [&] (int c)
+        {
+            if (c == nworkers)
+            {
+                std::unique_lock<std::mutex> lock (mutex);
+                
+                while (nfinished < nworkers)
+                {
+                    finished.wait_for (lock, std::chrono::duration<double> (progress->poll_interval ()));
+                    
+                    if (nfinished == nworkers)
+                    {
+                        break;
+                    }
+                    
+                    lock.unlock ();
+                    
+                    try
+                    {
+                        progress->poll (operation);
+                    }
+                    catch (...)
+                    {
+                        cancelled = true;
+                        throw;
+                    }
+                    
+                    lock.lock ();
+                }
+                
+                return;
+            }
+            
+            try
+            {
+                workers[c] = checkout_worker ();
+                
+                for (size_t j = next++; j < jobs.size () && !cancelled; j = next++)
+                {
+                    run_job (workers[c], jobs[j], cancelled);
+                }
+            }
+            catch (...)
+            {
+                // no other job is started, and the others are stopped
+                cancelled = true;
+                
+                std::lock_guard<std::mutex> lock (mutex);
+                nfinished++;
+                finished.notify_all ();
+                
+                throw;
+            }
+            
+            std::lock_guard<std::mutex> lock (mutex);
+            nfinished++;
+            finished.notify_all ();
+        });
+    }
+    catch (...)
+    {
+        for (int i = 0; i < nworkers; i++)
+        {
+            checkin_worker (std::move (workers[i]));
+        }
+        
+        throw;
+    }
+    
+    for (int i = 0; i < nworkers; i++)
+    {
+        checkin_worker (std::move (workers[i]));
+    }
+}
+
+void stop_workers ()
+{
+    std::vector<worker_ptr> stopping;
+    
+    {
+        std::lock_guard<std::mutex> lock (pool_mutex);
+        stopping.swap (idle_workers);
+    }
+    
+    // the workers are waited for as they are destroyed here
+}
+
+int worker_main (int fd)
+{
+    long nresults = 0;
+    
+    for (;;)
+    {
+        job_header header;
+        
+        // the parent has closed the socket, or died
+        if (!recv_all (fd, &header, sizeof (header)))
+        {
+            return 0;
+        }
+        
+        if (header.magic != JOB_MAGIC)
+        {
+            return 1;
+        }
+        
+        std::vector<unsigned char> blob_a (header.size_a), blob_b (header.size_b);
+        
+        if (!recv_all (fd, blob_a.data (), blob_a.size ()) || !recv_all (fd, blob_b.data (), blob_b.size ()))
+        {
+            return 1;
+        }
+        
+        reply_header reply;
+        reply.magic = REPLY_MAGIC;
+        reply.size = 0;
+        
+        std::string text;
+        
+        try
+        {
+            polyhedron_engine a, b;
+            a.deserialize (blob_a.data (), blob_a.size ());
+            b.deserialize (blob_b.data (), blob_b.size ());
+            
+            set_snap_tolerance (header.snap_tolerance);
+            
+            // a worker never hands the job on to another
+            csg_backend backend = (csg_backend)header.backend;
+            
+            if (backend == backend_isolated)
+            {
+                backend = backend_auto;
+            }
+            
+            switch (header.op)
+            {
+                case boolean_union: a.csg_union (b, NULL, backend); break;
+                case boolean_difference: a.csg_difference (b, NULL, backend); break;
+                default: a.csg_symmetric_difference (b, NULL, backend); break;
+            }
+            
+            std::vector<unsigned char> result;
+            a.serialize (result);
+            
+            text = "/mpolycsg-" + std::to_string (getpid ()) + "-" + std::to_string (nresults++);
+            write_result (text, result);
+            
+            reply.status = REPLY_OK;
+            reply.size = result.size ();
+        }
+        catch (std::exception &e)
+        {
+            reply.status = REPLY_FAILED;
+            text = e.what ();
+        }
+        
+        reply.text_size = text.size ();
+        
+        if (!send_all (fd, &reply, sizeof (reply)) || !send_all (fd, text.data (), text.size ()))
+        {
+            // the parent will never read the result
+            if (reply.status == REPLY_OK)
+            {
+                shm_unlink (text.c_str ());
+            }
+            
+            return 1;
+        }
+    }
+}
+
+#endif // _WIN32
+
+} // namespace mpolycsg
@@ -0,0 +1,105 @@
+/*
+   worker_pool.hpp
+   
+   A pool of local worker processes running boolean operations of the CSG
+   kernel, so a crash of the kernel only ends a worker, and independent
+   operations can run in parallel without sharing the kernel between
+   threads
+   
+   The workers run the mpolycsg_worker executable, which is built from the
+   same engine code. Each is connected to the parent by a Unix socket pair
+   on its standard input. A job is sent over the socket as a header giving
+   the operation, the backend the worker should use and the sizes of the
+   operands, followed by the operands encoded with serialize_mesh. The
+   worker writes its result, again encoded with serialize_mesh, to a POSIX
+   shared memory object, and replies with its name and size, or with the
+   error message if the kernel failed. The parent decodes the result
+   directly from the mapped memory and unlinks the object.
+   
+   Worker processes are only supported on POSIX systems.
+
+*/
+
+#ifndef __WORKER_POOL_HPP__
+#define __WORKER_POOL_HPP__
+
+#include <string>
+#include <vector>
+
+#include "backend.hpp"
+#include "mesh_data.hpp"
+#include "progress.hpp"
+
+namespace mpolycsg {
+
+enum boolean_op
+{
+    boolean_union,
+    boolean_difference,
+    boolean_symmetric_difference
+};
+
+// A boolean operation to be run in a worker process, result = op (a, b).
+// backend is how the worker uses the kernel, backend_fast, backend_robust
+// or backend_auto.
+class worker_job
+{
+public:
+    
+    worker_job () : op(boolean_union), backend(backend_auto), a(NULL), b(NULL), failed(false) {}
+    
+    boolean_op op;
+    csg_backend backend;
+    const mesh_data *a;
+    const mesh_data *b;
+    
+    mesh_data result;
+    
+    // set if the kernel failed or the worker process died, with the reason
+    bool failed;
+    std::string error;
+    
+};
+
+// The number of worker processes kept running between jobs and used to run
+// jobs in parallel, initially default_num_threads (). Setting it stops
+// the idle workers, so any new worker path takes effect.
+void set_worker_count (int count);
+int worker_count ();
+
+// The worker executable. Initially the MPOLYCSG_WORKER environment
+// variable if set, otherwise mpolycsg_worker in the directory of the
+// library or mexfunction containing the engine.
+void set_worker_path (const std::string &path);
+std::string worker_path ();
+
+// The longest a worker is waited for on one job before it is killed and
+// the job marked as failed, in seconds, initially 3600. Zero waits for
+// ever. Throws std::invalid_argument if negative.
+void set_worker_timeout (double seconds);
+double worker_timeout ();
+
+// Run jobs in worker processes, up to worker_count () at a time, and wait
+// for them all. Workers are started when first needed and kept for later
+// jobs. A job which fails, including one whose worker dies or times out, 
+// is marked as failed and the other jobs are unaffected, a dead worker is
+// replaced when next needed. A job whose worker died before replying, 
+// e.g. an idle worker which was killed, is sent again to a new worker 
+// once. With a progress token the calling thread polls it for operation
+// while waiting, and if it is cancelled the busy workers are killed and 
+// the csg_error from the token is rethrown. Throws std::runtime_error if a
+// worker cannot be started.
+void run_worker_jobs (std::vector<worker_job> &jobs, progress_token *progress = NULL,
+                      const char *operation = "Worker operations");
+
+// stop all the idle worker processes
+void stop_workers ();
+
+// The loop run by a worker process, reading jobs from the socket fd and
+// replying until the parent closes it. Returns the exit status for the
+// process.
+int worker_main (int fd);
+
+} // namespace mpolycsg
+
+#endif // __WORKER_POOL_HPP__
@@ -243,3 +243,483 @@ hasDuplicates = size(u,1) < size(nodes,1)
 ixDupRows = setdiff(1:size(nodes,1), I)
 dupRowValues = nodes(ixDupRows,:)
 
+
+%% simplification
+
+p = csg.polyhedron;
+p.makesphere (1, 1, 100, 100);
+nfaces = p.num_faces ()
+
+p.simplify (500);
+nfaces = p.num_faces ()
+
+p.render ();
+
+p.makesphere (1, 1, 100, 100);
+p.simplify (10, 0.01);
+nfaces = p.num_faces ()
+
+%% shapes with segments chosen from a chordal tolerance
+
+p = csg.polyhedron;
+p.makesphere_tol (1, 1e-3);
+nfaces = p.num_faces ()
+
+p.makesphere_tol (0.01, 1e-3);
+nfaces = p.num_faces ()
+
+p.makecylinder_tol (0.5, 2, 1e-3);
+p.render ();
+
+%% serialization
+
+p = csg.polyhedron;
+p.makesphere (1, 1);
+
+blob = p.serialize ();
+
+p2 = csg.polyhedron;
+p2.deserialize (blob);
+isequal (p.get_vertices (), p2.get_vertices ())
+
+p.binwrite ('test.mpcs');
+p2.binread ('test.mpcs');
+isequal (p.get_vertices (), p2.get_vertices ())
+
+save ('test_polyhedron.mat', 'p');
+clear p;
+load ('test_polyhedron.mat');
+p.render ();
+
+%% copies share geometry until modified
+
+p = csg.polyhedron;
+p.makesphere (1, 1, 200, 200);
+
+p2 = csg.polyhedron (p);
+p2.translate ([2, 0, 0]);
+
+% p must be unchanged
+isequal (p.get_vertex (0), p2.get_vertex (0) - [2, 0, 0])
+
+
+%% operation statistics and tracing
+
+csg.polyhedron.reset_stats ();
+csg.polyhedron.trace (true);
+
+p = csg.polyhedron;
+p.makesphere (1, 1, 50, 50);
+p2 = csg.polyhedron;
+p2.makebox (1, 1, 1, 1);
+p.union (p2);
+
+s = csg.polyhedron.stats ();
+struct2table (s)
+
+csg.polyhedron.trace_dump ('test_trace.json');
+csg.polyhedron.trace (false);
+
+%% progress reporting of long operations
+
+csg.polyhedron.progress_interval (0.1);
+
+p = csg.polyhedron;
+p.makesphere (1, 1, 400, 400);
+p.simplify (1000);
+nfaces = p.num_faces ()
+
+csg.polyhedron.progress_interval (2);
+
+%% triangulation of large concave faces
+
+% star shaped profile, each cap is a single concave face
+n = 200;
+theta = linspace (0, 2*pi, 2*n+1)';
+theta(end) = [];
+r = repmat ([1; 0.4], n, 1);
+nodes = [r .* cos(theta), r .* sin(theta)];
+
+p = csg.polyhedron;
+p.make_extrusion (1, nodes);
+[fv.vertices, fv.faces] = p.triangulate ();
+
+% each cap gives 2n - 2 triangles, each side quad two
+size (fv.faces, 1) == 2 * (2*n - 2) + 2 * (2*n)
+
+p.render ();
+
+%% patch data for rendering
+
+p = csg.polyhedron;
+p.makesphere (1, 1, 200, 200);
+
+tic
+[f, v, n] = p.get_patch_data ();
+toc
+
+figure;
+patch ('Faces', f, 'Vertices', v, 'VertexNormals', n, ...
+       'FaceColor', 'r', 'EdgeColor', 'none', 'FaceLighting', 'gouraud');
+axis equal;
+view (3);
+light;
+
+tic
+p.render (true);
+toc
+
+%% extrusion of regions with holes
+
+theta = linspace (0, 2*pi, 33)';
+theta(end) = [];
+hole = 0.3 * [cos(theta), sin(theta)];
+
+% a plate with a grid of holes, one with an island in it, and a separate
+% profile
+loops = { [0, 0; 10, 0; 10, 10; 0, 10] };
+for x = 1.5:2.3:8.5
+    for y = 1.5:2.3:8.5
+        loops{end+1} = [hole(:,1) + x, hole(:,2) + y];
+    end
+end
+loops{end+1} = 0.5 * hole + 1.5;
+loops{end+1} = [12, 0; 14, 0; 14, 3; 12, 3];
+
+p = csg.polyhedron;
+p.make_extrusion_region (1, loops);
+p.render ();
+
+% the same, as a single matrix of loops separated by NaN
+nodes = cellfun (@(x) [x; nan, nan], loops, 'UniformOutput', false);
+p2 = csg.polyhedron;
+p2.make_extrusion_region (1, vertcat (nodes{:}));
+isequal (p.get_vertices (), p2.get_vertices ())
+
+%% sweeping a profile along a path
+
+theta = linspace (0, 2*pi, 33)';
+theta(end) = [];
+circle = [cos(theta), sin(theta)];
+
+% a tube wound into a helix
+t = linspace (0, 6*pi, 400)';
+helix = [cos(t), sin(t), 0.1 * t];
+
+p = csg.polyhedron;
+p.make_sweep ({0.2 * circle, 0.1 * circle}, helix);
+p.render ();
+
+% a square section ring on a closed path, and a path with sharp bends
+% keeping the sides of the square vertical at the start
+square = 0.1 * [-1, -1; 1, -1; 1, 1; -1, 1];
+
+p2 = csg.polyhedron;
+p2.make_sweep (square, [circle, zeros(size (circle, 1), 1); 1, 0, 0]);
+p2.render ();
+
+p3 = csg.polyhedron;
+p3.make_sweep (square, [0, 0, 0; 1, 0, 0; 1, 1, 0; 1, 1, 1], [0, 0, 1]);
+p3.render ();
+
+% on a closed path which is not planar the frame comes back rotated, the
+% twist which closes it is spread evenly, each segment turning the profile
+% by the same angle per unit length. The twist of a segment is the angle
+% between the first corner of the profile at either end, seen along it.
+n = 64;
+t = 2 * pi * (0:n)' / n;
+path = [cos(t) + 0.4 * cos(2*t), sin(t), 0.9 * sin(t) + 0.5 * cos(3*t + 0.3)];
+path(end,:) = path(1,:);
+
+p4 = csg.polyhedron;
+p4.make_sweep (square, path);
+v = p4.get_vertices ();
+corner = v(1:4:end,:);
+
+twist = zeros (n, 1);
+len = zeros (n, 1);
+for ind = 1:n
+    d = path(ind+1,:) - path(ind,:);
+    len(ind) = norm (d);
+    d = d / len(ind);
+    a = corner(ind,:) - path(ind,:);
+    b = corner(mod (ind, n) + 1,:) - path(ind+1,:);
+    a = a - dot (a, d) * d;
+    b = b - dot (b, d) * d;
+    twist(ind) = atan2 (dot (cross (a, b), d), dot (a, b));
+end
+
+rate = twist ./ len;
+[min(rate), max(rate)] * 180 / pi
+assert (max (rate) - min (rate) < 1e-6 * max (abs (rate)));
+
+%% splitting into connected components
+
+% cutting a bar with a box through its middle leaves two bodies
+a = csg.polyhedron;
+a.makebox (3, 1, 1, true);
+b = csg.polyhedron;
+b.makebox (1, 2, 2, true);
+a.difference (b);
+
+a.num_components ()
+parts = a.split_components ();
+numel (parts)
+cellfun (@(p) p.num_faces (), parts)
+parts{1}.render ();
+
+%% convex hulls
+
+% a capsule around two spheres
+a = csg.polyhedron;
+a.makesphere (0.5, true, 16, 16);
+b = csg.polyhedron (a);
+b.translate ([2, 0, 0]);
+
+c = csg.polyhedron;
+c.make_convex_hull (a, b);
+[tf, closed] = c.is_manifold ();
+assert (tf && closed);
+c.render ();
+
+% the hull of points on a grid is a box with six faces
+[x, y, z] = ndgrid (0:4, 0:4, 0:4);
+c.make_convex_hull ([x(:), y(:), z(:)]);
+assert (c.num_faces () == 6);
+assert (c.num_vertices () == 8);
+
+%% choice of boolean backend
+
+a = csg.polyhedron;
+a.makebox (1, 1, 1, true);
+b = csg.polyhedron;
+b.makebox (1, 1, 1, true);
+% exactly coincident faces, a difficult case for a floating point kernel
+b.translate ([0.5, 0, 0]);
+
+csg.polyhedron.reset_stats ();
+
+% every backend gives the same 1.5 x 1 x 1 box
+c = csg.polyhedron (a);
+c.union (b, 'robust');
+d = csg.polyhedron (a);
+d.union (b, 'fast');
+assert (c.approx_equal (d, 1e-9));
+
+previous = csg.polyhedron.set_backend ('auto')
+e = csg.polyhedron (a);
+e.union (b);
+assert (c.approx_equal (e, 1e-9));
+csg.polyhedron.set_backend (previous);
+
+s = csg.polyhedron.stats ();
+{s(strncmp ({s.name}, 'kernel.', 7)).name}
+
+% a coarser grid for the robust backend, merging vertices within about
+% 1e-6 of the size of the operands
+[previous, tolerance] = csg.polyhedron.set_backend ([], 1e-6)
+f = csg.polyhedron (a);
+f.union (b, 'robust');
+assert (c.approx_equal (f, 1e-5));
+csg.polyhedron.set_backend ([], tolerance);
+
+%% edges, face adjacency and manifold checks
+
+a = csg.polyhedron;
+a.makebox (1, 1, 1, true);
+
+% a box has 12 edges, each shared by two faces, and each face has four
+% neighbours
+[edges, nfaces] = a.get_edges ();
+assert (isequal (size (edges), [12, 2]));
+assert (all (nfaces == 2));
+neighbours = a.get_face_adjacency ()
+assert (isequal (size (neighbours), [6, 4]));
+[tf, closed] = a.is_manifold ();
+assert (tf && closed);
+
+report = a.quality_report ();
+assert (report.num_edges == 12);
+assert (report.num_boundary_edges == 0);
+assert (report.num_nonmanifold_edges == 0);
+assert (report.num_nonmanifold_vertices == 0);
+
+% two boxes touching along an edge share it between four faces, unless
+% the kernel splits it, either way the quality report agrees with the
+% manifold check
+b = csg.polyhedron (a);
+b.translate ([1, 1, 0]);
+a.union (b);
+[tf, closed] = a.is_manifold ()
+report = a.quality_report ()
+assert (tf == (report.num_nonmanifold_edges == 0 && report.num_nonmanifold_vertices == 0));
+assert (closed == (tf && report.num_boundary_edges == 0));
+
+%% voxelization
+
+a = csg.polyhedron;
+a.makesphere (1, true, 32, 32);
+
+% occupancy of the voxel centres, and volume fractions close to the 
+% volume of the faceted sphere
+occupied = a.voxelize ([-1, -1, -1], 0.05, [40, 40, 40]);
+class (occupied)
+size (occupied)
+frac = a.voxelize ([-1, -1, -1], 0.05, [40, 40, 40], 4);
+sum (frac(:)) * 0.05^3
+
+% the same grid in sparse blocks
+vox = a.voxelize ([-1, -1, -1], 0.05, [40, 40, 40], 0, 8)
+
+%% offsets and shells
+
+% an offset box is a larger box, with flat faces and sharp corners
+a = csg.polyhedron;
+a.makebox (1, 1, 1, true);
+a.offset (0.1);
+a.num_faces ()
+a.get_vertices ()
+
+% every face moves by the distance, so the extents of an offset box are
+% exact, and a box cannot be offset inwards by more than half its thickness
+a = csg.polyhedron;
+a.makebox (3, 2, 1, true);
+a.offset (-0.3);
+v = a.get_vertices ();
+assert (max (abs (max (v) - [1.2, 0.7, 0.2])) < 1e-12);
+assert (max (abs (min (v) + [1.2, 0.7, 0.2])) < 1e-12);
+
+a = csg.polyhedron;
+a.makebox (3, 2, 1, true);
+try
+    a.offset (-0.6);
+    error ('the offset should have failed');
+catch err
+    assert (strcmp (err.identifier, 'CSG:offset'));
+end
+
+% a hollow housing, the outer and inner walls are separate closed surfaces
+b = csg.polyhedron;
+b.makebox (3, 2, 1, true);
+b.shell (0.1);
+b.num_components ()
+[tf, closed] = b.is_manifold ()
+
+c = csg.polyhedron;
+c.makesphere (1, true, 32, 32);
+c.shell (0.2);
+c.render ();
+
+%% comparison
+
+% a faceted sphere deviates from a finer one by about its chord error
+a = csg.polyhedron;
+a.makesphere (1, true, 16, 16);
+b = csg.polyhedron;
+b.makesphere (1, true, 128, 128);
+[dmax, dmean, drms] = a.hausdorff (b)
+a.approx_equal (b, 2 * dmax)
+a.approx_equal (b, dmax / 2)
+
+% the comparison does not depend on how the faces are divided
+c = csg.polyhedron;
+c.makebox (1, 2, 3, true);
+d = csg.polyhedron (c);
+d.triangulate ();
+c.hausdorff (d, 1000)
+c.approx_equal (d, 1e-9)
+
+%% mesh quality
+
+% a box triangulates into right angled triangles, the poles of a sphere
+% give thin ones
+a = csg.polyhedron;
+a.makebox (1, 2, 3, true);
+report = a.quality_report ()
+
+b = csg.polyhedron;
+b.makesphere (1, true, 64, 8);
+report = b.quality_report (20, 15);
+[report.min_angle, report.max_aspect_ratio, report.num_slivers]
+bar (report.edge_bins(1:end-1), report.edge_counts, 'histc');
+
+%% multi-body export
+
+a = csg.polyhedron;
+a.makebox (1, 1, 1, true);
+b = csg.polyhedron;
+b.makesphere (0.5, true, 16, 16);
+
+% the sphere moved clear of the box as it is written
+T = repmat (eye (4), [1, 1, 2]);
+T(1:3,4,2) = [2; 0; 0];
+
+csg.polyhedron.export_bodies (fullfile (tempdir, 'assembly.stl'), {a, b}, T);
+csg.polyhedron.export_bodies (fullfile (tempdir, 'assembly.obj'), {a, b}, T, {'base', 'ball'});
+csg.polyhedron.export_bodies (fullfile (tempdir, 'assembly.ply'), {a, b});
+csg.polyhedron.export_bodies (fullfile (tempdir, 'assembly.txt'), {a, b}, [], {}, 'stl_ascii');
+
+% the polyhedra themselves are unchanged
+v = b.get_vertices ();
+v(1,:)
+
+%% assembly interference
+
+% a row of spheres, each overlapping the next, a box just touching the
+% last, and a small box inside the first
+parts = {};
+for ind = 1:5
+    parts{ind} = csg.polyhedron;
+    parts{ind}.makesphere (0.6, true, 32, 32);
+    parts{ind}.translate ([ind, 0, 0]);
+end
+
+parts{6} = csg.polyhedron;
+parts{6}.makebox (1, 1, 1, true);
+parts{6}.translate ([6.1, 0, 0]);
+
+parts{7} = csg.polyhedron;
+parts{7}.makebox (0.2, 0.2, 0.2, true);
+parts{7}.translate ([1, 0, 0]);
+
+pairs = csg.polyhedron.interference (parts)
+[pairs, volumes, contained] = csg.polyhedron.interference (parts, 32)
+
+% boxes sitting flush with each other overlap, with a volume of 4, though
+% their surfaces only meet along edges and in shared face planes, a box
+% resting against the side of another does not
+a = csg.polyhedron;
+a.makebox (2, 2, 2);
+b = csg.polyhedron;
+b.makebox (2, 2, 2);
+b.translate ([1, 0, 0]);
+c = csg.polyhedron;
+c.makebox (2, 1, 2);
+c.translate ([0, 1.5, 0]);
+[pairs, volumes] = csg.polyhedron.interference ({a, b, c}, 32)
+assert (isequal (pairs, [1, 2]));
+assert (abs (volumes - 4) < 1e-9);
+
+%% worker processes
+
+box = csg.polyhedron;
+box.makebox (2, 2, 2, true);
+
+A = {};
+B = {};
+for ind = 1:4
+    A{ind} = box;
+    B{ind} = csg.polyhedron;
+    B{ind}.makesphere (0.5 + 0.1*ind, true, 16, 16);
+end
+
+% the operations are run in parallel in separate processes
+results = csg.polyhedron.boolean_batch ('difference', A, B);
+cellfun (@(p) p.num_faces (), results)
+
+% single operations can also be run in a worker
+previous = csg.polyhedron.set_backend ('isolated');
+c = csg.polyhedron (box);
+c.union (B{1});
+c.num_faces ()
+csg.polyhedron.set_backend (previous);